@@ -0,0 +1,74 @@
+/*
+ * energy.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef INC_ENERGY_H_
+#define INC_ENERGY_H_
+
+#include <stdint.h>
+
+/*
+ * Energy ledger from the INA3221 channels. Each cycle integrates charge (uAh)
+ * and energy (uWh) of the harvester, the battery (in and out) and the load
+ * since the previous cycle:
+ *   - PV with the trapezoid between both readings, the panel does not depend
+ *     on the node being awake,
+ *   - load at the measured current while awake and at cfg.sleep_mA the rest,
+ *   - battery at the measured power while awake; asleep, the same minus the
+ *     load it no longer feeds and plus the PV change (no converter losses).
+ * The battery net charge drives a coulomb counter for the state of charge,
+ * started from the open-circuit voltage and pinned at the empty and full
+ * voltages. Plain C without HAL, the totals are persisted by the caller.
+ */
+
+typedef enum {
+	ENERGY_PV = 0,			// Harvested
+	ENERGY_BAT_IN,			// Into the battery
+	ENERGY_BAT_OUT,			// Out of the battery
+	ENERGY_LOAD,			// Drawn by the node
+	ENERGY_FLOWS
+} EnergyFlow_t;
+
+typedef enum {
+	ENERGY_CH_PV = 0,		// INA3221 channels
+	ENERGY_CH_BAT,			// Positive current: discharging
+	ENERGY_CH_LOAD,
+	ENERGY_CHANNELS
+} EnergyChannel_t;
+
+typedef struct {
+	float bus_V[ENERGY_CHANNELS];
+	float current_mA[ENERGY_CHANNELS];
+} EnergyReading_t;
+
+typedef struct {
+	float capacity_mAh;			// Usable charge between empty_mV and full_mV
+	float sleep_mA;				// Node current between cycles
+	float charge_eff;			// Fraction of the charge into the battery that can be taken back
+	uint16_t empty_mV;			// State of charge 0 % (AEM10941 Vovdis)
+	uint16_t full_mV;			// State of charge 100 % (AEM10941 Vovch)
+	uint32_t max_gap_s;			// Longer gaps between readings are not integrated (reset, lost cycles)
+} EnergyConfig_t;
+
+typedef struct {
+	EnergyConfig_t cfg;
+	double uAh[ENERGY_FLOWS];	// Totals since the ledger was created
+	double uWh[ENERGY_FLOWS];
+	double soc_uAh;				// Charge left above empty_mV
+	uint8_t soc_known;			// soc_uAh set (restored or from the voltage)
+	uint8_t primed;				// Previous reading valid
+	uint32_t last_t;
+	EnergyReading_t last;
+} EnergyLedger_t;
+
+extern const EnergyConfig_t ENERGY_DefaultConfig;
+
+void ENERGY_Init(EnergyLedger_t *ledger, const EnergyConfig_t *cfg);
+void ENERGY_Restore(EnergyLedger_t *ledger, const uint32_t uAh[ENERGY_FLOWS], const uint32_t uWh[ENERGY_FLOWS], uint32_t soc_uAh);
+void ENERGY_Update(EnergyLedger_t *ledger, uint32_t now, const EnergyReading_t *reading, uint32_t awake_ms);
+float ENERGY_SoC(const EnergyLedger_t *ledger);
+
+#endif /* INC_ENERGY_H_ */
@@ -0,0 +1,47 @@
+/*
+ * evtq.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef INC_EVTQ_H_
+#define INC_EVTQ_H_
+
+#include "stm32wbxx_hal.h"
+
+/*
+ * Single-producer/single-consumer event ring from the interrupts to the main
+ * loop. Producers are the callbacks of interrupts that share one preemption
+ * priority (EXTI0..4 and RTC_WKUP run at 0), so they never nest and act as a
+ * single producer; the main loop is the only consumer. No interrupt masking:
+ * the producer only writes head, the consumer only writes tail.
+ */
+
+#define EVTQ_SIZE		16		// Power of two, <= 128
+
+typedef enum {
+	EVTQ_RTC_WAKE = 0,		// RTC wake-up timer
+	EVTQ_EXTI				// GPIO edge: arg = GPIO_Pin, data = port input levels
+} EvtqType_t;
+
+/*
+ * Only the tick is latched in the interrupt: reading any RTC calendar register
+ * there would freeze TR/DR and could tear a GetTime/GetDate pair in the main
+ * loop. The consumer rebuilds wall time from one RTC read and the ticks elapsed.
+ */
+typedef struct {
+	uint8_t type;			// 1 byte (EvtqType_t)
+	uint8_t reserved;		// 1 byte
+	uint16_t arg;			// 2 bytes
+	uint16_t data;			// 2 bytes
+	uint16_t reserved2;		// 2 bytes
+	uint32_t tick;			// 4 bytes (HAL_GetTick)
+} EvtqEvent_t; // 12 bytes aligned
+
+uint8_t EVTQ_Push(EvtqType_t type, uint16_t arg, uint16_t data);
+uint8_t EVTQ_Pop(EvtqEvent_t *evt);
+uint8_t EVTQ_IsEmpty(void);
+uint32_t EVTQ_Dropped(void);
+
+#endif /* INC_EVTQ_H_ */
@@ -0,0 +1,24 @@
+/*
+ * lpdelay.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef INC_LPDELAY_H_
+#define INC_LPDELAY_H_
+
+#include "stm32wbxx_hal.h"
+
+#define LPDELAY_STOP2_MIN_MS	20		// Waits from this length park the core in STOP2
+#define LPDELAY_LPTIM_HZ		1024	// LSE (32768 Hz) / 32
+#define LPDELAY_MAX_TICKS		0xFFFF	// 16-bit LPTIM1 autoreload (~64 s)
+
+void LPDelay_Init(void);
+
+void LPDelay_Ms(uint32_t ms);
+void LPDelay_Until(uint32_t deadline_ms);
+
+void LPDelay_IRQHandler(void);
+
+#endif /* INC_LPDELAY_H_ */
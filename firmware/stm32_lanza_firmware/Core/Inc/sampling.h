@@ -0,0 +1,51 @@
+/*
+ * sampling.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef INC_SAMPLING_H_
+#define INC_SAMPLING_H_
+
+#include <stdint.h>
+
+/*
+ * Wake period policy. Every cycle the battery voltage picks an energy level
+ * (with hysteresis), the irradiance trend moves it one level up or down and
+ * the AEM10941 status pins can force the longest period. Each level has its
+ * own period. Plain C without HAL so the host simulation runs the same code.
+ */
+
+#define SAMPLING_LEVELS			5		// Level 0: surplus (shortest period) ... last: scarce
+
+// AEM10941 STATUS[2:0] as read from S0..S2
+#define SAMPLING_AEM_LDO_READY	0x01	// STATUS[0]: battery above Vchrdy, LDOs enabled
+#define SAMPLING_AEM_BATT_LOW	0x02	// STATUS[1]: battery below Vovdis, shutdown is near
+#define SAMPLING_AEM_MPP_EVAL	0x04	// STATUS[2]: MPP evaluation in progress (not an energy input)
+
+typedef struct {
+	uint16_t battery_mV[SAMPLING_LEVELS - 1];	// Descending: below battery_mV[i] the level is at least i+1
+	uint16_t hysteresis_mV;		// Extra voltage needed to go back to a better level
+	uint16_t period_s[SAMPLING_LEVELS];			// Wake period of each level (1..65535 s)
+	float surplus_Wm2;			// Irradiance at or above this with a non-falling trend: one level better
+	float dark_Wm2;				// Irradiance below this with a non-rising trend: one level worse
+	float trend_alpha;			// Slow irradiance average coefficient (0..1), the fast one uses twice this
+} SamplingConfig_t;
+
+typedef struct {
+	SamplingConfig_t cfg;
+	uint8_t level;				// Battery level after hysteresis
+	uint8_t effective;			// Level used for the period (battery, trend and AEM)
+	uint8_t primed;				// Irradiance averages initialized
+	float irr_fast;
+	float irr_slow;
+	uint16_t period_s;			// Current wake period
+} SamplingPolicy_t;
+
+extern const SamplingConfig_t SAMPLING_DefaultConfig;
+
+void SAMPLING_Init(SamplingPolicy_t *policy, const SamplingConfig_t *cfg);
+uint16_t SAMPLING_Update(SamplingPolicy_t *policy, uint16_t battery_mV, float irradiance_Wm2, uint8_t aem);
+
+#endif /* INC_SAMPLING_H_ */
@@ -0,0 +1,71 @@
+/*
+ * sched.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef INC_SCHED_H_
+#define INC_SCHED_H_
+
+#include <stdint.h>
+
+/*
+ * Energy-aware scheduler for deferrable jobs. A day-shaped irradiance profile
+ * (SCHED_BINS bins over cfg.day_s, one moving average per bin) is learned
+ * from the irradiance of every cycle and scaled by how today compares with
+ * it. A pending job runs:
+ *   - in a surplus window: net harvest now is positive and close to the best
+ *     forecast within the horizon,
+ *   - when the forecast surplus within the horizon can't pay for it and the
+ *     battery is comfortable (waiting would not help),
+ *   - at its deadline, unless the battery is below the floor.
+ * Plain C without HAL so the host replay runs the same code.
+ */
+
+#define SCHED_BINS			24		// Profile bins per day (hourly on the target)
+#define SCHED_MAX_JOBS		8
+
+typedef struct {
+	uint32_t day_s;				// Profile period (86400 s)
+	float harvest_mW_per_Wm2;	// Harvested power per W/m2 measured by the TSL2591
+	float load_mW;				// Average consumption without the jobs
+	uint8_t horizon_bins;		// Forecast horizon
+	float window_frac;			// Net power now >= this fraction of the best forecast: surplus window
+	float profile_alpha;		// Weight of the last day in each bin (0..1)
+	uint16_t floor_mV;			// No job below this battery voltage, not even at its deadline
+	uint16_t comfort_mV;		// Above this, jobs with no surplus ahead run without waiting
+} SchedConfig_t;
+
+typedef struct {
+	uint32_t cost_mJ;			// Energy of one run
+	uint32_t max_delay_s;		// Deadline after the request
+	uint32_t requested;			// Time of the pending request
+	uint8_t pending;
+} SchedJob_t;
+
+typedef struct {
+	SchedConfig_t cfg;
+	float profile[SCHED_BINS];	// Mean irradiance of each bin (W/m2)
+	uint32_t known;				// Bit per bin with a learned value
+	int16_t bin;				// Bin being accumulated (-1: none)
+	uint32_t bin_day;			// Day of that bin
+	float bin_sum;
+	uint16_t bin_n;
+	SchedJob_t job[SCHED_MAX_JOBS];
+	uint8_t jobs;
+} Scheduler_t;
+
+_Static_assert(SCHED_BINS <= 32, "Scheduler_t.known holds one bit per bin");
+
+extern const SchedConfig_t SCHED_DefaultConfig;
+
+void SCHED_Init(Scheduler_t *sched, const SchedConfig_t *cfg);
+uint8_t SCHED_AddJob(Scheduler_t *sched, uint32_t cost_mJ, uint32_t max_delay_s);
+void SCHED_Request(Scheduler_t *sched, uint8_t id, uint32_t now);
+
+void SCHED_AddSample(Scheduler_t *sched, uint32_t now, float irradiance_Wm2);
+float SCHED_Forecast_mWh(const Scheduler_t *sched, uint32_t now, uint8_t bins);
+uint32_t SCHED_Due(Scheduler_t *sched, uint32_t now, float irradiance_Wm2, uint16_t battery_mV);
+
+#endif /* INC_SCHED_H_ */
@@ -6,6 +6,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "app.h"
 #include "main.h"
@@ -16,9 +17,46 @@
 #include "DS18B20.h"
 #include "SEN0308.h"
 #include "fram.h"
+#include "lpdelay.h"
+#include "evtq.h"
+#include "sampling.h"
+#include "sched.h"
+#include "energy.h"
 
 //#define DDEBUG
 //#define PRINT_CSV
+#define OVERLAPPED_ACQUISITION
+#define ADAPTIVE_SAMPLING			// Wake period from battery, irradiance and AEM status (sampling.c)
+#define FIXED_PERIOD_S		2		// Wake period without ADAPTIVE_SAMPLING
+#define INA_TRIGGERED				// Single-shot INA3221 conversions, powered down between cycles
+#define ENERGY_SCHEDULER			// Deferrable jobs wait for forecast surplus windows (sched.c)
+#define SEN_OVERSAMPLED				// Soil moisture from one hardware-oversampled ADC burst through DMA
+#define SEN_OVS_RATIO		SEN0308_OVS_RATIO
+//#define FRAM_RESET_ON_BOOT
+#define FRAM_STAGE_BATCH	4		// Samples kept in RAM per FRAM write (0: write every sample)
+
+// INA3221 shunt noise target: a fraction of the last battery shunt voltage, within these limits
+#define INA_NOISE_REL		0.01f
+#define INA_NOISE_MIN_UV	5.0f	// 64 averages at 1.1 ms, the fixed setting of the field tests
+#define INA_NOISE_MAX_UV	40.0f	// One LSB
+
+// INA3221 alert limits (CH1 PV, CH2 battery, CH3 load): critical on each conversion, warning on the average
+#define INA_BAT_CRITICAL_MA		150.0f
+#define INA_BAT_WARNING_MA		40.0f	// ~3x the current of the awake board
+#define INA_LOAD_CRITICAL_MA	200.0f
+#define INA_LOAD_WARNING_MA		50.0f
+#define INA_PV_UPPER_V			1.1f	// Power-valid follows the panel: every rail above this by day...
+#define INA_PV_LOWER_V			0.9f	// ...and the panel below this at dusk
+#define INA_WATCH_MAX_LEVEL		1		// Sampling levels that keep the limits watched between cycles
+
+// Deferrable jobs: estimated energy per run and deadline after the request
+#define JOB_DUMP_MJ			400		// Whole ring over the UART, ~10 s awake
+#define JOB_DUMP_DELAY_S	(12 * 3600)
+#define JOB_SCRUB_MJ		60		// Read and CRC check of every sample
+#define JOB_SCRUB_DELAY_S	(24 * 3600)
+#define JOB_CAPTURE_MJ		30		// INA_CAPTURE_SAMPLES unaveraged conversions
+#define JOB_CAPTURE_DELAY_S	3600
+#define INA_CAPTURE_SAMPLES	128
 
 extern ADC_HandleTypeDef hadc1;
 extern I2C_HandleTypeDef hi2c3;
@@ -28,35 +66,90 @@ extern UART_HandleTypeDef huart1;
 
 void SystemClock_Config();
 void ADC1_Init();
+void ADC1_ClockResume();
 
 static void RTC_Wakeup_Config(uint16_t time_s);
 static void EnterStop2();
+static void PVD_Config();
 
 void InitFRAM();
+void LoadConfig();
 void InitINA3221();
+HAL_StatusTypeDef ConfigureINAAlerts();
 void InitTSL2591();
 void InitSHT3X();
 void InitDFR0198();
 void InitSEN0308();
 
+void SensorsPowerOff();
+void SensorsPowerOn();
+void ConfigureSensors();
+
+void StartSensors();
+void WaitSensors();
+
 void ReadRTC();
 void ReadINA3221();
+void IdleINA3221();
 void ReadTSL2591();
 void ReadSHT3X();
 void ReadDFR0198();
 void ReadSEN0308();
+uint8_t ReadAEMStatus();
+
+void UpdatePeriod();
+void UpdateEnergy();
+void SetSurvival(uint8_t on);
+void RunJobs();
+
+void ScrubFRAM();
+void CaptureINA3221();
 
 void DumpFRAM();
+void BenchmarkCRC();
+void DumpTiers(FramTierId_t tier);
+void ExportFRAM(const char *consumer, uint16_t max);
+void AckFRAM(const char *consumer, uint32_t seq);
+void DumpRange(uint32_t from, uint32_t to);
+void DumpEvents();
+
+uint32_t RTC_Epoch();
+uint64_t RTC_EpochMs(uint32_t *tick);
+uint32_t RTC_ToEpoch(const RTC_TimeTypeDef *t, const RTC_DateTypeDef *d);
+void LogEvent(FramEventCode_t code, uint32_t arg);
+void LogEventAt(FramEventCode_t code, uint32_t timestamp, uint32_t arg);
+void LogResetCause();
+void DrainEvents();
 
 void I2C_bus_scan();
 
 uint16_t cycle = 0;
 
-volatile uint8_t g_wakeRTC = 1;
-volatile uint8_t g_wakeEXTI = 0;
-volatile uint16_t g_extiPin = 0;
+uint8_t cyclePending = 1;		// Set by RTC wake-up events, the first cycle runs at boot
+uint32_t eventsDropped = 0;		// EVTQ_Dropped() already logged to FRAM
+volatile uint8_t g_pvdLow = 0;
+
+SamplingPolicy_t sampling;
+SamplingConfig_t samplingConfig;	// Kept in FRAM_KEY_CONFIG with the critical alert limits
+float batCritical_mA = INA_BAT_CRITICAL_MA;
+float loadCritical_mA = INA_LOAD_CRITICAL_MA;
+uint16_t wakePeriod_s;			// Period programmed in the RTC wake-up timer
+uint8_t survival = 0;			// INA3221 critical alert: longest period, no deferred jobs, no FRAM batching
+
+EnergyLedger_t energy;
+EnergyReading_t inaReading;		// Last INA3221 channels (PV, battery, load)
+uint8_t inaValid = 0;
+uint32_t cycleStart_ms;
+uint32_t awake_ms = 0;			// Length of the previous cycle
+uint32_t energyDay = 0;			// Day (since the epoch) of the daily balance being accumulated
+double dayPv_uWh, dayLoad_uWh;	// Ledger totals at the start of that day
+
+Scheduler_t sched;
+uint8_t jobDump, jobScrub, jobCapture;
+uint8_t jobDay = 0;				// Day of the last daily requests
 
 MB85RS256B_t fram;
+FramDev_t framDev;
 FramRing_t mem;
 
 INA3221_t ina;
@@ -66,6 +159,7 @@ DS18B20_t dfr;
 SEN0308_t sen;
 
 float irradiance_Wm2;
+float inaNoise_uV = INA_NOISE_MIN_UV;
 
 float airTemp_C;
 float soilTemp_C;
@@ -78,10 +172,65 @@ uint16_t batteryVoltage_mV;
 RTC_TimeTypeDef time;
 RTC_DateTypeDef date;
 
+// Power domain state of each sensor across STOP2
+typedef struct {
+	uint8_t gated;			// Supplied from VDD_SENS, switched by GATE_SENS
+	uint8_t configured;		// Device registers hold the requested configuration
+	uint16_t settle_ms;		// Power-up time before the first access (datasheet)
+} PowerDomain_t;
+
+PowerDomain_t inaDomain = { .gated = 0, .settle_ms = INA3221_POWERUP_MS };
+PowerDomain_t tslDomain = { .gated = 1, .settle_ms = TSL2591_POWERUP_MS };
+PowerDomain_t shtDomain = { .gated = 1, .settle_ms = SHT3X_POWERUP_MS };
+PowerDomain_t dfrDomain = { .gated = 1, .settle_ms = DS18B20_POWERUP_MS };
+PowerDomain_t senDomain = { .gated = 1, .settle_ms = SEN0308_POWERUP_MS };
+
+uint8_t sensorsPowered = 1;
+uint32_t sensorsOn_ms;
+
+uint32_t convStart_ms;
+uint32_t convWait_ms;
+uint8_t tslStarted, shtStarted, dfrStarted;
+
 // INTERRUPTIONS ------------------------------------------------------------
 
 void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *hrtc) {
-	g_wakeRTC = 1;
+	EVTQ_Push(EVTQ_RTC_WAKE, 0, 0);
+}
+
+// Supply collapsing: the next samples are written immediately, the staged ones are flushed by DrainEvents()
+void HAL_PWR_PVDCallback(void) {
+	if (__HAL_PWR_GET_FLAG(PWR_FLAG_PVDO)) {
+		mem.stage_batch = 0;
+
+		// The FRAM is only accessed from the main loop
+		g_pvdLow = 1;
+	}
+	else if (!survival) mem.stage_batch = FRAM_STAGE_BATCH;
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == fram.hspi) MB85RS256B_DMACallback(&fram, HAL_OK);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == fram.hspi) MB85RS256B_DMACallback(&fram, HAL_OK);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == fram.hspi) MB85RS256B_DMACallback(&fram, HAL_OK);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == fram.hspi) MB85RS256B_DMACallback(&fram, HAL_ERROR);
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+	if (hadc == sen.hadc) SEN0308_DMACallback(&sen, HAL_OK);
+}
+
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc) {
+	if (hadc == sen.hadc) SEN0308_DMACallback(&sen, HAL_ERROR);
 }
 
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
@@ -91,8 +240,8 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
 		case WAR_INA_Pin:
 		case S0_AEM_Pin:
 		case S1_AEM_Pin:
-			g_wakeEXTI = 1;
-			g_extiPin = GPIO_Pin;
+			// INA and AEM lines share GPIOA: levels latched with the edge, a burst keeps every state
+			EVTQ_Push(EVTQ_EXTI, GPIO_Pin, (uint16_t)S0_AEM_GPIO_Port->IDR);
 			break;
 	}
 }
@@ -113,8 +262,43 @@ void setup() {
 
 	if (HAL_RTC_SetDate(&hrtc, &date, RTC_FORMAT_BIN) != HAL_OK) Error_Handler();
 
+	LPDelay_Init();
+
 	InitFRAM();
+#ifdef DDEBUG
+	BenchmarkCRC();
+#endif
+#ifdef FRAM_RESET_ON_BOOT
 	FRAM_Reset(&mem);
+#endif
+	LogResetCause();
+	PVD_Config();
+
+	// The ledger outlives resets; the first reading after boot only primes it
+	EnergyValue_t ev;
+	ChargeValue_t cv;
+	EnergyDayValue_t dv;
+	uint8_t valid = 0;
+
+	ENERGY_Init(&energy, NULL);
+	if (FRAM_ReadEnergy(&mem, &ev, &cv, &valid) == HAL_OK && valid) {
+		uint32_t uAh[ENERGY_FLOWS] = { cv.pv_uAh, cv.bat_in_uAh, cv.bat_out_uAh, cv.load_uAh };
+		uint32_t uWh[ENERGY_FLOWS] = { ev.pv_uWh, ev.bat_in_uWh, ev.bat_out_uWh, ev.load_uWh };
+
+		ENERGY_Restore(&energy, uAh, uWh, ev.soc_uAh);
+
+		// So is the daily balance: without its start, the day of the last save from here on
+		energyDay = ev.timestamp / 86400;
+		dayPv_uWh = ev.pv_uWh;
+		dayLoad_uWh = ev.load_uWh;
+
+		if (FRAM_ReadEnergyDay(&mem, &dv, &valid) == HAL_OK && valid && dv.day == energyDay) {
+			dayPv_uWh = dv.pv_uWh;
+			dayLoad_uWh = dv.load_uWh;
+		}
+	}
+
+	LoadConfig();
 
 	InitINA3221();
 	InitTSL2591();
@@ -122,21 +306,42 @@ void setup() {
 	InitDFR0198();
 	InitSEN0308();
 
-	RTC_Wakeup_Config(2);
+	SAMPLING_Init(&sampling, &samplingConfig);
+#ifdef ADAPTIVE_SAMPLING
+	wakePeriod_s = sampling.period_s;
+#else
+	wakePeriod_s = FIXED_PERIOD_S;
+#endif
+	RTC_Wakeup_Config(wakePeriod_s);
+
+	SCHED_Init(&sched, NULL);
+	jobDump = SCHED_AddJob(&sched, JOB_DUMP_MJ, JOB_DUMP_DELAY_S);
+	jobScrub = SCHED_AddJob(&sched, JOB_SCRUB_MJ, JOB_SCRUB_DELAY_S);
+	jobCapture = SCHED_AddJob(&sched, JOB_CAPTURE_MJ, JOB_CAPTURE_DELAY_S);
 
-	HAL_Delay(500);
+	LPDelay_Ms(500);
 }
 
 void loop() {
-	if (g_wakeRTC) {
-		g_wakeRTC = 0;
+	DrainEvents();
+
+	if (cyclePending) {
+		cyclePending = 0;
+		cycleStart_ms = HAL_GetTick();
+
+#ifdef OVERLAPPED_ACQUISITION
+		StartSensors();
+#endif
 
 		ReadRTC();
+		ReadSEN0308();
+
+		WaitSensors();
+
 		ReadINA3221();
 		ReadTSL2591();
 		ReadSHT3X();
 		ReadDFR0198();
-		ReadSEN0308();
 
 		DataSample_t data = {
 			.irradiance_Wm2 = irradiance_Wm2,
@@ -153,23 +358,10 @@ void loop() {
 			.year = date.Year
 		};
 
-		/*FRAM_SaveData(&mem, &data);
-
-		DataSample_t rx = {0};
-		uint16_t slot = mem.write_idx-1;
-		uint8_t valid = 0;
-
-		FRAM_GetSlot(&mem, slot, &rx, &valid);
-
-		if (valid) {
-			printf("FRAM Slot: %u\r\n", slot);
-			printf("%02d/%02d/20%02d %02d:%02d:%02d\r\n", rx.day, rx.month, rx.year, rx.hours, rx.minutes, rx.seconds);
-			printf("Battery: %.3f V\r\n", rx.batteryVoltage_mV/1000.0);
-			printf("Irradiance: %.3f W/m2\r\n", rx.irradiance_Wm2);
-			printf("Air: %.3f ºC, %u %%\r\n", rx.airTemp_C, rx.airHumidity_perc);
-			printf("Soil: %.3f ºC, %u %%\r\n", rx.soilTemp_C, rx.soilMoisture_perc);
+		if (FRAM_SaveData(&mem, &data) != HAL_OK) {
+			printf("Error while saving sample to FRAM\r\n");
+			LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_FRAM);
 		}
-		else printf("Slot %u not valid\r\n", slot);*/
 
 		printf("Cycle: %u\r\n", cycle++);
 		printf("%02d/%02d/20%02d %02d:%02d:%02d\r\n", date.Date, date.Month, date.Year, time.Hours, time.Minutes, time.Seconds);
@@ -178,6 +370,16 @@ void loop() {
 		printf("Air: %.3f ºC, %u %%\r\n", airTemp_C, airHumidity_perc);
 		printf("Soil: %.3f ºC, %u %%\r\n", soilTemp_C, soilMoisture_perc);
 		printf("\r\n");
+
+		UpdateEnergy();
+
+#ifdef ADAPTIVE_SAMPLING
+		UpdatePeriod();
+#endif
+
+		RunJobs();
+
+		awake_ms = HAL_GetTick() - cycleStart_ms;
 	}
 
 	EnterStop2();
@@ -193,30 +395,233 @@ static void RTC_Wakeup_Config(uint16_t time_s) {
   if (HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, time_s - 1, RTC_WAKEUPCLOCK_CK_SPRE_16BITS) != HAL_OK) Error_Handler();
 }
 
+// Reprograms the wake-up timer only when the policy changes the period, the phase is kept otherwise
+void UpdatePeriod() {
+	uint16_t period_s = SAMPLING_Update(&sampling, batteryVoltage_mV, irradiance_Wm2, ReadAEMStatus());
+	uint8_t level = sampling.effective;
+
+	// Survival mode keeps the longest period until the INA3221 alerts clear
+	if (survival) {
+		level = SAMPLING_LEVELS - 1;
+		period_s = sampling.cfg.period_s[level] ? sampling.cfg.period_s[level] : 1;
+	}
+
+	if (period_s == wakePeriod_s) return;
+	wakePeriod_s = period_s;
+
+	RTC_Wakeup_Config(period_s);
+	LogEvent(FRAM_EVENT_PERIOD, period_s | ((uint32_t)level << 16));
+	printf("Period: %u s (level %u)\r\n\r\n", period_s, level);
+}
+
+// Integrates the INA3221 channels since the last cycle, keeps the totals in FRAM and logs each day's balance
+void UpdateEnergy() {
+	if (!inaValid) return;
+
+	uint32_t now = RTC_ToEpoch(&time, &date);
+	ENERGY_Update(&energy, now, &inaReading, awake_ms);
+
+	if (now / 86400 != energyDay) {
+		if (energyDay) {
+			double pv_mWh = (energy.uWh[ENERGY_PV] - dayPv_uWh) / 1000.0;
+			double load_mWh = (energy.uWh[ENERGY_LOAD] - dayLoad_uWh) / 1000.0;
+
+			LogEvent(FRAM_EVENT_ENERGY, (pv_mWh > 0xFFFF ? 0xFFFF : (uint32_t)pv_mWh) |
+										((load_mWh > 0xFFFF ? 0xFFFF : (uint32_t)load_mWh) << 16));
+		}
+
+		energyDay = now / 86400;
+		dayPv_uWh = energy.uWh[ENERGY_PV];
+		dayLoad_uWh = energy.uWh[ENERGY_LOAD];
+
+		EnergyDayValue_t dv = {
+			.day = energyDay,
+			.pv_uWh = (uint32_t)dayPv_uWh,
+			.load_uWh = (uint32_t)dayLoad_uWh
+		};
+
+		if (FRAM_WriteEnergyDay(&mem, &dv) != HAL_OK) printf("Error while saving energy ledger\r\n");
+	}
+
+	EnergyValue_t ev = {
+		.pv_uWh = (uint32_t)energy.uWh[ENERGY_PV],
+		.bat_in_uWh = (uint32_t)energy.uWh[ENERGY_BAT_IN],
+		.bat_out_uWh = (uint32_t)energy.uWh[ENERGY_BAT_OUT],
+		.load_uWh = (uint32_t)energy.uWh[ENERGY_LOAD],
+		.soc_uAh = (uint32_t)energy.soc_uAh,
+		.timestamp = now
+	};
+	ChargeValue_t cv = {
+		.pv_uAh = (uint32_t)energy.uAh[ENERGY_PV],
+		.bat_in_uAh = (uint32_t)energy.uAh[ENERGY_BAT_IN],
+		.bat_out_uAh = (uint32_t)energy.uAh[ENERGY_BAT_OUT],
+		.load_uAh = (uint32_t)energy.uAh[ENERGY_LOAD]
+	};
+
+	if (FRAM_WriteEnergy(&mem, &ev, &cv) != HAL_OK) printf("Error while saving energy ledger\r\n");
+
+	printf("Energy today: PV %.2f mWh, load %.2f mWh\r\n", (energy.uWh[ENERGY_PV] - dayPv_uWh) / 1000.0,
+		   (energy.uWh[ENERGY_LOAD] - dayLoad_uWh) / 1000.0);
+	printf("Battery: %.0f %% (%.1f mAh)\r\n\r\n", ENERGY_SoC(&energy), energy.soc_uAh / 1000.0);
+}
+
+// Entered on a critical alert: what is staged goes to FRAM and the node only samples until it clears
+void SetSurvival(uint8_t on) {
+	if (survival == on) return;
+	survival = on;
+
+	if (on) {
+		mem.stage_batch = 0;
+		FRAM_Flush(&mem);
+	}
+	else if (!__HAL_PWR_GET_FLAG(PWR_FLAG_PVDO)) mem.stage_batch = FRAM_STAGE_BATCH;
+
+	LogEvent(FRAM_EVENT_SURVIVAL, on | ((uint32_t)batteryVoltage_mV << 16));
+	printf("Survival mode: %s\r\n\r\n", on ? "on" : "off");
+}
+
+// Feeds the irradiance profile and runs the deferred jobs that are due this cycle
+void RunJobs() {
+	uint32_t now = RTC_ToEpoch(&time, &date);
+	uint32_t due = 0;
+
+	// Daily maintenance, requested on the first cycle of each day
+	if (date.Date != jobDay) {
+		jobDay = date.Date;
+		SCHED_Request(&sched, jobDump, now);
+		SCHED_Request(&sched, jobScrub, now);
+	}
+
+	SCHED_AddSample(&sched, now, irradiance_Wm2);
+
+	// Requests stay pending through survival mode
+	if (!survival) {
+#ifdef ENERGY_SCHEDULER
+		due = SCHED_Due(&sched, now, irradiance_Wm2, batteryVoltage_mV);
+#else
+		for (uint8_t i = 0; i < sched.jobs; ++i) {
+			if (sched.job[i].pending) {
+				sched.job[i].pending = 0;
+				due |= 1UL << i;
+			}
+		}
+#endif
+	}
+
+	for (uint8_t i = 0; i < sched.jobs; ++i) {
+		if (!(due & (1UL << i))) continue;
+
+		if (i == jobDump) DumpFRAM();
+		else if (i == jobScrub) ScrubFRAM();
+		else if (i == jobCapture) CaptureINA3221();
+
+		uint32_t wait_min = (now - sched.job[i].requested) / 60;
+		LogEvent(FRAM_EVENT_JOB, i | ((wait_min > 0xFFFF ? 0xFFFF : wait_min) << 16));
+	}
+}
+
 static void EnterStop2() {
-	HAL_GPIO_WritePin(GATE_SENS_GPIO_Port, GATE_SENS_Pin, GPIO_PIN_SET);
+	SensorsPowerOff();
 	HAL_GPIO_WritePin(USER_LED_GPIO_Port, USER_LED_Pin, GPIO_PIN_RESET);
 
 	__HAL_PWR_CLEAR_FLAG(PWR_FLAG_WU);
 	HAL_SuspendTick();
 
-	HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
+	// An event queued (or a supply drop) after DrainEvents() skips STOP2; with PRIMASK set a new one still ends the WFI
+	__disable_irq();
+	if (EVTQ_IsEmpty() && !g_pvdLow) HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
+	__enable_irq();
 
 	HAL_ResumeTick();
 	SystemClock_Config();
+	ADC1_ClockResume();
 
-	ADC1_Init();
+	// ADC registers are retained in STOP2, only re-init if the regulator was lost
+	if (!LL_ADC_IsInternalRegulatorEnabled(hadc1.Instance)) ADC1_Init();
 
-	HAL_GPIO_WritePin(GATE_SENS_GPIO_Port, GATE_SENS_Pin, GPIO_PIN_RESET);
+	SensorsPowerOn();
 	HAL_GPIO_WritePin(USER_LED_GPIO_Port, USER_LED_Pin, GPIO_PIN_SET);
 
-	InitINA3221();
-	InitTSL2591();
-	InitSHT3X();
-	InitDFR0198();
-	InitSEN0308();
+	ConfigureSensors();
+}
+
+// Supply monitor: interrupt on both edges, wakes the core from STOP2 (EXTI line 16)
+static void PVD_Config() {
+	PWR_PVDTypeDef pvd = {
+		.PVDLevel = PWR_PVDLEVEL_6,		// ~2.9 V
+		.Mode = PWR_PVD_MODE_IT_RISING_FALLING
+	};
+
+	HAL_PWR_ConfigPVD(&pvd);
+	HAL_PWR_EnablePVD();
+
+	// Only raises g_pvdLow for DrainEvents(), so it yields to the wake-up, DMA and LPTIM interrupts
+	HAL_NVIC_SetPriority(PVD_PVM_IRQn, 1, 0);
+	HAL_NVIC_EnableIRQ(PVD_PVM_IRQn);
+}
+
+// SENSOR POWER -------------------------------------------------------------
+
+static void PowerLost(PowerDomain_t *domain) {
+	if (domain->gated) domain->configured = 0;
+}
+
+static void SettleDomain(PowerDomain_t *domain) {
+	// Waits the datasheet power-up time since VDD_SENS was switched on
+	if (domain->gated) LPDelay_Until(sensorsOn_ms + domain->settle_ms);
+}
+
+void SensorsPowerOff() {
+	HAL_GPIO_WritePin(GATE_SENS_GPIO_Port, GATE_SENS_Pin, GPIO_PIN_SET);
+
+	if (!sensorsPowered) return;
+	sensorsPowered = 0;
+
+	// Gated devices come back with their reset values
+	PowerLost(&inaDomain);
+	PowerLost(&tslDomain);
+	PowerLost(&shtDomain);
+	PowerLost(&dfrDomain);
+	PowerLost(&senDomain);
+
+	if (inaDomain.gated) INA3221_PowerLost(&ina);
+	if (tslDomain.gated) TSL2591_PowerLost(&tsl);
+	if (shtDomain.gated) SHT3X_PowerLost(&sht);
+	if (dfrDomain.gated) DS18B20_PowerLost(&dfr);
+}
+
+void SensorsPowerOn() {
+	HAL_GPIO_WritePin(GATE_SENS_GPIO_Port, GATE_SENS_Pin, GPIO_PIN_RESET);
+
+	if (sensorsPowered) return;
+	sensorsPowered = 1;
+	sensorsOn_ms = HAL_GetTick();
+}
+
+void ConfigureSensors() {
+	// Only power-cycled devices are touched, and only the registers that differ
+	if (!inaDomain.configured) {
+		SettleDomain(&inaDomain);
+		inaDomain.configured = (INA3221_Configure(&ina) == HAL_OK && ConfigureINAAlerts() == HAL_OK);
+	}
+
+	if (!tslDomain.configured) {
+		SettleDomain(&tslDomain);
+		tslDomain.configured = (TSL2591_Configure(&tsl) == HAL_OK);
+	}
+
+	if (!shtDomain.configured) {
+		SettleDomain(&shtDomain);
+		shtDomain.configured = (SHT3X_Configure(&sht, SHT3X_HEATER_OFF) == HAL_OK);
+	}
+
+	if (!dfrDomain.configured) {
+		SettleDomain(&dfrDomain);
+		dfrDomain.configured = (DS18B20_Configure(&dfr) == HAL_OK);
+	}
 
-	HAL_Delay(500);
+	// Analog output: nothing to configure, the settle time is waited before reading
+	senDomain.configured = 1;
 }
 
 // INIT ---------------------------------------------------------------------
@@ -225,13 +630,59 @@ void InitFRAM() {
 	fram.hspi = &hspi2;
 	fram.cs_port = CS_FRAM_GPIO_Port;
 	fram.cs_pin = CS_FRAM_Pin;
+	fram.transport = MB85RS256B_XFER_AUTO;
 
-	mem.fram = &fram;
+	FRAM_DevMB85RS256B(&framDev, &fram);
+
+	mem.dev = &framDev;
+	mem.layout = FRAM_LAYOUT_SEQ;
+	mem.format = FRAM_FORMAT_BLOCK;
+	mem.tiers = 1;
+	mem.stage_batch = FRAM_STAGE_BATCH;
 
 	if (FRAM_Init(&mem) == HAL_OK);// printf("FRAM inicializada correctamente\r\n");
 	else printf("FRAM no inicializada\r\n");
 }
 
+_Static_assert(sizeof(((ConfigValue_t *)0)->battery_mV) == sizeof(SAMPLING_DefaultConfig.battery_mV), "ConfigValue_t.battery_mV does not match the sampling levels");
+_Static_assert(sizeof(((ConfigValue_t *)0)->period_s) == sizeof(SAMPLING_DefaultConfig.period_s), "ConfigValue_t.period_s does not match the sampling levels");
+
+// Sampling levels and critical alert limits: the FRAM copy wins, a FRAM without one gets the compiled defaults
+void LoadConfig() {
+	ConfigValue_t cv;
+	uint8_t valid = 0;
+
+	samplingConfig = SAMPLING_DefaultConfig;
+
+	HAL_StatusTypeDef status = FRAM_ReadConfig(&mem, &cv, &valid);
+	for (uint8_t i = 0; valid && i < SAMPLING_LEVELS; i++) {
+		if (cv.period_s[i] == 0) valid = 0;
+	}
+
+	if (valid) {
+		memcpy(samplingConfig.battery_mV, cv.battery_mV, sizeof(cv.battery_mV));
+		samplingConfig.hysteresis_mV = cv.hysteresis_mV;
+		memcpy(samplingConfig.period_s, cv.period_s, sizeof(cv.period_s));
+		batCritical_mA = cv.batCritical_mA;
+		loadCritical_mA = cv.loadCritical_mA;
+		return;
+	}
+
+	// A read error leaves the stored copy alone
+	if (status != HAL_OK) {
+		printf("Error while reading config\r\n");
+		return;
+	}
+
+	memcpy(cv.battery_mV, samplingConfig.battery_mV, sizeof(cv.battery_mV));
+	cv.hysteresis_mV = samplingConfig.hysteresis_mV;
+	memcpy(cv.period_s, samplingConfig.period_s, sizeof(cv.period_s));
+	cv.batCritical_mA = (uint16_t)batCritical_mA;
+	cv.loadCritical_mA = (uint16_t)loadCritical_mA;
+
+	if (FRAM_WriteConfig(&mem, &cv) != HAL_OK) printf("Error while saving config\r\n");
+}
+
 void InitINA3221() {
 	ina.hi2c = &hi2c3;
 	ina.shuntResistance[0] = 0.220f;
@@ -240,18 +691,42 @@ void InitINA3221() {
 	ina.averagingMode = INA3221_AVG_64;
 	ina.convTimeBus = INA3221_CT_1100us;
 	ina.convTimeShunt = INA3221_CT_1100us;
+#ifdef INA_TRIGGERED
+	// Bus voltage needs far less than the shunt: the averaging picked for the shunt is enough
+	ina.convTimeBus = INA3221_CT_332us;
+	ina.operatingMode = INA3221_MODE_SHUNT_BUS_TRIGGERED;
+	INA3221_SetNoiseTarget(&ina, inaNoise_uV);
+#else
 	ina.operatingMode = INA3221_MODE_SHUNT_BUS_CONTINUOUS;
+#endif
 
-	if (INA3221_Init(&ina) == HAL_OK);// printf("INA3221 inicializado correctamente\r\n");
+	inaDomain.configured = (INA3221_Init(&ina) == HAL_OK && ConfigureINAAlerts() == HAL_OK);
+	if (inaDomain.configured);// printf("INA3221 inicializado correctamente\r\n");
 	//else printf("INA3221 no inicializado\r\n");
 }
 
+// Limits are lost with the INA3221 supply, not in power-down
+HAL_StatusTypeDef ConfigureINAAlerts() {
+	HAL_StatusTypeDef status;
+
+	status = INA3221_SetCurrentLimits(&ina, 1, INA3221_LIMIT_OFF, INA3221_LIMIT_OFF);
+	if (status == HAL_OK) status = INA3221_SetCurrentLimits(&ina, 2, batCritical_mA, INA_BAT_WARNING_MA);
+	if (status == HAL_OK) status = INA3221_SetCurrentLimits(&ina, 3, loadCritical_mA, INA_LOAD_WARNING_MA);
+	if (status == HAL_OK) status = INA3221_SetPowerValid(&ina, INA_PV_UPPER_V, INA_PV_LOWER_V);
+
+	// Latched: a short overcurrent still gives a full edge on CRI/WAR
+	if (status == HAL_OK) status = INA3221_SetAlertLatch(&ina, 1);
+
+	return status;
+}
+
 void InitTSL2591() {
 	tsl.hi2c = &hi2c3;
 	tsl.gain = TSL2591_GAIN_LOW;
 	tsl.integrationTime = TSL2591_INTEGRATION_200MS;
 
-	if (TSL2591_Init(&tsl) == HAL_OK);// printf("TSL2591 inicializado correctamente\r\n");
+	tslDomain.configured = (TSL2591_Init(&tsl) == HAL_OK);
+	if (tslDomain.configured);// printf("TSL2591 inicializado correctamente\r\n");
 	//else printf("TSL2591 no inicializado\r\n");
 }
 
@@ -263,7 +738,7 @@ void InitSHT3X() {
 	if (SHT3X_Init(&sht) == HAL_OK);// printf("SHT3x inicializado correctamente\r\n");
 	//else printf("SHT3x no inicializado\r\n");
 
-	SHT3X_Heater(&sht, SHT3X_HEATER_OFF);
+	shtDomain.configured = (SHT3X_Heater(&sht, SHT3X_HEATER_OFF) == HAL_OK);
 }
 
 void InitDFR0198()  {
@@ -271,7 +746,8 @@ void InitDFR0198()  {
 	dfr.pin = DFR0198_Pin;
 	dfr.resolution = DS18B20_RES_12_BIT;
 
-	if (DS18B20_Init(&dfr) == HAL_OK);// printf("DFR0198 inicializado correctamente\r\n");
+	dfrDomain.configured = (DS18B20_Init(&dfr) == HAL_OK);
+	if (dfrDomain.configured);// printf("DFR0198 inicializado correctamente\r\n");
 	//else printf("DFR0198 no inicializado\r\n");
 }
 
@@ -281,10 +757,55 @@ void InitSEN0308() {
 	sen.pin = SEN0308_Pin;
 	sen.airRaw = 3620;
 	sen.waterRaw = 520;
-	if (SEN0308_Init(&sen) == HAL_OK);// printf("SEN0308 inicializado correctamente\r\n");
+	senDomain.configured = (SEN0308_Init(&sen) == HAL_OK);
+	if (senDomain.configured);// printf("SEN0308 inicializado correctamente\r\n");
 	//else printf("SEN0308 no inicializado\r\n");
 }
 
+// ACQUISITION ----------------------------------------------------------------
+
+void StartSensors() {
+	uint32_t t_ms;
+
+	convStart_ms = HAL_GetTick();
+	convWait_ms = 0;
+
+#ifdef INA_TRIGGERED
+	INA3221_SetNoiseTarget(&ina, inaNoise_uV);
+#endif
+
+	// Launches every conversion, the cycle waits only for the slowest one
+	if (INA3221_StartConversion(&ina) == HAL_OK) {
+		t_ms = INA3221_ConversionTime_ms(&ina);
+		if (t_ms > convWait_ms) convWait_ms = t_ms;
+	}
+
+	tslStarted = (TSL2591_StartIntegration(&tsl) == HAL_OK);
+	if (tslStarted) {
+		t_ms = TSL2591_IntegrationTime_ms(&tsl);
+		if (t_ms > convWait_ms) convWait_ms = t_ms;
+	}
+
+	shtStarted = (SHT3X_StartSingleShot(&sht) == HAL_OK);
+	if (shtStarted) {
+		t_ms = SHT3X_ConversionTime_ms(&sht);
+		if (t_ms > convWait_ms) convWait_ms = t_ms;
+	}
+
+	dfrStarted = (DS18B20_StartConversion(&dfr) == HAL_OK);
+	if (dfrStarted) {
+		t_ms = DS18B20_ConversionTime_ms(&dfr);
+		if (t_ms > convWait_ms) convWait_ms = t_ms;
+	}
+}
+
+void WaitSensors() {
+	// Core parked in STOP2 until the slowest conversion is done
+	LPDelay_Until(convStart_ms + convWait_ms);
+
+	convWait_ms = 0;
+}
+
 // READ ---------------------------------------------------------------------
 
 void ReadRTC() {
@@ -295,6 +816,7 @@ void ReadRTC() {
 	// Error while reading RTC time
 	else {
 		printf("Error while reading RTC time\r\n");
+		LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_RTC);
 	}
 
 	// Reads RTC date
@@ -304,6 +826,7 @@ void ReadRTC() {
 	// Error while reading RTC date
 	else {
 		printf("Error while reading RTC date\r\n");
+		LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_RTC);
 	}
 }
 
@@ -312,6 +835,17 @@ void ReadINA3221() {
 	float shuntVoltage_V[3];
 	float current_mA[3];
 
+#ifdef INA_TRIGGERED
+	// The conversion time is computed from nominal values, the flag confirms it
+	uint8_t ready = 0;
+	for (uint8_t tries = 0; tries < 10; ++tries) {
+		if (INA3221_IsConversionReady(&ina, &ready) != HAL_OK || ready) break;
+		HAL_Delay(1);
+	}
+#endif
+
+	inaValid = 0;
+
 	// Iterates the 3 channels
 	for (int ch = 0; ch < 3; ++ch) {
 		// Reads bus & shunt voltages
@@ -324,18 +858,72 @@ void ReadINA3221() {
 		// Error while reading the sensor
 		else {
 			printf("Error while reading INA3221\r\n\r\n");
+			LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_INA3221);
+#ifdef INA_TRIGGERED
+			INA3221_PowerDown(&ina);
+#endif
 
 			return;
 		}
 	}
 
 	batteryVoltage_mV = (uint16_t)(busVoltage_V[1] * 1000);
+
+	// CH1 PV, CH2 battery, CH3 load: the energy ledger keeps every channel
+	for (int ch = 0; ch < ENERGY_CHANNELS; ++ch) {
+		inaReading.bus_V[ch] = busVoltage_V[ch];
+		inaReading.current_mA[ch] = current_mA[ch];
+	}
+	inaValid = 1;
+
+	// Limits checked on this conversion too, not only on the EXTI lines between cycles
+	uint16_t flags;
+	if (INA3221_ReadFlags(&ina, &flags) == HAL_OK) {
+		if (flags & (INA3221_MASK_CF(2) | INA3221_MASK_CF(3))) SetSurvival(1);
+		else if (!(flags & (INA3221_MASK_WF(2) | INA3221_MASK_WF(3)))) SetSurvival(0);
+	}
+
+	IdleINA3221();
+
+#ifdef INA_TRIGGERED
+
+	// Next cycle: relative resolution on the battery current
+	float shunt_uV = shuntVoltage_V[1] * 1e6f;
+	if (shunt_uV < 0.0f) shunt_uV = -shunt_uV;
+
+	inaNoise_uV = INA_NOISE_REL * shunt_uV;
+	if (inaNoise_uV < INA_NOISE_MIN_UV) inaNoise_uV = INA_NOISE_MIN_UV;
+	if (inaNoise_uV > INA_NOISE_MAX_UV) inaNoise_uV = INA_NOISE_MAX_UV;
+#endif
+}
+
+// Between cycles: limits watched with continuous conversions (~350 uA) only with energy to spare
+void IdleINA3221() {
+#ifdef INA_TRIGGERED
+	if (!survival && sampling.effective <= INA_WATCH_MAX_LEVEL) {
+		ina.operatingMode = INA3221_MODE_SHUNT_BUS_CONTINUOUS;
+		INA3221_StartConversion(&ina);
+		ina.operatingMode = INA3221_MODE_SHUNT_BUS_TRIGGERED;
+	}
+	else INA3221_PowerDown(&ina);
+#endif
 }
 
 void ReadTSL2591() {
 	uint16_t full, ir;
 	float lux;
 
+	// Waits for the started integration cycle to complete
+	if (tslStarted) {
+		uint8_t valid = 0;
+		tslStarted = 0;
+
+		for (uint8_t tries = 0; tries < 10; ++tries) {
+			if (TSL2591_IsDataValid(&tsl, &valid) != HAL_OK || valid) break;
+			HAL_Delay(10);
+		}
+	}
+
 	// Reads total & ir
 	if (TSL2591_ReadChannels(&tsl, &full, &ir) == HAL_OK) {
 		// Calculates lux
@@ -347,6 +935,7 @@ void ReadTSL2591() {
 	// Error while reading the sensor
 	else {
 		printf("Error while reading TSL2591\r\n\r\n");
+		LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_TSL2591);
 	}
 }
 
@@ -354,8 +943,16 @@ void ReadSHT3X() {
 	float airHumidity_perc_f, dewPoint_C;
 
 	for (int8_t tries = 3; tries >= 0; --tries) {
-		// Reads air temperature & hummidity
-		if (SHT3X_ReadSingleShot(&sht, &airTemp_C, &airHumidity_perc_f) == HAL_OK) {
+		HAL_StatusTypeDef status;
+
+		// Reads air temperature & hummidity (collects the started conversion on the first try)
+		if (shtStarted) {
+			shtStarted = 0;
+			status = SHT3X_FetchSingleShot(&sht, &airTemp_C, &airHumidity_perc_f);
+		}
+		else status = SHT3X_ReadSingleShot(&sht, &airTemp_C, &airHumidity_perc_f);
+
+		if (status == HAL_OK) {
 			airHumidity_perc = (uint8_t)airHumidity_perc_f;
 			// Calculates dew point
 			dewPoint_C = SHT3X_CalculateDewpoint(airTemp_C, airHumidity_perc);
@@ -363,6 +960,7 @@ void ReadSHT3X() {
 		// Error while reading the sensor
 		else {
 			printf("Error while reading SHT3x\r\n\r\n");
+			LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_SHT3X);
 
 			return;
 		}
@@ -385,58 +983,365 @@ void ReadSHT3X() {
 }
 
 void ReadDFR0198() {
-	// Reads soil temperature
-	if (DS18B20_ReadTemperature(&dfr, &soilTemp_C) == HAL_OK) {
+	HAL_StatusTypeDef status;
+
+	// Reads soil temperature (collects the started conversion if any)
+	if (dfrStarted) {
+		dfrStarted = 0;
+		status = DS18B20_FetchTemperature(&dfr, &soilTemp_C);
+	}
+	else status = DS18B20_ReadTemperature(&dfr, &soilTemp_C);
+
+	if (status == HAL_OK) {
 
 	}
 	// Error while reading the sensor
 	else {
 		printf("Error while reading DFR0198\r\n\r\n");
+		LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_DFR0198);
 	}
 }
 
 void ReadSEN0308() {
 	uint16_t rawMoisture;
 
+	// Analog output must settle after VDD_SENS is switched on
+	SettleDomain(&senDomain);
+
 	// Reads soil moisture
+#ifdef SEN_OVERSAMPLED
+	// Calibration points are 12-bit readings; rounding a full-scale result would give 4096
+	if (SEN0308_ReadOversampled(&sen, &rawMoisture, SEN_OVS_RATIO) == HAL_OK) {
+		rawMoisture = (rawMoisture + (1U << (SEN0308_OVS_BITS - 13))) >> (SEN0308_OVS_BITS - 12);
+		if (rawMoisture > 4095) rawMoisture = 4095;
+		soilMoisture_perc = SEN0308_CalculateRelative(&sen, rawMoisture);
+	}
+#else
 	if (SEN0308_ReadRawAvg(&sen, &rawMoisture, 5) == HAL_OK) {
 		soilMoisture_perc = SEN0308_CalculateRelative(&sen, rawMoisture);
 	}
+#endif
 	// Error while reading the sensor
 	else {
 		printf("Error while reading SEN0308\r\n\r\n");
+		LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_SEN0308);
 	}
 }
 
+// AEM10941 STATUS[2:0] (SAMPLING_AEM_* bits)
+uint8_t ReadAEMStatus() {
+	uint8_t status = 0;
+
+	if (HAL_GPIO_ReadPin(S0_AEM_GPIO_Port, S0_AEM_Pin) == GPIO_PIN_SET) status |= SAMPLING_AEM_LDO_READY;
+	if (HAL_GPIO_ReadPin(S1_AEM_GPIO_Port, S1_AEM_Pin) == GPIO_PIN_SET) status |= SAMPLING_AEM_BATT_LOW;
+	if (HAL_GPIO_ReadPin(S2_AEM_GPIO_Port, S2_AEM_Pin) == GPIO_PIN_SET) status |= SAMPLING_AEM_MPP_EVAL;
+
+	return status;
+}
+
 // Dump
 
+static void printDumpRow(void *ctx, uint32_t seq, const DataSample_t *rx, uint8_t valid) {
+    uint16_t *i = ctx;
+
+    // En bloques comprimidos no hay un slot por muestra: se indica la secuencia
+    uint32_t slot = (mem.format == FRAM_FORMAT_BLOCK) ? seq : (uint32_t)(mem.write_idx + mem.slots - mem.count + *i) % mem.slots;
+
+    printf("%u", *i);
+    if (valid) {
+        printf(",%02u/%02u/20%02u", rx->day, rx->month, rx->year);
+        printf(",%02u:%02u:%02u", rx->hours, rx->minutes, rx->seconds);
+        printf(",%lu,%u", (unsigned long)slot, valid);
+        printf(",%.3f", rx->batteryVoltage_mV / 1000.0);
+        printf(",%.3f", rx->irradiance_Wm2);
+        printf(",%.3f,%u", rx->airTemp_C, rx->airHumidity_perc);
+        printf(",%.3f,%u", rx->soilTemp_C, rx->soilMoisture_perc);
+    }
+    else printf(",,,%lu,%u,,,,", (unsigned long)slot, valid);
+
+    printf("\r\n");
+    (*i)++;
+}
+
 void DumpFRAM(void) {
+    uint16_t i = 0;
+
     printf("Ciclo,Fecha,Hora,Slot Memoria,Slot Valido,Bateria (V),Irradiancia (W/m2),Temp Aire (C),Hum Aire (%),Temp Suelo (C),Hum Suelo (%)\r\n");
 
+    // Lecturas de varios slots a la vez
+    if (FRAM_ReadRange(&mem, mem.next_seq - mem.count, mem.next_seq, printDumpRow, &i) != HAL_OK) printf("Error while reading FRAM\r\n\r\n");
+}
+
+// CRC engines over the whole 32 KB image, DWT cycles of the computation only (FRAM_CrcBenchmark)
+void BenchmarkCRC() {
+	static const char *names[3] = { "bitwise", "table", "hardware" };
+	uint32_t cycles[3];
+
+	if (FRAM_CrcBenchmark(&mem, cycles) != HAL_OK) {
+		printf("Error while reading FRAM\r\n\r\n");
+		return;
+	}
+
+	printf("Motor,Ciclos,Tiempo (us)\r\n");
+	for (uint8_t e = 0; e < 3; e++) {
+		printf("%s,%lu,%lu\r\n", names[e], (unsigned long)cycles[e], (unsigned long)(cycles[e] / (SystemCoreClock / 1000000)));
+	}
+	printf("\r\n");
+}
+
+// Lectura de todas las muestras del anillo: las que no pasan el CRC quedan en el registro de eventos
+void ScrubFRAM() {
+    uint16_t invalid = 0;
+
     for (uint16_t i = 0; i < mem.count; i++) {
-        DataSample_t rx = {0};
+        DataSample_t rx;
         uint8_t valid = 0;
 
-        uint16_t slot = (mem.write_idx + FRAM_DATA_SLOTS - mem.count + i) % FRAM_DATA_SLOTS;
+        if (FRAM_GetSample(&mem, mem.next_seq - mem.count + i, &rx, &valid) != HAL_OK || !valid) invalid++;
+    }
+
+    if (invalid) {
+        printf("FRAM scrub: %u invalid samples\r\n\r\n", invalid);
+        LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_FRAM);
+    }
+}
 
-        FRAM_GetSlot(&mem, slot, &rx, &valid);
+// Ráfaga sin promediado de los tres canales (PV, batería, carga); la configuración se restaura al terminar
+void CaptureINA3221() {
+    INA3221_AveragingMode_t averaging = ina.averagingMode;
+    uint32_t start_ms = HAL_GetTick();
 
-        printf("%u", i);
-        if (valid) {
-            printf(",%02u/%02u/20%02u", rx.day, rx.month, rx.year);
-            printf(",%02u:%02u:%02u", rx.hours, rx.minutes, rx.seconds);
-            printf(",%u,%u", slot, valid);
-            printf(",%.3f", rx.batteryVoltage_mV / 1000.0);
-            printf(",%.3f", rx.irradiance_Wm2);
-            printf(",%.3f,%u", rx.airTemp_C, rx.airHumidity_perc);
-            printf(",%.3f,%u", rx.soilTemp_C, rx.soilMoisture_perc);
+    ina.averagingMode = INA3221_AVG_1;
+
+    uint32_t conv_ms = INA3221_ConversionTime_ms(&ina);
+
+    printf("Muestra,Tiempo (ms),PV (V),PV (mA),Bateria (V),Bateria (mA),Carga (V),Carga (mA)\r\n");
+
+    for (uint16_t n = 0; n < INA_CAPTURE_SAMPLES; n++) {
+        // Una conversión por muestra, también en modo continuo (escribir la configuración la reinicia)
+        if (INA3221_StartConversion(&ina) != HAL_OK) {
+            printf("Error while configuring INA3221\r\n\r\n");
+            break;
         }
-        else printf(",,,%u,%u,,,,", slot, valid);
+        HAL_Delay(conv_ms);
+
+        printf("%u,%lu", n, (unsigned long)(HAL_GetTick() - start_ms));
+        for (uint8_t ch = 1; ch <= 3; ch++) {
+            float bus_V, shunt_V;
 
+            if (INA3221_ReadVoltage(&ina, ch, &bus_V, &shunt_V) == HAL_OK) printf(",%.3f,%.3f", bus_V, INA3221_CalculateCurrent_mA(&ina, ch, shunt_V));
+            else printf(",,");
+        }
         printf("\r\n");
     }
+
+    ina.averagingMode = averaging;
+#ifdef INA_TRIGGERED
+    IdleINA3221();
+#else
+    if (INA3221_StartConversion(&ina) != HAL_OK) LogEvent(FRAM_EVENT_SENSOR_ERROR, FRAM_SENSOR_INA3221);
+#endif
+}
+
+// Agregados de mayor a menor antigüedad (medias y extremos en unidades de SampleV2_t)
+void DumpTiers(FramTierId_t tier) {
+    printf("Inicio,Muestras,Bateria media (mV),Irradiancia media (dW/m2),Temp Aire min (cC),Temp Aire max (cC),Temp Suelo media (cC),Hum Aire media (%%),Hum Suelo media (%%)\r\n");
+
+    for (uint16_t i = mem.tier[tier].count; i > 0; i--) {
+        FramAggregate_t agg;
+        uint8_t valid = 0;
+
+        if (FRAM_GetAggregate(&mem, tier, i - 1, &agg, &valid) != HAL_OK || !valid) continue;
+
+        printf("%lu,%lu", (unsigned long)agg.start, (unsigned long)agg.samples);
+        printf(",%ld,%ld", (long)FRAM_AggMean(&agg, FRAM_AGG_BATTERY), (long)FRAM_AggMean(&agg, FRAM_AGG_IRRADIANCE));
+        printf(",%ld,%ld", (long)agg.min[FRAM_AGG_AIR_TEMP], (long)agg.max[FRAM_AGG_AIR_TEMP]);
+        printf(",%ld", (long)FRAM_AggMean(&agg, FRAM_AGG_SOIL_TEMP));
+        printf(",%ld,%ld\r\n", (long)FRAM_AggMean(&agg, FRAM_AGG_AIR_HUM), (long)FRAM_AggMean(&agg, FRAM_AGG_SOIL_MOIST));
+    }
+}
+
+static void printExportRow(void *ctx, uint32_t seq, const DataSample_t *rx, uint8_t valid) {
+    (void)ctx;
+
+    printf("%lu", (unsigned long)seq);
+    if (valid) {
+        printf(",%02u/%02u/20%02u", rx->day, rx->month, rx->year);
+        printf(",%02u:%02u:%02u", rx->hours, rx->minutes, rx->seconds);
+        printf(",%.3f", rx->batteryVoltage_mV / 1000.0);
+        printf(",%.3f", rx->irradiance_Wm2);
+        printf(",%.3f,%u", rx->airTemp_C, rx->airHumidity_perc);
+        printf(",%.3f,%u", rx->soilTemp_C, rx->soilMoisture_perc);
+    }
+    else printf(",,,,,,,,");
+
+    printf("\r\n");
+}
+
+// Muestras no confirmadas por el consumidor; la última línea indica la secuencia a confirmar con AckFRAM
+void ExportFRAM(const char *consumer, uint16_t max) {
+    uint8_t id;
+    uint32_t end = 0;
+
+    if (FRAM_CursorOpen(&mem, consumer, &id) != HAL_OK) {
+        printf("Error while opening FRAM cursor\r\n");
+        return;
+    }
+
+    printf("Secuencia,Fecha,Hora,Bateria (V),Irradiancia (W/m2),Temp Aire (C),Hum Aire (%%),Temp Suelo (C),Hum Suelo (%%)\r\n");
+
+    if (FRAM_Export(&mem, id, max, printExportRow, NULL, &end) != HAL_OK) {
+        printf("Error while exporting FRAM\r\n");
+        return;
+    }
+
+    printf("Fin,%lu\r\n", (unsigned long)end);
+}
+
+void AckFRAM(const char *consumer, uint32_t seq) {
+    uint8_t id;
+
+    if (FRAM_CursorOpen(&mem, consumer, &id) != HAL_OK || FRAM_CursorAck(&mem, id, seq) != HAL_OK) {
+        printf("Error while acknowledging FRAM export\r\n");
+    }
+}
+// Muestras con hora en [from, to) (epoch Unix)
+void DumpRange(uint32_t from, uint32_t to) {
+    printf("Secuencia,Fecha,Hora,Bateria (V),Irradiancia (W/m2),Temp Aire (C),Hum Aire (%%),Temp Suelo (C),Hum Suelo (%%)\r\n");
+
+    if (FRAM_FindRange(&mem, from, to, printExportRow, NULL) != HAL_OK) {
+        printf("Error while searching FRAM\r\n");
+    }
+}
+
+static void printEventRow(void *ctx, const FramEventRecord_t *evt) {
+    (void)ctx;
+
+    printf("%lu,%lu,%u,0x%08lX\r\n", (unsigned long)evt->seq, (unsigned long)evt->timestamp, evt->code, (unsigned long)evt->arg);
+}
+
+// Registro de eventos de más antiguo a más reciente
+void DumpEvents() {
+    printf("Secuencia,Epoch,Codigo,Argumento\r\n");
+
+    if (FRAM_ExportEvents(&mem, 0, 0, printEventRow, NULL, NULL) != HAL_OK) {
+        printf("Error while reading FRAM events\r\n");
+    }
+}
+
+// EVENTS -------------------------------------------------------------------
+
+uint32_t RTC_ToEpoch(const RTC_TimeTypeDef *t, const RTC_DateTypeDef *d) {
+	DataSample_t now = {
+		.hours = t->Hours, .minutes = t->Minutes, .seconds = t->Seconds,
+		.day = d->Date, .month = d->Month, .year = d->Year
+	};
+
+	return FRAM_SampleTime(&now);
+}
+
+// Current RTC time as Unix epoch (0 if the RTC can't be read); leaves time/date untouched
+uint32_t RTC_Epoch() {
+	RTC_TimeTypeDef t;
+	RTC_DateTypeDef d;
+
+	// GetDate must follow GetTime to unlock the shadow registers
+	if (HAL_RTC_GetTime(&hrtc, &t, RTC_FORMAT_BIN) != HAL_OK) return 0;
+	if (HAL_RTC_GetDate(&hrtc, &d, RTC_FORMAT_BIN) != HAL_OK) return 0;
+
+	return RTC_ToEpoch(&t, &d);
+}
+
+// Current RTC time in ms since the epoch and the tick it was read at (0 if the RTC can't be read)
+uint64_t RTC_EpochMs(uint32_t *tick) {
+	RTC_TimeTypeDef t;
+	RTC_DateTypeDef d;
+
+	*tick = HAL_GetTick();
+
+	// GetDate must follow GetTime to unlock the shadow registers
+	if (HAL_RTC_GetTime(&hrtc, &t, RTC_FORMAT_BIN) != HAL_OK) return 0;
+	if (HAL_RTC_GetDate(&hrtc, &d, RTC_FORMAT_BIN) != HAL_OK) return 0;
+
+	uint32_t ms = ((t.SecondFraction - t.SubSeconds) * 1000) / (t.SecondFraction + 1);
+	return (uint64_t)RTC_ToEpoch(&t, &d) * 1000 + ms;
+}
+
+// Events go to their own FRAM ring, the sample ring and its RAM batch are not touched
+void LogEvent(FramEventCode_t code, uint32_t arg) {
+	LogEventAt(code, RTC_Epoch(), arg);
+}
+
+void LogEventAt(FramEventCode_t code, uint32_t timestamp, uint32_t arg) {
+	FRAM_LogEvent(&mem, code, timestamp, arg);
+
+	// The error counter survives the event ring wrapping over old errors
+	if (code == FRAM_EVENT_SENSOR_ERROR) FRAM_CountError(&mem, NULL);
+}
+
+void LogResetCause() {
+	// Reset flags live in the top byte of RCC_CSR and survive until cleared
+	LogEvent(FRAM_EVENT_RESET, RCC->CSR & 0xFF000000u);
+	__HAL_RCC_CLEAR_RESET_FLAGS();
 }
 
+// Wake sources queued by the interrupts since the last cycle, in arrival order
+void DrainEvents() {
+	EvtqEvent_t evt;
+	uint64_t now_ms = 0;
+	uint32_t nowTick = 0;
+	uint8_t haveNow = 0;
+
+	while (EVTQ_Pop(&evt)) {
+		if (evt.type == EVTQ_RTC_WAKE) {
+			cyclePending = 1;
+			continue;
+		}
+
+		// Wall time of the event: one RTC read, moved back by the ticks elapsed since the interrupt
+		if (!haveNow || (int32_t)(evt.tick - nowTick) > 0) {
+			now_ms = RTC_EpochMs(&nowTick);
+			haveNow = 1;
+		}
+
+		uint32_t elapsed_ms = ((int32_t)(nowTick - evt.tick) > 0) ? nowTick - evt.tick : 0;
+		uint64_t at_ms = (now_ms > elapsed_ms) ? now_ms - elapsed_ms : 0;
+		uint32_t at = (uint32_t)(at_ms / 1000);
+
+		// Milliseconds within the second go in the top half of the argument
+		uint32_t ms = (uint32_t)(at_ms % 1000);
+
+		if (evt.arg == PV_INA_Pin || evt.arg == CRI_INA_Pin || evt.arg == WAR_INA_Pin) {
+			LogEventAt(FRAM_EVENT_INA_ALERT, at, evt.arg | (ms << 16));
+
+			// Critical: flush and survive. Warning: a high-rate capture when energy allows.
+			// Power-valid: the panel crossed its thresholds (dawn or dusk), the period follows now.
+			if (evt.arg == CRI_INA_Pin) SetSurvival(1);
+			else if (evt.arg == WAR_INA_Pin) SCHED_Request(&sched, jobCapture, at);
+			else cyclePending = 1;
+		}
+		else {
+			uint32_t state = ((evt.data & S0_AEM_Pin) != 0) |
+							 (((evt.data & S1_AEM_Pin) != 0) << 1) |
+							 (((evt.data & S2_AEM_Pin) != 0) << 2);
+
+			LogEventAt(FRAM_EVENT_AEM, at, state | (ms << 16));
+		}
+	}
+
+	// Ring overflow: the number of events lost since the last report
+	uint32_t dropped = EVTQ_Dropped();
+	if (dropped != eventsDropped) {
+		LogEvent(FRAM_EVENT_QUEUE_DROP, dropped - eventsDropped);
+		eventsDropped = dropped;
+	}
+
+	if (g_pvdLow) {
+		g_pvdLow = 0;
+		if (FRAM_Flush(&mem) != HAL_OK) printf("Error while flushing FRAM\r\n\r\n");
+		LogEvent(FRAM_EVENT_POWER, batteryVoltage_mV);
+	}
+}
 
 // I2C bus scan
 void I2C_bus_scan() {
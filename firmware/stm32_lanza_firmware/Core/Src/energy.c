@@ -0,0 +1,146 @@
+/*
+ * energy.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "energy.h"
+
+#define OCV_POINTS		9
+
+// Li-ion open-circuit voltage against charge between Vovdis and Vovch (mV, %)
+static const uint16_t ocv_mV[OCV_POINTS] = { 3600, 3700, 3750, 3800, 3850, 3900, 4000, 4100, 4120 };
+static const uint8_t ocv_perc[OCV_POINTS] = { 0, 15, 30, 45, 60, 70, 85, 97, 100 };
+
+// 10 uA in STOP2 with the INA3221 powered down, up to the 1 h longest period with margin
+const EnergyConfig_t ENERGY_DefaultConfig = {
+	.capacity_mAh = 1000.0f,
+	.sleep_mA = 0.010f,
+	.charge_eff = 0.95f,
+	.empty_mV = 3600,
+	.full_mV = 4120,
+	.max_gap_s = 3 * 3600
+};
+
+void ENERGY_Init(EnergyLedger_t *ledger, const EnergyConfig_t *cfg) {
+	ledger->cfg = cfg ? *cfg : ENERGY_DefaultConfig;
+
+	for (uint8_t i = 0; i < ENERGY_FLOWS; ++i) {
+		ledger->uAh[i] = 0.0;
+		ledger->uWh[i] = 0.0;
+	}
+
+	ledger->soc_uAh = 0.0;
+	ledger->soc_known = 0;
+	ledger->primed = 0;
+	ledger->last_t = 0;
+}
+
+// Totals and state of charge saved before a reset; the next reading only primes the ledger
+void ENERGY_Restore(EnergyLedger_t *ledger, const uint32_t uAh[ENERGY_FLOWS], const uint32_t uWh[ENERGY_FLOWS], uint32_t soc_uAh) {
+	for (uint8_t i = 0; i < ENERGY_FLOWS; ++i) {
+		ledger->uAh[i] = uAh[i];
+		ledger->uWh[i] = uWh[i];
+	}
+
+	ledger->soc_uAh = soc_uAh;
+	ledger->soc_known = 1;
+	ledger->primed = 0;
+}
+
+static double socFromVoltage(const EnergyLedger_t *ledger, float battery_V) {
+	float mV = battery_V * 1000.0f;
+	float perc = 100.0f;
+
+	if (mV <= ocv_mV[0]) perc = 0.0f;
+	else {
+		for (uint8_t i = 1; i < OCV_POINTS; ++i) {
+			if (mV < ocv_mV[i]) {
+				float k = (mV - ocv_mV[i - 1]) / (float)(ocv_mV[i] - ocv_mV[i - 1]);
+				perc = ocv_perc[i - 1] + k * (ocv_perc[i] - ocv_perc[i - 1]);
+				break;
+			}
+		}
+	}
+
+	return (double)perc / 100.0 * ledger->cfg.capacity_mAh * 1000.0;
+}
+
+// mA (mW) over s to uAh (uWh)
+static void add(EnergyLedger_t *ledger, EnergyFlow_t flow, double mA, double mW, double s) {
+	ledger->uAh[flow] += mA * s / 3.6;
+	ledger->uWh[flow] += mW * s / 3.6;
+}
+
+// Battery current and power over s, split into charge and discharge by sign
+static void addBattery(EnergyLedger_t *ledger, double mA, double mW, double s) {
+	if (mA >= 0.0) add(ledger, ENERGY_BAT_OUT, mA, mW, s);
+	else add(ledger, ENERGY_BAT_IN, -mA, -mW, s);
+}
+
+// Readings of this cycle (INA3221 channels) and how long the node was awake in the previous one
+void ENERGY_Update(EnergyLedger_t *ledger, uint32_t now, const EnergyReading_t *reading, uint32_t awake_ms) {
+	const EnergyConfig_t *cfg = &ledger->cfg;
+	const EnergyReading_t *prev = &ledger->last;
+
+	if (!ledger->soc_known) {
+		ledger->soc_uAh = socFromVoltage(ledger, reading->bus_V[ENERGY_CH_BAT]);
+		ledger->soc_known = 1;
+	}
+
+	uint8_t integrate = ledger->primed && now > ledger->last_t && now - ledger->last_t <= cfg->max_gap_s;
+
+	if (integrate) {
+		double dt = now - ledger->last_t;
+		double awake_s = (awake_ms / 1000.0 < dt) ? awake_ms / 1000.0 : dt;
+		double sleep_s = dt - awake_s;
+
+		double before_uAh[ENERGY_FLOWS];
+		for (uint8_t i = 0; i < ENERGY_FLOWS; ++i) before_uAh[i] = ledger->uAh[i];
+
+		// Harvest: trapezoid, a panel current below zero is offset noise
+		float pv_mA = (prev->current_mA[ENERGY_CH_PV] + reading->current_mA[ENERGY_CH_PV]) / 2.0f;
+		float pv_mW = (prev->current_mA[ENERGY_CH_PV] * prev->bus_V[ENERGY_CH_PV] +
+					   reading->current_mA[ENERGY_CH_PV] * reading->bus_V[ENERGY_CH_PV]) / 2.0f;
+		if (pv_mA < 0.0f) pv_mA = 0.0f;
+		if (pv_mW < 0.0f) pv_mW = 0.0f;
+		add(ledger, ENERGY_PV, pv_mA, pv_mW, dt);
+
+		// Load: measured while awake, sleep current the rest
+		float load_V = reading->bus_V[ENERGY_CH_LOAD];
+		float load_mA = reading->current_mA[ENERGY_CH_LOAD];
+		add(ledger, ENERGY_LOAD, load_mA, load_mA * load_V, awake_s);
+		add(ledger, ENERGY_LOAD, cfg->sleep_mA, cfg->sleep_mA * load_V, sleep_s);
+
+		// Battery: measured while awake; asleep, less load and the mean harvest instead of this one
+		float bat_V = reading->bus_V[ENERGY_CH_BAT];
+		float bat_mW = reading->current_mA[ENERGY_CH_BAT] * bat_V;
+		float pv_now_mW = reading->current_mA[ENERGY_CH_PV] * reading->bus_V[ENERGY_CH_PV];
+		float sleep_mW = bat_mW - (load_mA - cfg->sleep_mA) * load_V - (pv_mW - pv_now_mW);
+
+		addBattery(ledger, reading->current_mA[ENERGY_CH_BAT], bat_mW, awake_s);
+		if (bat_V > 0.1f) addBattery(ledger, sleep_mW / bat_V, sleep_mW, sleep_s);
+
+		// Coulomb counter
+		ledger->soc_uAh += (ledger->uAh[ENERGY_BAT_IN] - before_uAh[ENERGY_BAT_IN]) * cfg->charge_eff;
+		ledger->soc_uAh -= ledger->uAh[ENERGY_BAT_OUT] - before_uAh[ENERGY_BAT_OUT];
+	}
+
+	// Pinned at the ends of the voltage window, where the counter error is known
+	double full_uAh = cfg->capacity_mAh * 1000.0;
+	uint16_t bat_mV = (uint16_t)(reading->bus_V[ENERGY_CH_BAT] * 1000.0f);
+
+	if (bat_mV <= cfg->empty_mV || ledger->soc_uAh < 0.0) ledger->soc_uAh = 0.0;
+	if (bat_mV >= cfg->full_mV || ledger->soc_uAh > full_uAh) ledger->soc_uAh = full_uAh;
+
+	ledger->last = *reading;
+	ledger->last_t = now;
+	ledger->primed = 1;
+}
+
+float ENERGY_SoC(const EnergyLedger_t *ledger) {
+	if (!ledger->soc_known || ledger->cfg.capacity_mAh <= 0.0f) return 0.0f;
+
+	return (float)(ledger->soc_uAh / (ledger->cfg.capacity_mAh * 1000.0) * 100.0);
+}
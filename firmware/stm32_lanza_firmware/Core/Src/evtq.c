@@ -0,0 +1,61 @@
+/*
+ * evtq.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "evtq.h"
+
+_Static_assert((EVTQ_SIZE & (EVTQ_SIZE - 1)) == 0 && EVTQ_SIZE <= 128, "EVTQ_SIZE must be a power of two <= 128");
+
+static EvtqEvent_t ring[EVTQ_SIZE];
+static volatile uint8_t head = 0;		// Written by the producer only
+static volatile uint8_t tail = 0;		// Written by the consumer only
+static volatile uint32_t dropped = 0;	// Events lost with the ring full
+
+// Interrupt context: a few loads and stores, no peripheral access, no loops
+uint8_t EVTQ_Push(EvtqType_t type, uint16_t arg, uint16_t data) {
+	uint8_t h = head;
+
+	if ((uint8_t)(h - tail) >= EVTQ_SIZE) {
+		dropped++;
+		return 0;
+	}
+
+	EvtqEvent_t *evt = &ring[h & (EVTQ_SIZE - 1)];
+	evt->type = (uint8_t)type;
+	evt->arg = arg;
+	evt->data = data;
+
+	evt->tick = HAL_GetTick();
+
+	// The slot must be complete before the consumer can see it
+	__DMB();
+	head = (uint8_t)(h + 1);
+
+	return 1;
+}
+
+uint8_t EVTQ_Pop(EvtqEvent_t *evt) {
+	uint8_t t = tail;
+
+	if (t == head) return 0;
+	__DMB();
+
+	*evt = ring[t & (EVTQ_SIZE - 1)];
+
+	// The slot is copied before the producer can reuse it
+	__DMB();
+	tail = (uint8_t)(t + 1);
+
+	return 1;
+}
+
+uint8_t EVTQ_IsEmpty(void) {
+	return tail == head;
+}
+
+uint32_t EVTQ_Dropped(void) {
+	return dropped;
+}
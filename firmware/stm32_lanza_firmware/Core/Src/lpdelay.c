@@ -0,0 +1,133 @@
+/*
+ * lpdelay.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "lpdelay.h"
+
+void SystemClock_Config();
+void ADC1_ClockResume();
+
+static volatile uint8_t lptimDone = 0;
+static uint8_t initialized = 0;
+
+// Sleep mode: the core stops, SysTick wakes it up every ms
+static void sleepUntil(uint32_t deadline_ms) {
+	while ((int32_t)(deadline_ms - HAL_GetTick()) > 0) {
+		HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+	}
+}
+
+// LPTIM1 ticks since the start of the delay. CNT runs from LSE: read until two reads agree
+static uint32_t lptimElapsed(uint32_t ticks) {
+	if (LPTIM1->ISR & LPTIM_ISR_ARRM) return ticks;
+
+	uint32_t a, b = LPTIM1->CNT;
+	do {
+		a = b;
+		b = LPTIM1->CNT;
+	} while (a != b);
+
+	return (a < ticks) ? a : ticks;
+}
+
+// STOP2 mode: LPTIM1 (LSE) keeps counting and wakes the core at the deadline
+static void stop2For(uint32_t ms) {
+	uint32_t ticks = (ms * LPDELAY_LPTIM_HZ + 999) / 1000;
+	if (ticks > LPDELAY_MAX_TICKS) ticks = LPDELAY_MAX_TICKS;
+
+	// ARR can only be written with the timer enabled
+	LPTIM1->ICR = LPTIM_ICR_ARRMCF | LPTIM_ICR_ARROKCF;
+	LPTIM1->CR = LPTIM_CR_ENABLE;
+	LPTIM1->ARR = ticks;
+	while (!(LPTIM1->ISR & LPTIM_ISR_ARROK));
+	LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+
+	lptimDone = 0;
+	LPTIM1->CR |= LPTIM_CR_SNGSTRT;
+
+	uint32_t start_ms = uwTick;
+	HAL_SuspendTick();
+
+	// Other wake-up sources (RTC, EXTI) are served and the core goes back to sleep. With
+	// PRIMASK set the WFI still ends: SysTick is stopped, so the tick is brought up to date
+	// from LPTIM1 before their callbacks run and the events they queue get the right time.
+	__disable_irq();
+	while (!lptimDone) {
+		HAL_PWREx_EnterSTOP2Mode(PWR_STOPENTRY_WFI);
+
+		uwTick = start_ms + (lptimElapsed(ticks) * 1000) / LPDELAY_LPTIM_HZ;
+		__enable_irq();
+		__disable_irq();
+	}
+	__enable_irq();
+
+	LPTIM1->CR = 0;
+
+	SystemClock_Config();
+	HAL_ResumeTick();
+	ADC1_ClockResume();
+
+	// SysTick was stopped: account for the time spent in STOP2
+	uwTick = start_ms + (ticks * 1000) / LPDELAY_LPTIM_HZ;
+}
+
+void LPDelay_Init(void) {
+	// LPTIM1 clocked from LSE, also during STOP2
+	MODIFY_REG(RCC->CCIPR, RCC_CCIPR_LPTIM1SEL, RCC_CCIPR_LPTIM1SEL_0 | RCC_CCIPR_LPTIM1SEL_1);
+	SET_BIT(RCC->APB1ENR1, RCC_APB1ENR1_LPTIM1EN);
+	SET_BIT(RCC->APB1SMENR1, RCC_APB1SMENR1_LPTIM1SMEN);
+
+	// CFGR and IER can only be written with the timer disabled
+	LPTIM1->CR = 0;
+	LPTIM1->CFGR = LPTIM_CFGR_PRESC_2 | LPTIM_CFGR_PRESC_0; // /32
+	LPTIM1->IER = LPTIM_IER_ARRMIE;
+
+	// Direct EXTI line 29 wakes the core from STOP2
+	SET_BIT(EXTI->IMR1, EXTI_IMR1_IM29);
+
+	HAL_NVIC_SetPriority(LPTIM1_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+
+	initialized = 1;
+}
+
+void LPDelay_Ms(uint32_t ms) {
+	uint32_t start_ms = HAL_GetTick();
+
+	// Inside an interrupt or before init: plain busy wait, as HAL_Delay
+	if (!initialized || __get_IPSR() != 0) {
+		while ((HAL_GetTick() - start_ms) < ms);
+		return;
+	}
+
+	while (ms >= LPDELAY_STOP2_MIN_MS) {
+		uint32_t chunk_ms = (ms > 60000) ? 60000 : ms;
+
+		stop2For(chunk_ms);
+		ms -= chunk_ms;
+		start_ms += chunk_ms;
+	}
+
+	sleepUntil(start_ms + ms);
+}
+
+void LPDelay_Until(uint32_t deadline_ms) {
+	int32_t remaining_ms = (int32_t)(deadline_ms - HAL_GetTick());
+
+	if (remaining_ms > 0) LPDelay_Ms((uint32_t)remaining_ms);
+}
+
+void LPDelay_IRQHandler(void) {
+	if (LPTIM1->ISR & LPTIM_ISR_ARRM) {
+		LPTIM1->ICR = LPTIM_ICR_ARRMCF;
+		lptimDone = 1;
+	}
+}
+
+// HAL_Delay() is weak: every driver wait goes through the low power service
+void HAL_Delay(uint32_t Delay) {
+	LPDelay_Ms(Delay);
+}
@@ -41,12 +41,15 @@
 
 /* Private variables ---------------------------------------------------------*/
 ADC_HandleTypeDef hadc1;
+DMA_HandleTypeDef hdma_adc1;
 
 I2C_HandleTypeDef hi2c3;
 
 RTC_HandleTypeDef hrtc;
 
 SPI_HandleTypeDef hspi2;
+DMA_HandleTypeDef hdma_spi2_rx;
+DMA_HandleTypeDef hdma_spi2_tx;
 
 UART_HandleTypeDef huart1;
 
@@ -58,6 +61,7 @@ UART_HandleTypeDef huart1;
 void SystemClock_Config(void);
 void PeriphCommonClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_RTC_Init(void);
 static void MX_ADC1_Init(void);
@@ -70,6 +74,18 @@ void ADC1_Init() {
 
 	MX_ADC1_Init();
 }
+
+// STOP mode clears PLLSAI1ON (ADC kernel clock), its configuration is retained
+void ADC1_ClockResume() {
+	if (__HAL_RCC_GET_FLAG(RCC_FLAG_PLLSAI1RDY)) return;
+
+	__HAL_RCC_PLLSAI1_ENABLE();
+
+	uint32_t start = HAL_GetTick();
+	while (!__HAL_RCC_GET_FLAG(RCC_FLAG_PLLSAI1RDY)) {
+		if ((HAL_GetTick() - start) > 2) return;
+	}
+}
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -114,6 +130,7 @@ int main(void)
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_USART1_UART_Init();
   MX_RTC_Init();
   MX_ADC1_Init();
@@ -486,6 +503,29 @@ static void MX_USART1_UART_Init(void)
 
 }
 
+/**
+  * Enable DMA controller clock
+  */
+static void MX_DMA_Init(void)
+{
+
+  /* DMA controller clock enable */
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  /* DMA interrupt init */
+  /* DMA1_Channel1_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+  /* DMA1_Channel2_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+  /* DMA1_Channel3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+
+}
+
 /**
   * @brief GPIO Initialization Function
   * @param None
@@ -512,17 +552,23 @@ static void MX_GPIO_Init(void)
   /*Configure GPIO pin Output Level */
   HAL_GPIO_WritePin(WP_FRAM_GPIO_Port, WP_FRAM_Pin, GPIO_PIN_RESET);
 
-  /*Configure GPIO pins : PV_INA_Pin CRI_INA_Pin WAR_INA_Pin S1_AEM_Pin */
-  GPIO_InitStruct.Pin = PV_INA_Pin|CRI_INA_Pin|WAR_INA_Pin|S1_AEM_Pin;
-  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+  /*Configure GPIO pins : PV_INA_Pin S0_AEM_Pin */
+  GPIO_InitStruct.Pin = PV_INA_Pin|S0_AEM_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_NOPULL;
   HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
-  /*Configure GPIO pin : S0_AEM_Pin */
-  GPIO_InitStruct.Pin = S0_AEM_Pin;
-  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
+  /*Configure GPIO pins : CRI_INA_Pin WAR_INA_Pin */
+  GPIO_InitStruct.Pin = CRI_INA_Pin|WAR_INA_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+  /*Configure GPIO pin : S1_AEM_Pin */
+  GPIO_InitStruct.Pin = S1_AEM_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
   GPIO_InitStruct.Pull = GPIO_NOPULL;
-  HAL_GPIO_Init(S0_AEM_GPIO_Port, &GPIO_InitStruct);
+  HAL_GPIO_Init(S1_AEM_GPIO_Port, &GPIO_InitStruct);
 
   /*Configure GPIO pin : S2_AEM_Pin */
   GPIO_InitStruct.Pin = S2_AEM_Pin;
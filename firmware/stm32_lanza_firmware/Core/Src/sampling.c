@@ -0,0 +1,79 @@
+/*
+ * sampling.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "sampling.h"
+
+// Li-ion cell between Vovdis (3.6 V) and Vovch (4.12 V); level 2 keeps the 20 min period of the field tests
+const SamplingConfig_t SAMPLING_DefaultConfig = {
+	.battery_mV = { 4000, 3900, 3800, 3700 },
+	.hysteresis_mV = 20,
+	.period_s = { 300, 600, 1200, 2400, 3600 },
+	.surplus_Wm2 = 20.0f,
+	.dark_Wm2 = 0.5f,
+	.trend_alpha = 0.2f
+};
+
+void SAMPLING_Init(SamplingPolicy_t *policy, const SamplingConfig_t *cfg) {
+	policy->cfg = cfg ? *cfg : SAMPLING_DefaultConfig;
+	policy->level = SAMPLING_LEVELS / 2;
+	policy->effective = policy->level;
+	policy->primed = 0;
+	policy->irr_fast = 0.0f;
+	policy->irr_slow = 0.0f;
+	policy->period_s = policy->cfg.period_s[policy->effective];
+}
+
+static void batteryLevel(SamplingPolicy_t *policy, uint16_t battery_mV) {
+	const SamplingConfig_t *cfg = &policy->cfg;
+
+	// Worse levels are taken at once, better ones need the hysteresis margin
+	while (policy->level < SAMPLING_LEVELS - 1 && battery_mV < cfg->battery_mV[policy->level]) policy->level++;
+	while (policy->level > 0 && battery_mV >= cfg->battery_mV[policy->level - 1] + cfg->hysteresis_mV) policy->level--;
+}
+
+static int8_t irradianceTrend(SamplingPolicy_t *policy, float irradiance_Wm2) {
+	const SamplingConfig_t *cfg = &policy->cfg;
+	float fastAlpha = (cfg->trend_alpha * 2.0f > 1.0f) ? 1.0f : cfg->trend_alpha * 2.0f;
+
+	if (irradiance_Wm2 < 0.0f) irradiance_Wm2 = 0.0f;
+
+	if (!policy->primed) {
+		policy->irr_fast = irradiance_Wm2;
+		policy->irr_slow = irradiance_Wm2;
+		policy->primed = 1;
+	}
+	else {
+		policy->irr_fast += fastAlpha * (irradiance_Wm2 - policy->irr_fast);
+		policy->irr_slow += cfg->trend_alpha * (irradiance_Wm2 - policy->irr_slow);
+	}
+
+	float trend = policy->irr_fast - policy->irr_slow;
+
+	// Surplus on the averaged value (a single bright reading is not enough), dusk on the last one
+	if (policy->irr_fast >= cfg->surplus_Wm2 && trend >= 0.0f) return -1;
+	if (irradiance_Wm2 < cfg->dark_Wm2 && trend <= 0.0f) return 1;
+	return 0;
+}
+
+// New wake period for the battery voltage, irradiance and AEM status (SAMPLING_AEM_*) of this cycle
+uint16_t SAMPLING_Update(SamplingPolicy_t *policy, uint16_t battery_mV, float irradiance_Wm2, uint8_t aem) {
+	batteryLevel(policy, battery_mV);
+
+	int8_t level = (int8_t)policy->level + irradianceTrend(policy, irradiance_Wm2);
+
+	// Below Vchrdy the harvester is not keeping up, below Vovdis only the longest period is allowed
+	if (!(aem & SAMPLING_AEM_LDO_READY) && level < SAMPLING_LEVELS - 2) level = SAMPLING_LEVELS - 2;
+	if (aem & SAMPLING_AEM_BATT_LOW) level = SAMPLING_LEVELS - 1;
+
+	if (level < 0) level = 0;
+	if (level > SAMPLING_LEVELS - 1) level = SAMPLING_LEVELS - 1;
+
+	policy->effective = (uint8_t)level;
+	policy->period_s = policy->cfg.period_s[level] ? policy->cfg.period_s[level] : 1;
+
+	return policy->period_s;
+}
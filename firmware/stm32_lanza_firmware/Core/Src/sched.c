@@ -0,0 +1,168 @@
+/*
+ * sched.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "sched.h"
+
+#define RATIO_MIN			0.25f	// Limits of the today/profile correction
+#define RATIO_MAX			2.0f
+#define RATIO_MIN_WM2		0.5f	// Below this the profile bin is dark, no correction
+
+// Solar panel through the AEM10941 (harvest_05_11_25.csv: ~1.8 mW per W/m2), board asleep most of the time
+const SchedConfig_t SCHED_DefaultConfig = {
+	.day_s = 86400,
+	.harvest_mW_per_Wm2 = 1.8f,
+	.load_mW = 0.5f,
+	.horizon_bins = 6,
+	.window_frac = 0.8f,
+	.profile_alpha = 0.3f,
+	.floor_mV = 3650,
+	.comfort_mV = 3900
+};
+
+void SCHED_Init(Scheduler_t *sched, const SchedConfig_t *cfg) {
+	sched->cfg = cfg ? *cfg : SCHED_DefaultConfig;
+	if (sched->cfg.day_s < SCHED_BINS) sched->cfg.day_s = SCHED_BINS;
+
+	for (uint8_t i = 0; i < SCHED_BINS; ++i) sched->profile[i] = 0.0f;
+	sched->known = 0;
+	sched->bin = -1;
+	sched->bin_day = 0;
+	sched->bin_sum = 0.0f;
+	sched->bin_n = 0;
+	sched->jobs = 0;
+}
+
+// Returns the job id, 0xFF with the table full
+uint8_t SCHED_AddJob(Scheduler_t *sched, uint32_t cost_mJ, uint32_t max_delay_s) {
+	if (sched->jobs >= SCHED_MAX_JOBS) return 0xFF;
+
+	SchedJob_t *job = &sched->job[sched->jobs];
+	job->cost_mJ = cost_mJ;
+	job->max_delay_s = max_delay_s;
+	job->requested = 0;
+	job->pending = 0;
+
+	return sched->jobs++;
+}
+
+// A job already pending keeps its first request time (and deadline)
+void SCHED_Request(Scheduler_t *sched, uint8_t id, uint32_t now) {
+	if (id >= sched->jobs || sched->job[id].pending) return;
+
+	sched->job[id].requested = now;
+	sched->job[id].pending = 1;
+}
+
+static uint8_t binOf(const Scheduler_t *sched, uint32_t now) {
+	return (uint8_t)((uint64_t)(now % sched->cfg.day_s) * SCHED_BINS / sched->cfg.day_s);
+}
+
+static float binSeconds(const Scheduler_t *sched) {
+	return (float)sched->cfg.day_s / SCHED_BINS;
+}
+
+// Folds the finished bin into the profile, the first day is taken as is
+static void closeBin(Scheduler_t *sched) {
+	if (sched->bin < 0 || sched->bin_n == 0) return;
+
+	float mean = sched->bin_sum / sched->bin_n;
+	uint32_t bit = 1UL << sched->bin;
+
+	if (sched->known & bit) sched->profile[sched->bin] += sched->cfg.profile_alpha * (mean - sched->profile[sched->bin]);
+	else sched->profile[sched->bin] = mean;
+
+	sched->known |= bit;
+}
+
+// TSL2591 irradiance of this cycle; call it once per cycle, at any period
+void SCHED_AddSample(Scheduler_t *sched, uint32_t now, float irradiance_Wm2) {
+	uint8_t bin = binOf(sched, now);
+	uint32_t day = now / sched->cfg.day_s;
+
+	if (irradiance_Wm2 < 0.0f) irradiance_Wm2 = 0.0f;
+
+	if (bin != sched->bin || day != sched->bin_day) {
+		closeBin(sched);
+		sched->bin = bin;
+		sched->bin_day = day;
+		sched->bin_sum = 0.0f;
+		sched->bin_n = 0;
+	}
+
+	sched->bin_sum += irradiance_Wm2;
+	if (sched->bin_n < UINT16_MAX) sched->bin_n++;
+}
+
+// How today compares with the profile so far in the current bin (cloudy day: < 1)
+static float todayRatio(const Scheduler_t *sched) {
+	if (sched->bin < 0 || sched->bin_n == 0 || !(sched->known & (1UL << sched->bin))) return 1.0f;
+
+	float expected = sched->profile[sched->bin];
+	if (expected < RATIO_MIN_WM2) return 1.0f;
+
+	float ratio = (sched->bin_sum / sched->bin_n) / expected;
+	if (ratio < RATIO_MIN) ratio = RATIO_MIN;
+	if (ratio > RATIO_MAX) ratio = RATIO_MAX;
+	return ratio;
+}
+
+// Unknown bins forecast no harvest: a job is never deferred to a surplus not yet seen
+static float forecastPower_mW(const Scheduler_t *sched, uint8_t bin, float ratio) {
+	if (!(sched->known & (1UL << bin))) return 0.0f;
+	return sched->profile[bin] * ratio * sched->cfg.harvest_mW_per_Wm2;
+}
+
+// Harvested energy forecast for the next bins after the current one
+float SCHED_Forecast_mWh(const Scheduler_t *sched, uint32_t now, uint8_t bins) {
+	uint8_t bin = binOf(sched, now);
+	float ratio = todayRatio(sched);
+	float mW = 0.0f;
+
+	for (uint8_t k = 1; k <= bins; ++k) mW += forecastPower_mW(sched, (uint8_t)((bin + k) % SCHED_BINS), ratio);
+
+	return mW * binSeconds(sched) / 3600.0f;
+}
+
+// Bit mask of the jobs to run now, they stop being pending
+uint32_t SCHED_Due(Scheduler_t *sched, uint32_t now, float irradiance_Wm2, uint16_t battery_mV) {
+	const SchedConfig_t *cfg = &sched->cfg;
+	uint8_t bin = binOf(sched, now);
+	float ratio = todayRatio(sched);
+
+	// Net power now and over the horizon
+	float now_mW = irradiance_Wm2 * cfg->harvest_mW_per_Wm2 - cfg->load_mW;
+	float best_mW = -cfg->load_mW;
+	float surplus_mJ = 0.0f;
+
+	for (uint8_t k = 1; k <= cfg->horizon_bins; ++k) {
+		float net_mW = forecastPower_mW(sched, (uint8_t)((bin + k) % SCHED_BINS), ratio) - cfg->load_mW;
+
+		if (net_mW > best_mW) best_mW = net_mW;
+		if (net_mW > 0.0f) surplus_mJ += net_mW * binSeconds(sched);
+	}
+
+	uint8_t window = (now_mW > 0.0f) && (now_mW >= cfg->window_frac * best_mW);
+	uint32_t due = 0;
+
+	for (uint8_t i = 0; i < sched->jobs; ++i) {
+		SchedJob_t *job = &sched->job[i];
+		uint8_t run;
+
+		if (!job->pending || battery_mV < cfg->floor_mV) continue;
+
+		if (now - job->requested >= job->max_delay_s) run = 1;
+		else if (window) run = 1;
+		else run = (surplus_mJ < (float)job->cost_mJ) && (battery_mV >= cfg->comfort_mV);
+
+		if (run) {
+			job->pending = 0;
+			due |= 1UL << i;
+		}
+	}
+
+	return due;
+}
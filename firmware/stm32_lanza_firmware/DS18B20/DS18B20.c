@@ -119,10 +119,7 @@ static uint8_t crc8(const uint8_t *data, uint8_t len) {
     return crc;
 }
 
-HAL_StatusTypeDef DS18B20_Init(DS18B20_t *dev) {
-	if (!DWT_DelayInit()) return HAL_ERROR;
-    releasePin(dev->port, dev->pin);
-
+static HAL_StatusTypeDef writeConfig(DS18B20_t *dev) {
     if (!resetPresence(dev->port, dev->pin)) return HAL_ERROR;
 
     uint8_t cfg = (uint8_t)dev->resolution;
@@ -133,27 +130,61 @@ HAL_StatusTypeDef DS18B20_Init(DS18B20_t *dev) {
 	writeByte(dev->port, dev->pin, 0x00); // TL
 	writeByte(dev->port, dev->pin, cfg);  // CONFIG
 
+	dev->regConfig = dev->resolution;
+
 	return HAL_OK;
 }
 
-HAL_StatusTypeDef DS18B20_ReadTemperature(DS18B20_t *dev, float *temp_c){
+HAL_StatusTypeDef DS18B20_Init(DS18B20_t *dev) {
+	if (!DWT_DelayInit()) return HAL_ERROR;
+    releasePin(dev->port, dev->pin);
+
+    return writeConfig(dev);
+}
+
+HAL_StatusTypeDef DS18B20_Configure(DS18B20_t *dev) {
+	// Solo se reescribe el scratchpad si la resolución difiere
+	if (dev->regConfig == dev->resolution) return HAL_OK;
+
+    releasePin(dev->port, dev->pin);
+
+	return writeConfig(dev);
+}
+
+void DS18B20_PowerLost(DS18B20_t *dev) {
+	dev->regConfig = DS18B20_CONFIG_DEFAULT;
+}
+
+HAL_StatusTypeDef DS18B20_StartConversion(DS18B20_t *dev) {
 	// Transacción 1: iniciar conversión
 	if (!resetPresence(dev->port, dev->pin)) return HAL_ERROR;
 
 	writeByte(dev->port, dev->pin, DS18B20_CMD_SKIP_ROM);
 	writeByte(dev->port, dev->pin, DS18B20_CMD_CONVERT_T);
 
-	// Espera por fin de conversión
-    int32_t timeout_ms;
+	return HAL_OK;
+}
+
+uint8_t DS18B20_IsConversionDone(DS18B20_t *dev) {
+	// El sensor mantiene la línea a 0 mientras convierte
+	return readBit(dev->port, dev->pin);
+}
+
+uint32_t DS18B20_ConversionTime_ms(DS18B20_t *dev) {
     switch (dev->resolution){
-        case DS18B20_RES_9_BIT:  timeout_ms = 94;  break;
-        case DS18B20_RES_10_BIT: timeout_ms = 188; break;
-        case DS18B20_RES_11_BIT: timeout_ms = 375; break;
-        default:                 timeout_ms = 750; break;
+        case DS18B20_RES_9_BIT:  return 94;
+        case DS18B20_RES_10_BIT: return 188;
+        case DS18B20_RES_11_BIT: return 375;
+        default:                 return 750;
     }
+}
+
+HAL_StatusTypeDef DS18B20_FetchTemperature(DS18B20_t *dev, float *temp_c) {
+	// Espera por fin de conversión (si aún no ha terminado)
+	int32_t timeout_ms = (int32_t)DS18B20_ConversionTime_ms(dev);
 
     while (timeout_ms--) {
-		if (readBit(dev->port, dev->pin)) break;
+		if (DS18B20_IsConversionDone(dev)) break;
 		HAL_Delay(1);
 	}
     if (timeout_ms <= 0) return HAL_ERROR;
@@ -178,6 +209,13 @@ HAL_StatusTypeDef DS18B20_ReadTemperature(DS18B20_t *dev, float *temp_c){
     return HAL_OK;
 }
 
+HAL_StatusTypeDef DS18B20_ReadTemperature(DS18B20_t *dev, float *temp_c){
+	HAL_StatusTypeDef status = DS18B20_StartConversion(dev);
+	if (status != HAL_OK) return status;
+
+	return DS18B20_FetchTemperature(dev, temp_c);
+}
+
 HAL_StatusTypeDef DS18B20_ReadROM(DS18B20_t *dev, uint8_t rom[8]){
     if (!resetPresence(dev->port, dev->pin)) return HAL_ERROR;
 
@@ -23,6 +23,8 @@
 #define DS18B20_CMD_WRITE_SCRATCH 0x4E
 #define DS18B20_CMD_COPY_SCRATCH  0x48
 
+#define DS18B20_POWERUP_MS        1 // Time before the first reset pulse after power-up
+
 // Resolution
 typedef enum {
     DS18B20_RES_9_BIT  = 0x1F,
@@ -36,12 +38,23 @@ typedef struct {
     GPIO_TypeDef *port;
     uint16_t pin;
     DS18B20_Resolution_t resolution;
+    DS18B20_Resolution_t regConfig; // Resolution held in the scratchpad
 } DS18B20_t;
 
+// The scratchpad is reloaded from EEPROM at power-up (factory value)
+#define DS18B20_CONFIG_DEFAULT    DS18B20_RES_12_BIT
+
 // Functions
 HAL_StatusTypeDef DS18B20_Init(DS18B20_t *dev);
 
+HAL_StatusTypeDef DS18B20_Configure(DS18B20_t *dev);
+void DS18B20_PowerLost(DS18B20_t *dev);
+
 HAL_StatusTypeDef DS18B20_ReadTemperature(DS18B20_t *dev, float *temp_c);
+HAL_StatusTypeDef DS18B20_StartConversion(DS18B20_t *dev);
+HAL_StatusTypeDef DS18B20_FetchTemperature(DS18B20_t *dev, float *temp_c);
+uint8_t DS18B20_IsConversionDone(DS18B20_t *dev);
+uint32_t DS18B20_ConversionTime_ms(DS18B20_t *dev);
 HAL_StatusTypeDef DS18B20_ReadROM(DS18B20_t *dev, uint8_t rom[8]);
 
 #endif /* DS18B20_H_ */
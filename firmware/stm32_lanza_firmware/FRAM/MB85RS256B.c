@@ -8,18 +8,109 @@
 #include "MB85RS256B.h"
 
 static inline void csLow(MB85RS256B_t *dev) {
-    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_RESET);
+    dev->cs_port->BRR = dev->cs_pin;
 }
 
 static inline void csHigh(MB85RS256B_t *dev) {
-    HAL_GPIO_WritePin(dev->cs_port, dev->cs_pin, GPIO_PIN_SET);
+    dev->cs_port->BSRR = dev->cs_pin;
+}
+
+static inline void latencyStart(uint32_t *start) {
+    *start = DWT->CYCCNT;
+}
+
+static inline void latencyStop(MB85RS256B_t *dev, uint32_t start) {
+    uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+    if (cyclesPerUs == 0) cyclesPerUs = 1;
+    dev->lastLatency_us = (DWT->CYCCNT - start) / cyclesPerUs;
+}
+
+static HAL_StatusTypeDef llTransfer(MB85RS256B_t *dev, const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    SPI_TypeDef *spi = dev->hspi->Instance;
+    uint32_t start = HAL_GetTick();
+
+    if (!LL_SPI_IsEnabled(spi)) LL_SPI_Enable(spi);
+
+    // Vaciar la FIFO RX (los envíos HAL dejan bytes sin leer)
+    while (LL_SPI_IsActiveFlag_RXNE(spi)) (void)LL_SPI_ReceiveData8(spi);
+
+    for (uint16_t i = 0; i < len; ++i) {
+        while (!LL_SPI_IsActiveFlag_TXE(spi)) {
+            if ((HAL_GetTick() - start) > MB85RS256B_TIMEOUT) return HAL_TIMEOUT;
+        }
+        LL_SPI_TransmitData8(spi, tx ? tx[i] : 0xFF);
+
+        while (!LL_SPI_IsActiveFlag_RXNE(spi)) {
+            if ((HAL_GetTick() - start) > MB85RS256B_TIMEOUT) return HAL_TIMEOUT;
+        }
+        uint8_t b = LL_SPI_ReceiveData8(spi);
+        if (rx) rx[i] = b;
+    }
+
+    while (LL_SPI_IsActiveFlag_BSY(spi)) {
+        if ((HAL_GetTick() - start) > MB85RS256B_TIMEOUT) return HAL_TIMEOUT;
+    }
+
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef dmaWait(MB85RS256B_t *dev) {
+    uint32_t start = HAL_GetTick();
+
+    // El núcleo duerme mientras el DMA mueve los datos
+    while (dev->dmaBusy) {
+        if ((HAL_GetTick() - start) > MB85RS256B_TIMEOUT) {
+            HAL_SPI_Abort(dev->hspi);
+            dev->dmaBusy = 0;
+            return HAL_TIMEOUT;
+        }
+        HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+    }
+
+    return dev->dmaStatus;
+}
+
+static uint8_t useDMA(MB85RS256B_t *dev, uint16_t len) {
+    if (dev->transport != MB85RS256B_XFER_AUTO) return 0;
+    if (len < MB85RS256B_DMA_THRESHOLD) return 0;
+
+    // Desde una interrupción no se puede esperar al DMA
+    if (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) return 0;
+
+    return (dev->hspi->hdmatx != NULL) && (dev->hspi->hdmarx != NULL);
 }
 
 static HAL_StatusTypeDef spiTransmit(MB85RS256B_t *dev, const uint8_t *buf, uint16_t len) {
+    if (useDMA(dev, len)) {
+        dev->dmaStatus = HAL_OK;
+        dev->dmaBusy = 1;
+        HAL_StatusTypeDef status = HAL_SPI_Transmit_DMA(dev->hspi, (uint8_t*)buf, len);
+        if (status != HAL_OK) {
+            dev->dmaBusy = 0;
+            return status;
+        }
+        return dmaWait(dev);
+    }
+
+    if (dev->transport != MB85RS256B_XFER_HAL) return llTransfer(dev, buf, NULL, len);
+
     return HAL_SPI_Transmit(dev->hspi, (uint8_t*)buf, len, MB85RS256B_TIMEOUT);
 }
 
 static HAL_StatusTypeDef spiReceive(MB85RS256B_t *dev, uint8_t *buf, uint16_t len) {
+    if (useDMA(dev, len)) {
+        dev->dmaStatus = HAL_OK;
+        dev->dmaBusy = 1;
+        HAL_StatusTypeDef status = HAL_SPI_Receive_DMA(dev->hspi, buf, len);
+        if (status != HAL_OK) {
+            dev->dmaBusy = 0;
+            return status;
+        }
+        return dmaWait(dev);
+    }
+
+    if (dev->transport != MB85RS256B_XFER_HAL) return llTransfer(dev, NULL, buf, len);
+
     return HAL_SPI_Receive(dev->hspi, buf, len, MB85RS256B_TIMEOUT);
 }
 
@@ -53,6 +144,13 @@ static HAL_StatusTypeDef readId(MB85RS256B_t *dev, uint8_t id[3]) {
 HAL_StatusTypeDef MB85RS256B_Init(MB85RS256B_t *dev) {
 	if (!dev || !dev->hspi || !dev->cs_port) return HAL_ERROR;
 
+	// Contador de ciclos para medir la latencia de cada llamada
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	dev->dmaBusy = 0;
+	dev->lastLatency_us = 0;
+
 	csHigh(dev);
 	HAL_Delay(1);
 
@@ -62,11 +160,20 @@ HAL_StatusTypeDef MB85RS256B_Init(MB85RS256B_t *dev) {
 }
 
 HAL_StatusTypeDef MB85RS256B_Read(MB85RS256B_t *dev, uint16_t addr, uint8_t *data, size_t len) {
-	if (!dev || !data) return HAL_ERROR;
-	if (len == 0) return HAL_OK;
+	if (!dev) return HAL_ERROR;
 
-	// Rango dentro de la FRAM
-	if ((uint32_t)addr + (uint32_t)len > MB85RS256B_SIZE) return HAL_ERROR;
+	uint32_t t0;
+	latencyStart(&t0);
+
+	// Rango dentro de la FRAM; las salidas sin transferencia también actualizan la latencia
+	if (!data || (uint32_t)addr + (uint32_t)len > MB85RS256B_SIZE) {
+		latencyStop(dev, t0);
+		return HAL_ERROR;
+	}
+	if (len == 0) {
+		latencyStop(dev, t0);
+		return HAL_OK;
+	}
 
 	uint8_t hdr[3];
 	hdr[0] = MB85RS256B_CMD_READ;
@@ -81,34 +188,76 @@ HAL_StatusTypeDef MB85RS256B_Read(MB85RS256B_t *dev, uint16_t addr, uint8_t *dat
 	}
 
 	csHigh(dev);
+
+	latencyStop(dev, t0);
 	return status;
 }
 
 HAL_StatusTypeDef MB85RS256B_Write(MB85RS256B_t *dev, uint16_t addr, const uint8_t *data, size_t len) {
-	if (!dev || !data) return HAL_ERROR;
-	if (len == 0) return HAL_OK;
+	if (len > UINT16_MAX) {
+		if (dev) dev->lastLatency_us = 0;
+		return HAL_ERROR;
+	}
 
-	// Rango dentro de la FRAM
-	if ((uint32_t)addr + (uint32_t)len > MB85RS256B_SIZE) return HAL_ERROR;
+	MB85RS256B_Seg_t seg = { .addr = addr, .data = data, .len = (uint16_t)len };
+	return MB85RS256B_Writev(dev, &seg, 1);
+}
 
-	HAL_StatusTypeDef status = writeEnable(dev);
-	if (status != HAL_OK) return status;
+/*
+ * Escribe los segmentos en orden. Los contiguos sin barrier se fusionan en un
+ * mismo ciclo WRITE; la FRAM graba en orden de dirección, así que un corte deja
+ * siempre un prefijo de la lista. WEL se borra solo al subir CS tras cada WRITE:
+ * hace falta un WREN por ciclo y ningún WRDI.
+ */
+HAL_StatusTypeDef MB85RS256B_Writev(MB85RS256B_t *dev, const MB85RS256B_Seg_t *seg, size_t n) {
+	if (!dev) return HAL_ERROR;
 
-	uint8_t hdr[3];
-	hdr[0] = MB85RS256B_CMD_WRITE;
-	hdr[1] = (uint8_t)(addr >> 8);
-	hdr[2] = (uint8_t)(addr & 0xFF);
+	uint32_t t0;
+	latencyStart(&t0);
 
-	csLow(dev);
+	HAL_StatusTypeDef status = seg ? HAL_OK : HAL_ERROR;
 
-	status = spiTransmit(dev, hdr, sizeof(hdr));
-	if (status == HAL_OK) {
-		status = spiTransmit(dev, data, (uint16_t)len);
+	// Rango dentro de la FRAM
+	for (size_t k = 0; status == HAL_OK && k < n; ++k) {
+		if (seg[k].len > 0 && !seg[k].data) status = HAL_ERROR;
+		if ((uint32_t)seg[k].addr + (uint32_t)seg[k].len > MB85RS256B_SIZE) status = HAL_ERROR;
 	}
 
-	csHigh(dev);
+	size_t i = 0;
 
-	writeDisable(dev);
+	while (i < n && status == HAL_OK) {
+		if (seg[i].len == 0) {
+			i++;
+			continue;
+		}
+
+		status = writeEnable(dev);
+		if (status != HAL_OK) break;
+
+		uint8_t hdr[3];
+		hdr[0] = MB85RS256B_CMD_WRITE;
+		hdr[1] = (uint8_t)(seg[i].addr >> 8);
+		hdr[2] = (uint8_t)(seg[i].addr & 0xFF);
+
+		csLow(dev);
 
+		status = spiTransmit(dev, hdr, sizeof(hdr));
+
+		uint32_t end = seg[i].addr;
+		do {
+			if (status == HAL_OK && seg[i].len > 0) status = spiTransmit(dev, seg[i].data, seg[i].len);
+			end += seg[i].len;
+			i++;
+		} while (i < n && !seg[i].barrier && seg[i].addr == end);
+
+		csHigh(dev);
+	}
+
+	latencyStop(dev, t0);
 	return status;
 }
+
+void MB85RS256B_DMACallback(MB85RS256B_t *dev, HAL_StatusTypeDef status) {
+	dev->dmaStatus = status;
+	dev->dmaBusy = 0;
+}
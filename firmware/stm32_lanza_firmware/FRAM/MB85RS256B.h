@@ -9,6 +9,7 @@
 #define MB85RS256B_H_
 
 #include "stm32wbxx_hal.h"
+#include "stm32wbxx_ll_spi.h"
 
 #define MB85RS256B_SIZE 		32768
 
@@ -23,15 +24,39 @@
 
 #define MB85RS256B_TIMEOUT		50
 
+#define MB85RS256B_DMA_THRESHOLD	64	// Transfers from this length go through DMA (AUTO)
+
+// Transport
+typedef enum {
+	MB85RS256B_XFER_HAL = 0,	// Blocking HAL_SPI calls
+	MB85RS256B_XFER_LL,			// Register polling
+	MB85RS256B_XFER_AUTO		// Register polling for short frames, DMA for bulk transfers
+} MB85RS256B_Transport_t;
+
 typedef struct {
     SPI_HandleTypeDef *hspi;
     GPIO_TypeDef *cs_port;
     uint16_t cs_pin;
+    MB85RS256B_Transport_t transport;
+    volatile uint8_t dmaBusy;
+    volatile HAL_StatusTypeDef dmaStatus;
+    uint32_t lastLatency_us;	// Duration of the last Read/Write call
 } MB85RS256B_t;
 
+// Scatter list entry for MB85RS256B_Writev
+typedef struct {
+    uint16_t addr;
+    const uint8_t *data;
+    uint16_t len;
+    uint8_t barrier;			// Never merged with the previous segment: starts a new WRITE cycle
+} MB85RS256B_Seg_t;
+
 HAL_StatusTypeDef MB85RS256B_Init(MB85RS256B_t *dev);
 
 HAL_StatusTypeDef MB85RS256B_Read(MB85RS256B_t *dev, uint16_t addr, uint8_t *data, size_t len);
 HAL_StatusTypeDef MB85RS256B_Write(MB85RS256B_t *dev, uint16_t addr, const uint8_t *data, size_t len);
+HAL_StatusTypeDef MB85RS256B_Writev(MB85RS256B_t *dev, const MB85RS256B_Seg_t *seg, size_t n);
+
+void MB85RS256B_DMACallback(MB85RS256B_t *dev, HAL_StatusTypeDef status);
 
 #endif /* MB85RS256B_H_ */
@@ -7,80 +7,985 @@
 
 #include "fram.h"
 
-static uint16_t crc16_ccitt_false(const uint8_t *data, size_t len) {
-    uint16_t crc = 0xFFFF;
-    for (size_t i = 0; i < len; i++) {
-        crc ^= (uint16_t)data[i] << 8;
-        for (int b = 0; b < 8; b++) {
-            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
-        }
-    }
-    return crc;
-}
-
 static uint8_t metaIsValid(MetaFrame_t *meta) {
     if (meta->commit != FRAM_META_COMMIT_VALUE) return 0;
     if (meta->write_idx >= FRAM_DATA_SLOTS) return 0;
     if (meta->count > FRAM_DATA_SLOTS) return 0;
 
-    return (meta->crc == crc16_ccitt_false((const uint8_t *)meta, offsetof(MetaFrame_t, crc)));
+    return (meta->crc == FRAM_Crc16((const uint8_t *)meta, offsetof(MetaFrame_t, crc)));
+}
+
+// En FRAM_LAYOUT_SEQ el CRC cubre también la secuencia (bytes tras el commit)
+static uint16_t frameCrc(FramLayout_t layout, const DataFrame_t *frame) {
+	uint16_t crc = FRAM_Crc16((const uint8_t*)frame, offsetof(DataFrame_t, crc));
+	if (layout != FRAM_LAYOUT_SEQ) return crc;
+
+	const uint8_t *tail = (const uint8_t*)frame + offsetof(DataFrame_t, gen);
+	return FRAM_Crc16Update(crc, tail, sizeof(DataFrame_t) - offsetof(DataFrame_t, gen));
 }
 
-static uint8_t frameIsValid(const DataFrame_t *frame) {
+static uint8_t frameIsValid(const FramRing_t *mem, const DataFrame_t *frame) {
     if (frame->commit != FRAM_FRAME_COMMIT_VALUE) return 0;
 
-    return (frame->crc == crc16_ccitt_false((const uint8_t*)frame, offsetof(DataFrame_t, crc)));
+    // Tramas de una generación anterior equivalen a slots borrados
+    if (mem->layout == FRAM_LAYOUT_SEQ && frame->gen != mem->gen) return 0;
+
+    return (frame->crc == frameCrc(mem->layout, frame));
 }
 
-static inline uint8_t seqIsNewer(uint8_t a, uint8_t b) {
-	return (uint8_t)((uint8_t)(a - b) < 128);
+static uint16_t genCrc(const GenFrame_t *rec) {
+	uint16_t crc = FRAM_Crc16((const uint8_t *)rec, offsetof(GenFrame_t, crc));
+
+	const uint8_t *tail = (const uint8_t*)rec + offsetof(GenFrame_t, format);
+	return FRAM_Crc16Update(crc, tail, sizeof(GenFrame_t) - offsetof(GenFrame_t, format));
+}
+
+static uint8_t genIsValid(const GenFrame_t *rec) {
+	if (rec->commit != FRAM_GEN_COMMIT_VALUE) return 0;
+	uint8_t format = rec->format & (uint8_t)~FRAM_GEN_FORMAT_TIERS;
+	if (format < FRAM_FORMAT_V1 || format > FRAM_FORMAT_BLOCK) return 0;
+
+	return (rec->crc == genCrc(rec));
 }
 
-static HAL_StatusTypeDef metaClear(MB85RS256B_t *fram, uint16_t addr) {
+static HAL_StatusTypeDef metaClear(FramDev_t *dev, uint16_t addr) {
     MetaFrame_t meta = {0};
 
-    return MB85RS256B_Write(fram, addr, (const uint8_t*)&meta, sizeof(meta));
+    return FRAM_DevWrite(dev, addr, (const uint8_t*)&meta, sizeof(meta));
 }
 
-static HAL_StatusTypeDef metaWriteSafe(MB85RS256B_t *fram, uint16_t addr, MetaFrame_t *meta) {
+static HAL_StatusTypeDef metaWriteSafe(FramDev_t *dev, uint16_t addr, MetaFrame_t *meta) {
 	meta->commit = 0;
-	meta->crc = crc16_ccitt_false((const uint8_t*)meta, offsetof(MetaFrame_t, crc));
+	meta->crc = FRAM_Crc16((const uint8_t*)meta, offsetof(MetaFrame_t, crc));
 
-    HAL_StatusTypeDef status = MB85RS256B_Write(fram, addr, (const uint8_t*)meta, sizeof(*meta));
-    if (status != HAL_OK) return status;
+    return FRAM_DevWriteCommitted(dev, addr, meta, sizeof(*meta), offsetof(MetaFrame_t, commit), FRAM_META_COMMIT_VALUE);
+}
 
-    uint8_t c = FRAM_META_COMMIT_VALUE;
-    return MB85RS256B_Write(fram, (uint16_t)(addr + offsetof(MetaFrame_t, commit)), &c, 1);
+static HAL_StatusTypeDef genWriteSafe(FramDev_t *dev, uint16_t addr, GenFrame_t *rec) {
+	rec->commit = 0;
+	rec->crc = genCrc(rec);
+
+	return FRAM_DevWriteCommitted(dev, addr, rec, sizeof(*rec), offsetof(GenFrame_t, commit), FRAM_GEN_COMMIT_VALUE);
+}
+
+// Registro A/B: se escribe siempre en la copia que no contiene el vigente
+static HAL_StatusTypeDef genCommit(FramRing_t *mem) {
+	GenFrame_t rec = {0};
+	rec.gen = mem->gen;
+	rec.seq = (uint8_t)(mem->gen_seq + 1);
+	rec.format = (uint8_t)mem->format | (mem->tiers ? FRAM_GEN_FORMAT_TIERS : 0);
+	rec.lap = mem->lap;
+
+	uint16_t addr = (rec.seq & 1) ? FRAM_GEN_B_START : FRAM_GEN_A_START;
+	HAL_StatusTypeDef status = genWriteSafe(mem->dev, addr, &rec);
+	if (status != HAL_OK) return status;
+
+	mem->gen_seq = rec.seq;
+	return HAL_OK;
 }
 
-static HAL_StatusTypeDef dataWriteSafe(MB85RS256B_t *fram, uint16_t addr, DataSample_t *data) {
-	DataFrame_t frame = {0};
-	frame.data = *data;
-	frame.commit = 0;
+// Los slots dependen de si la FRAM está particionada (setTiers antes que setFormat)
+static void setFormat(FramRing_t *mem, FramFormat_t format) {
+	uint32_t end = mem->tiers ? FRAM_TIER_RAW_END : FRAM_SIZE;
+
+	mem->format = format;
+	mem->slots = (format == FRAM_FORMAT_V2) ? (uint16_t)((end - FRAM_DATA_START) / FRAM_SLOT_SIZE_V2) :
+				 (format == FRAM_FORMAT_BLOCK) ? (uint16_t)((end - FRAM_BLOCK_RING_START) / FRAM_BLOCK_SIZE) :
+				 (uint16_t)((end - FRAM_DATA_START) / FRAM_SLOT_SIZE);
+}
 
-	frame.crc = crc16_ccitt_false((const uint8_t*)&frame, offsetof(DataFrame_t, crc));
+static void setTiers(FramRing_t *mem, uint8_t enable) {
+	static const uint16_t start[FRAM_TIER_COUNT] = { FRAM_TIER_HOURLY_START, FRAM_TIER_DAILY_START };
+	static const uint16_t slots[FRAM_TIER_COUNT] = { FRAM_TIER_HOURLY_SLOTS, FRAM_TIER_DAILY_SLOTS };
+	static const uint32_t span[FRAM_TIER_COUNT] = { 3600, 86400 };
+
+	mem->tiers = enable ? 1 : 0;
+
+	for (uint8_t id = 0; id < FRAM_TIER_COUNT; ++id) {
+		FramTier_t *tier = &mem->tier[id];
+		tier->start = start[id];
+		tier->slots = slots[id];
+		tier->span_s = span[id];
+		tier->next_seq = 0;
+		tier->count = 0;
+		FRAM_AggClear(&tier->open, 0, span[id]);
+	}
+}
 
-	HAL_StatusTypeDef status = MB85RS256B_Write(fram, addr, (const uint8_t*)&frame, sizeof(frame));
+static inline uint16_t slotSize(const FramRing_t *mem) {
+	return (mem->format == FRAM_FORMAT_V2) ? FRAM_SLOT_SIZE_V2 :
+		   (mem->format == FRAM_FORMAT_BLOCK) ? FRAM_BLOCK_SIZE : FRAM_SLOT_SIZE;
+}
+
+static inline uint16_t dataSlotAddr(const FramRing_t *mem, uint16_t slot_idx) {
+	uint16_t start = (mem->format == FRAM_FORMAT_BLOCK) ? FRAM_BLOCK_RING_START : FRAM_DATA_START;
+    return (uint16_t)(start + slot_idx * slotSize(mem));
+}
+
+// Bits de generación que caben en cada formato
+static inline uint8_t genMask(const FramRing_t *mem) {
+	return (mem->format == FRAM_FORMAT_V2) ? FRAM_V2_GEN_MASK : 0xFF;
+}
+
+// Conversión fecha <-> epoch Unix (algoritmo days-from-civil)
+static uint32_t dateToEpoch(const DataSample_t *d) {
+	int32_t y = 2000 + d->year;
+	int32_t m = d->month;
+	y -= (m <= 2);
+
+	int32_t era = y / 400;
+	int32_t yoe = y - era * 400;
+	int32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d->day - 1;
+	int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	int32_t days = era * 146097 + doe - 719468;
+
+	return (uint32_t)days * 86400u + d->hours * 3600u + d->minutes * 60u + d->seconds;
+}
+
+static void epochToDate(uint32_t t, DataSample_t *d) {
+	int32_t days = (int32_t)(t / 86400u);
+	uint32_t sec = t % 86400u;
+
+	d->hours = (uint8_t)(sec / 3600);
+	d->minutes = (uint8_t)((sec / 60) % 60);
+	d->seconds = (uint8_t)(sec % 60);
+
+	days += 719468;
+	int32_t era = days / 146097;
+	int32_t doe = days - era * 146097;
+	int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int32_t mp = (5 * doy + 2) / 153;
+	int32_t m = mp + (mp < 10 ? 3 : -9);
+	int32_t y = yoe + era * 400 + (m <= 2);
+
+	d->day = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+	d->month = (uint8_t)m;
+	d->year = (uint8_t)(y - 2000);
+}
+
+static int32_t scaleRound(float x, float k) {
+	float v = x * k;
+	return (int32_t)(v + ((v >= 0.0f) ? 0.5f : -0.5f));
+}
+
+static int16_t toTemp_cC(float x) {
+	int32_t v = scaleRound(x, 100.0f);
+	if (v <= INT16_MIN) v = INT16_MIN + 1;
+	if (v > INT16_MAX) v = INT16_MAX;
+	return (int16_t)v;
+}
+
+static uint16_t toU16(float x, float k) {
+	int32_t v = scaleRound(x, k);
+	if (v < 0) v = 0;
+	if (v >= FRAM_V2_U16_INVALID) v = FRAM_V2_U16_INVALID - 1;
+	return (uint16_t)v;
+}
+
+static uint8_t sampleBitValid(const DataSample_t *d, uint8_t bit) {
+	return (d->validDataVector == 0) || VALID_BIT_IS_SET(d->validDataVector, bit);
+}
+
+// Epoch Unix de la muestra, 0 si no tiene hora válida
+static uint32_t sampleTime(const DataSample_t *d) {
+	uint8_t timeValid = sampleBitValid(d, HOURS_BIT) && sampleBitValid(d, MINUTES_BIT) &&
+						sampleBitValid(d, SECONDS_BIT) && sampleBitValid(d, DAY_BIT) &&
+						sampleBitValid(d, MONTH_BIT) && sampleBitValid(d, YEAR_BIT) &&
+						d->month >= 1 && d->month <= 12 && d->day >= 1;
+
+	return timeValid ? dateToEpoch(d) : 0;
+}
+
+static void sampleToV2(const DataSample_t *d, SampleV2_t *r) {
+	r->timestamp = sampleTime(d);
+	r->airTemp_cC = sampleBitValid(d, AIR_TEMP_BIT) ? toTemp_cC(d->airTemp_C) : FRAM_V2_TEMP_INVALID;
+	r->soilTemp_cC = sampleBitValid(d, SOIL_TEMP_BIT) ? toTemp_cC(d->soilTemp_C) : FRAM_V2_TEMP_INVALID;
+	r->irradiance_dWm2 = sampleBitValid(d, IRRADIANCE_BIT) ? toU16(d->irradiance_Wm2, 10.0f) : FRAM_V2_U16_INVALID;
+	r->batteryVoltage_mV = !sampleBitValid(d, BATT_VOLT_BIT) ? FRAM_V2_U16_INVALID :
+						   (d->batteryVoltage_mV < FRAM_V2_U16_INVALID) ? d->batteryVoltage_mV : FRAM_V2_U16_INVALID - 1;
+	r->airHumidity_perc = sampleBitValid(d, AIR_HUM_BIT) ? d->airHumidity_perc : FRAM_V2_U8_INVALID;
+	r->soilMoisture_perc = sampleBitValid(d, SOIL_MOIST_BIT) ? d->soilMoisture_perc : FRAM_V2_U8_INVALID;
+}
+
+static void sampleFromV2(const SampleV2_t *r, DataSample_t *d) {
+	*d = (DataSample_t){0};
+
+	if (r->timestamp != 0) {
+		epochToDate(r->timestamp, d);
+		for (uint8_t bit = HOURS_BIT; bit <= YEAR_BIT; ++bit) VALID_BIT_SET(d->validDataVector, bit);
+	}
+	if (r->airTemp_cC != FRAM_V2_TEMP_INVALID) {
+		d->airTemp_C = r->airTemp_cC / 100.0f;
+		VALID_BIT_SET(d->validDataVector, AIR_TEMP_BIT);
+	}
+	if (r->soilTemp_cC != FRAM_V2_TEMP_INVALID) {
+		d->soilTemp_C = r->soilTemp_cC / 100.0f;
+		VALID_BIT_SET(d->validDataVector, SOIL_TEMP_BIT);
+	}
+	if (r->irradiance_dWm2 != FRAM_V2_U16_INVALID) {
+		d->irradiance_Wm2 = r->irradiance_dWm2 / 10.0f;
+		VALID_BIT_SET(d->validDataVector, IRRADIANCE_BIT);
+	}
+	if (r->batteryVoltage_mV != FRAM_V2_U16_INVALID) {
+		d->batteryVoltage_mV = r->batteryVoltage_mV;
+		VALID_BIT_SET(d->validDataVector, BATT_VOLT_BIT);
+	}
+	if (r->airHumidity_perc != FRAM_V2_U8_INVALID) {
+		d->airHumidity_perc = r->airHumidity_perc;
+		VALID_BIT_SET(d->validDataVector, AIR_HUM_BIT);
+	}
+	if (r->soilMoisture_perc != FRAM_V2_U8_INVALID) {
+		d->soilMoisture_perc = r->soilMoisture_perc;
+		VALID_BIT_SET(d->validDataVector, SOIL_MOIST_BIT);
+	}
+}
+
+static inline uint8_t v2Crc(const SampleV2_t *r) {
+	const uint8_t *body = (const uint8_t*)r + offsetof(SampleV2_t, irradiance_dWm2);
+	return (uint8_t)FRAM_Crc16(body, sizeof(SampleV2_t) - offsetof(SampleV2_t, irradiance_dWm2));
+}
+
+static void frameImage(const FramRing_t *mem, const DataSample_t *data, uint32_t seq, DataFrame_t *frame) {
+	*frame = (DataFrame_t){0};
+	frame->data = *data;
+	frame->commit = 0;
+	if (mem->layout == FRAM_LAYOUT_SEQ) {
+		frame->gen = mem->gen;
+		frame->seq = seq;
+	}
+
+	frame->crc = frameCrc(mem->layout, frame);
+}
+
+static HAL_StatusTypeDef dataWriteSafe(FramRing_t *mem, uint16_t addr, DataSample_t *data, uint32_t seq) {
+	DataFrame_t frame;
+	frameImage(mem, data, seq, &frame);
+
+	return FRAM_DevWriteCommitted(mem->dev, addr, &frame, sizeof(frame), offsetof(DataFrame_t, commit), FRAM_FRAME_COMMIT_VALUE);
+}
+
+// Imagen v1/v2 de la muestra con el commit a 0; devuelve el valor del byte de commit
+static uint8_t slotImage(const FramRing_t *mem, const DataSample_t *data, uint32_t seq, uint8_t *buf) {
+	if (mem->format != FRAM_FORMAT_V2) {
+		DataFrame_t frame;
+		frameImage(mem, data, seq, &frame);
+		memcpy(buf, &frame, sizeof(frame));
+		return FRAM_FRAME_COMMIT_VALUE;
+	}
+
+	SampleV2_t rec = {0};
+	sampleToV2(data, &rec);
+	rec.commit = 0;
+	rec.crc = v2Crc(&rec);
+	memcpy(buf, &rec, sizeof(rec));
+
+	// La paridad de vuelta sustituye a la secuencia completa de v1
+	uint8_t c = FRAM_V2_COMMIT_MARK | (mem->gen & FRAM_V2_GEN_MASK);
+	if ((seq / mem->slots) & 1) c |= FRAM_V2_COMMIT_LAP;
+	return c;
+}
+
+// Último bloque cerrado leído: las lecturas secuenciales no repiten la búsqueda
+static FramBlockImage_t cache;
+static uint8_t cacheValid = 0;
+
+static void sampleToBlock(const DataSample_t *d, BlockSample_t *s) {
+	SampleV2_t r;
+	sampleToV2(d, &r);
+
+	s->timestamp = r.timestamp;
+	s->irradiance_dWm2 = r.irradiance_dWm2;
+	s->batteryVoltage_mV = r.batteryVoltage_mV;
+	s->airTemp_cC = r.airTemp_cC;
+	s->soilTemp_cC = r.soilTemp_cC;
+	s->airHumidity_perc = r.airHumidity_perc;
+	s->soilMoisture_perc = r.soilMoisture_perc;
+}
+
+static void sampleFromBlock(const BlockSample_t *s, DataSample_t *d) {
+	SampleV2_t r = {0};
+	r.timestamp = s->timestamp;
+	r.irradiance_dWm2 = s->irradiance_dWm2;
+	r.batteryVoltage_mV = s->batteryVoltage_mV;
+	r.airTemp_cC = s->airTemp_cC;
+	r.soilTemp_cC = s->soilTemp_cC;
+	r.airHumidity_perc = s->airHumidity_perc;
+	r.soilMoisture_perc = s->soilMoisture_perc;
+
+	sampleFromV2(&r, d);
+}
+
+// Bloque completo (128 bytes, el CRC cubre también el relleno) con el commit al final
+static HAL_StatusTypeDef blockWriteSafe(FramRing_t *mem, uint16_t addr, FramBlock_t *blk) {
+	FRAM_BlockSeal(blk);
+
+	return FRAM_DevWriteCommitted(mem->dev, addr, &blk->img, sizeof(blk->img), offsetof(FramBlockImage_t, commit), FRAM_BLOCK_COMMIT_VALUE);
+}
+
+// Bloque abierto: se alterna entre las copias A/B para no perder nunca la última válida
+static HAL_StatusTypeDef blockStage(FramRing_t *mem) {
+	uint16_t addr = mem->blk_stage ? FRAM_BLOCK_STAGE_B : FRAM_BLOCK_STAGE_A;
+
+	HAL_StatusTypeDef status = blockWriteSafe(mem, addr, &mem->blk);
 	if (status != HAL_OK) return status;
 
-	uint8_t c = FRAM_FRAME_COMMIT_VALUE;
-	return MB85RS256B_Write(fram, (uint16_t)(addr + offsetof(DataFrame_t, commit)), &c, 1);
+	mem->blk_stage ^= 1;
+	return HAL_OK;
 }
 
-static inline uint16_t dataSlotAddr(uint16_t slot_idx) {
-    return (uint16_t)(FRAM_DATA_START + slot_idx * FRAM_SLOT_SIZE);
+static HAL_StatusTypeDef blockRead(FramRing_t *mem, uint16_t addr, FramBlockImage_t *img, uint8_t *valid) {
+	HAL_StatusTypeDef status = FRAM_DevRead(mem->dev, addr, (uint8_t *)img, sizeof(*img));
+	if (status != HAL_OK) return status;
+
+	*valid = FRAM_BlockIsValid(img, mem->gen);
+	return HAL_OK;
 }
 
-HAL_StatusTypeDef FRAM_SelfTest(MB85RS256B_t *fram) {
+// Cierra el bloque abierto en su slot del anillo y abre el siguiente
+static HAL_StatusTypeDef blockFlush(FramRing_t *mem) {
+	HAL_StatusTypeDef status;
+	uint32_t blockSeq = mem->blk.img.blockSeq;
+	uint16_t slot = (uint16_t)(blockSeq % mem->slots);
+	uint16_t evicted = 0;
+
+	// Anillo lleno: las muestras del bloque sobrescrito dejan de contar
+	if (blockSeq >= mem->slots) {
+		FramBlockImage_t old;
+		uint8_t valid;
+
+		status = blockRead(mem, dataSlotAddr(mem, slot), &old, &valid);
+		if (status != HAL_OK) return status;
+
+		if (valid && old.blockSeq + mem->slots == blockSeq) evicted = old.count;
+	}
+
+	status = blockWriteSafe(mem, dataSlotAddr(mem, slot), &mem->blk);
+	if (status != HAL_OK) return status;
+
+	mem->count = (uint16_t)(mem->count - evicted);
+	mem->write_idx = (uint16_t)((slot + 1) % mem->slots);
+	FRAM_BlockBegin(&mem->blk, blockSeq + 1, mem->next_seq, mem->gen);
+	return HAL_OK;
+}
+
+// Añade n muestras al bloque abierto (cerrando los que se llenen) y guarda la copia A/B una sola vez
+static HAL_StatusTypeDef blockSave(FramRing_t *mem, const DataSample_t *data, uint8_t n) {
+	HAL_StatusTypeDef status;
+	BlockSample_t s;
+
+	for (uint8_t i = 0; i < n; ++i) {
+		sampleToBlock(&data[i], &s);
+
+		if (!FRAM_BlockAppend(&mem->blk, &s)) {
+			status = blockFlush(mem);
+			if (status != HAL_OK) return status;
+
+			(void)FRAM_BlockAppend(&mem->blk, &s);
+		}
+
+		mem->next_seq++;
+		mem->count++;
+	}
+
+	return blockStage(mem);
+}
+
+/*
+ * Lee un slot en cualquier formato. lapTag identifica la vuelta del anillo:
+ * la vuelta completa en v1 (seq / N) y solo su paridad en v2.
+ */
+// Slot v1 o v2 ya leído de la FRAM
+static void decodeSlot(const FramRing_t *mem, uint16_t slot, const uint8_t *buf, DataSample_t *data, uint8_t *valid, uint32_t *lapTag) {
+	if (mem->format == FRAM_FORMAT_V2) {
+		SampleV2_t rec;
+		memcpy(&rec, buf, sizeof(rec));
+
+		*valid = (rec.commit & FRAM_V2_COMMIT_MARK) &&
+				 ((rec.commit & FRAM_V2_GEN_MASK) == (mem->gen & FRAM_V2_GEN_MASK)) &&
+				 (rec.crc == v2Crc(&rec));
+		if (lapTag) *lapTag = (rec.commit & FRAM_V2_COMMIT_LAP) ? 1 : 0;
+		if (data) sampleFromV2(&rec, data);
+		return;
+	}
+
+	DataFrame_t frame;
+	memcpy(&frame, buf, sizeof(frame));
+
+	*valid = frameIsValid(mem, &frame);
+	if (mem->layout == FRAM_LAYOUT_SEQ && (frame.seq % mem->slots) != slot) *valid = 0;
+	if (lapTag) *lapTag = frame.seq / mem->slots;
+	if (data) *data = frame.data;
+}
+
+static HAL_StatusTypeDef readSlot(FramRing_t *mem, uint16_t slot, DataSample_t *data, uint8_t *valid, uint32_t *lapTag) {
+	HAL_StatusTypeDef status;
+	uint16_t addr = dataSlotAddr(mem, slot);
+
+	// Bloques: solo cabecera (las muestras se leen con FRAM_GetSample)
+	if (mem->format == FRAM_FORMAT_BLOCK) {
+		FramBlockImage_t img;
+		status = blockRead(mem, addr, &img, valid);
+		if (status != HAL_OK) return status;
+
+		if ((img.blockSeq % mem->slots) != slot) *valid = 0;
+		if (lapTag) *lapTag = img.blockSeq / mem->slots;
+		if (data) *data = (DataSample_t){0};
+		return HAL_OK;
+	}
+
+	uint8_t buf[FRAM_SLOT_SIZE];
+	status = FRAM_DevRead(mem->dev, addr, buf, slotSize(mem));
+	if (status != HAL_OK) return status;
+
+	decodeSlot(mem, slot, buf, data, valid, lapTag);
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef genRecover(FramRing_t *mem) {
+	HAL_StatusTypeDef status;
+	GenFrame_t recA, recB;
+
+	status = FRAM_DevRead(mem->dev, FRAM_GEN_A_START, (uint8_t *)&recA, sizeof(recA));
+	if (status != HAL_OK) return status;
+	status = FRAM_DevRead(mem->dev, FRAM_GEN_B_START, (uint8_t *)&recB, sizeof(recB));
+	if (status != HAL_OK) return status;
+
+	uint8_t validA = genIsValid(&recA);
+	uint8_t validB = genIsValid(&recB);
+
+	if (validA || validB) {
+		const GenFrame_t *best = (validA && validB) ? (FRAM_SeqIsNewer(recA.seq, recB.seq) ? &recA : &recB)
+													: (validA ? &recA : &recB);
+		mem->gen = best->gen;
+		mem->gen_seq = best->seq;
+		mem->lap = best->lap;
+		setTiers(mem, best->format & FRAM_GEN_FORMAT_TIERS);
+		setFormat(mem, (FramFormat_t)(best->format & (uint8_t)~FRAM_GEN_FORMAT_TIERS));
+		return HAL_OK;
+	}
+
+	// Sin registro: generación 0 en v1 (tramas escritas antes de existir el registro)
+	mem->gen = 0;
+	mem->gen_seq = 0xFF;
+	mem->lap = 0;
+	setTiers(mem, 0);
+	setFormat(mem, FRAM_FORMAT_V1);
+	return genCommit(mem);
+}
+
+// Vuelta absoluta a partir de la etiqueta leída del slot
+static uint32_t lapFromTag(const FramRing_t *mem, uint32_t tag) {
+	if (mem->format != FRAM_FORMAT_V2) return tag;
+
+	// La cabecera se actualiza después del slot 0: puede ir una vuelta por detrás
+	return ((mem->lap & 1) == tag) ? mem->lap : (uint32_t)mem->lap + 1;
+}
+
+static inline uint16_t tierAddr(const FramTier_t *tier, uint16_t slot) {
+	return (uint16_t)(tier->start + slot * FRAM_AGG_RECORD_SIZE);
+}
+
+static HAL_StatusTypeDef tierRead(FramRing_t *mem, const FramTier_t *tier, uint16_t slot, FramAggRecord_t *rec, uint8_t *valid) {
+	HAL_StatusTypeDef status = FRAM_DevRead(mem->dev, tierAddr(tier, slot), (uint8_t *)rec, sizeof(*rec));
+	if (status != HAL_OK) return status;
+
+	*valid = FRAM_AggRecordIsValid(rec, mem->gen) && (rec->seq % tier->slots) == slot;
+	return HAL_OK;
+}
+
+typedef struct {
+	FramRing_t *mem;
+	const FramTier_t *tier;			// NULL: anillo de muestras
+} RingProbe_t;
+
+// Slot del anillo de muestras o de un anillo de agregados, con su vuelta absoluta
+static HAL_StatusTypeDef probeSlot(void *ctx, uint16_t slot, uint8_t *valid, uint32_t *lap) {
+	RingProbe_t *probe = ctx;
+	HAL_StatusTypeDef status;
+	uint32_t tag = 0;
+
+	if (!probe->tier) {
+		status = readSlot(probe->mem, slot, NULL, valid, &tag);
+		if (status != HAL_OK) return status;
+
+		if (lap) *lap = lapFromTag(probe->mem, tag);
+		return HAL_OK;
+	}
+
+	FramAggRecord_t rec;
+	status = tierRead(probe->mem, probe->tier, slot, &rec, valid);
+	if (status != HAL_OK) return status;
+
+	if (lap) *lap = rec.seq / probe->tier->slots;
+	return HAL_OK;
+}
+
+// Cabeza del anillo de muestras (tier = NULL) o de uno de agregados (fram_seq.c)
+static HAL_StatusTypeDef seqRecover(FramRing_t *mem, const FramTier_t *tier, uint32_t *next, uint16_t *used) {
+	RingProbe_t probe = { .mem = mem, .tier = tier };
+
+	return FRAM_SeqRecover(tier ? tier->slots : mem->slots, probeSlot, &probe, next, used);
+}
+
+static HAL_StatusTypeDef slotRecover(FramRing_t *mem) {
+	uint32_t next;
+	uint16_t used;
+
+	HAL_StatusTypeDef status = seqRecover(mem, NULL, &next, &used);
+	if (status != HAL_OK) return status;
+
+	mem->next_seq = next;
+	mem->write_idx = (uint16_t)(next % mem->slots);
+	mem->count = used;
+	return HAL_OK;
+}
+
+/*
+ * Formato por bloques: la cabeza del anillo se busca igual que con los slots,
+ * usando la secuencia de bloque. El bloque abierto se recupera de la copia A/B
+ * más completa que corresponda al siguiente bloque del anillo.
+ */
+static HAL_StatusTypeDef blockRecover(FramRing_t *mem) {
+	HAL_StatusTypeDef status;
+	FramBlockImage_t img;
+	uint8_t valid;
+	uint32_t nextBlock;
+	uint16_t blocks;
+
+	status = seqRecover(mem, NULL, &nextBlock, &blocks);
+	if (status != HAL_OK) return status;
+
+	mem->write_idx = (uint16_t)(nextBlock % mem->slots);
+
+	// Primera y siguiente secuencia de muestra guardadas en el anillo
+	uint32_t firstSeq = 0, endSeq = 0;
+	if (blocks > 0) {
+		status = blockRead(mem, dataSlotAddr(mem, (uint16_t)((nextBlock - 1) % mem->slots)), &img, &valid);
+		if (status != HAL_OK) return status;
+		endSeq = img.firstSeq + img.count;
+
+		status = blockRead(mem, dataSlotAddr(mem, (uint16_t)((nextBlock - blocks) % mem->slots)), &img, &valid);
+		if (status != HAL_OK) return status;
+		firstSeq = img.firstSeq;
+	}
+
+	// Copia A/B más completa del bloque que sigue al último cerrado
+	uint16_t stage[2] = { FRAM_BLOCK_STAGE_A, FRAM_BLOCK_STAGE_B };
+	uint8_t bestCount = 0, best = 0;
+
+	for (uint8_t copy = 0; copy < 2; ++copy) {
+		status = blockRead(mem, stage[copy], &img, &valid);
+		if (status != HAL_OK) return status;
+
+		if (!valid || img.blockSeq != nextBlock || img.firstSeq != endSeq || img.count <= bestCount) continue;
+
+		bestCount = img.count;
+		best = copy;
+	}
+
+	mem->blk_stage = 0;
+	FRAM_BlockBegin(&mem->blk, nextBlock, endSeq, mem->gen);
+
+	if (bestCount > 0) {
+		status = blockRead(mem, stage[best], &img, &valid);
+		if (status != HAL_OK) return status;
+
+		if (FRAM_BlockResume(&mem->blk, &img)) mem->blk_stage = best ^ 1;
+		else FRAM_BlockBegin(&mem->blk, nextBlock, endSeq, mem->gen);
+	}
+
+	mem->next_seq = endSeq + mem->blk.img.count;
+	mem->count = (uint16_t)(mem->next_seq - firstSeq);
+	return HAL_OK;
+}
+
+// Muestra seq dentro del bloque abierto o de un bloque del anillo
+static HAL_StatusTypeDef blockGetSample(FramRing_t *mem, uint32_t seq, DataSample_t *data, uint8_t *valid) {
+	const FramBlockImage_t *img = &mem->blk.img;
+
+	if (seq < mem->blk.img.firstSeq) {
+		// Búsqueda binaria por firstSeq entre los bloques cerrados del anillo
+		uint32_t top = mem->blk.img.blockSeq;
+		uint32_t lo = (top > mem->slots) ? top - mem->slots : 0;
+		uint32_t hi = top;
+
+		if (!(cacheValid && cache.gen == mem->gen && cache.blockSeq >= lo && cache.blockSeq < hi &&
+			  seq >= cache.firstSeq && seq - cache.firstSeq < cache.count)) {
+			cacheValid = 0;
+
+			while (hi - lo > 1) {
+				uint32_t mid = lo + (hi - lo) / 2;
+				uint8_t ok;
+
+				HAL_StatusTypeDef status = blockRead(mem, dataSlotAddr(mem, (uint16_t)(mid % mem->slots)), &cache, &ok);
+				if (status != HAL_OK) return status;
+
+				// Un bloque inválido solo puede ser el más antiguo (cortado): se descarta por la izquierda
+				if (!ok || cache.firstSeq <= seq) lo = mid;
+				else hi = mid;
+			}
+
+			HAL_StatusTypeDef status = blockRead(mem, dataSlotAddr(mem, (uint16_t)(lo % mem->slots)), &cache, &cacheValid);
+			if (status != HAL_OK) return status;
+			if (!cacheValid || cache.blockSeq != lo) {
+				cacheValid = 0;
+				return HAL_OK;
+			}
+		}
+
+		img = &cache;
+	}
+
+	if (seq < img->firstSeq || seq - img->firstSeq >= img->count) return HAL_OK;
+
+	FramBlock_t dec;
+	BlockSample_t s;
+	FRAM_BlockDecodeBegin(&dec, img);
+	for (uint32_t i = img->firstSeq; i <= seq; ++i) {
+		if (!FRAM_BlockDecodeNext(&dec, &s)) return HAL_OK;
+	}
+
+	if (data) sampleFromBlock(&s, data);
+	*valid = 1;
+	return HAL_OK;
+}
+
+/*
+ * Hora de la primera muestra con hora válida de la posición idx (secuencia de
+ * bloque en el formato de bloques, de muestra en el resto), 0 si no tiene. En
+ * bloques hace de índice disperso: una marca de tiempo por bloque sin escrituras
+ * adicionales.
+ */
+static HAL_StatusTypeDef probeTime(FramRing_t *mem, uint32_t idx, uint32_t *t) {
+	HAL_StatusTypeDef status;
+	*t = 0;
+
+	if (mem->format == FRAM_FORMAT_BLOCK) {
+		FramBlockImage_t img;
+		FramBlock_t dec;
+		BlockSample_t s;
+		uint8_t ok;
+
+		if (idx == mem->blk.img.blockSeq) img = mem->blk.img;
+		else {
+			status = blockRead(mem, dataSlotAddr(mem, (uint16_t)(idx % mem->slots)), &img, &ok);
+			if (status != HAL_OK || !ok || img.blockSeq != idx) return status;
+		}
+
+		FRAM_BlockDecodeBegin(&dec, &img);
+		while (*t == 0 && FRAM_BlockDecodeNext(&dec, &s)) *t = s.timestamp;
+		return HAL_OK;
+	}
+
+	DataSample_t data;
+	uint8_t valid;
+
+	status = FRAM_GetSample(mem, idx, &data, &valid);
+	if (status == HAL_OK && valid) *t = sampleTime(&data);
+	return status;
+}
+
+// Primera posición de [lo, hi) con hora >= from; las posiciones sin hora se saltan hacia delante
+static HAL_StatusTypeDef timeLowerBound(FramRing_t *mem, uint32_t from, uint32_t *lo, uint32_t hi) {
+	HAL_StatusTypeDef status;
+
+	while (*lo < hi) {
+		uint32_t mid = *lo + (hi - *lo) / 2;
+		uint32_t probe = mid, t = 0;
+
+		for (; probe < hi; ++probe) {
+			status = probeTime(mem, probe, &t);
+			if (status != HAL_OK) return status;
+			if (t != 0) break;
+		}
+
+		if (probe == hi || t >= from) hi = mid;
+		else *lo = probe + 1;
+	}
+
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef blockFindRange(FramRing_t *mem, uint32_t from, uint32_t to, FramSampleFn_t fn, void *ctx) {
+	HAL_StatusTypeDef status;
+	FramBlockImage_t img;
+	FramBlock_t dec;
+	BlockSample_t s;
+	uint8_t ok;
+
+	uint32_t top = mem->blk.img.blockSeq;
+	uint32_t oldest = (top > mem->slots) ? top - mem->slots : 0;
+	uint32_t lo = oldest;
+
+	// Las muestras anteriores al primer bloque que empieza en from pueden estar en el bloque previo
+	status = timeLowerBound(mem, from, &lo, top + 1);
+	if (status != HAL_OK) return status;
+
+	for (uint32_t b = (lo > oldest) ? lo - 1 : oldest; b <= top; ++b) {
+		if (b < top) {
+			status = blockRead(mem, dataSlotAddr(mem, (uint16_t)(b % mem->slots)), &img, &ok);
+			if (status != HAL_OK) return status;
+			if (!ok || img.blockSeq != b) continue;
+		}
+		else img = mem->blk.img;
+
+		FRAM_BlockDecodeBegin(&dec, &img);
+		for (uint32_t seq = img.firstSeq; FRAM_BlockDecodeNext(&dec, &s); ++seq) {
+			if (s.timestamp >= to) return HAL_OK;
+			if (s.timestamp == 0 || s.timestamp < from) continue;
+
+			DataSample_t data;
+			sampleFromBlock(&s, &data);
+			fn(ctx, seq, &data, 1);
+		}
+	}
+
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef tierPush(FramRing_t *mem, FramTierId_t id, const FramAggregate_t *agg);
+
+// Guarda el intervalo en curso y lo acumula en el nivel superior
+static HAL_StatusTypeDef tierClose(FramRing_t *mem, FramTierId_t id) {
+	HAL_StatusTypeDef status;
+	FramTier_t *tier = &mem->tier[id];
+	FramAggRecord_t rec;
+
+	FRAM_AggToRecord(&tier->open, &rec, tier->next_seq, mem->gen);
+	uint16_t addr = tierAddr(tier, (uint16_t)(tier->next_seq % tier->slots));
+
+	status = FRAM_DevWriteCommitted(mem->dev, addr, &rec, sizeof(rec), offsetof(FramAggRecord_t, commit), FRAM_AGG_COMMIT_VALUE);
+	if (status != HAL_OK) return status;
+
+	tier->next_seq++;
+	if (tier->count < tier->slots) tier->count++;
+
+	// Se vacía antes de subirlo: un fallo en el nivel superior no duplica el registro
+	FramAggregate_t closed = tier->open;
+	FRAM_AggClear(&tier->open, 0, tier->span_s);
+
+	if (id + 1 < FRAM_TIER_COUNT) return tierPush(mem, (FramTierId_t)(id + 1), &closed);
+	return HAL_OK;
+}
+
+// Acumula agg en el intervalo que le corresponde, cerrando el anterior si cambia
+static HAL_StatusTypeDef tierPush(FramRing_t *mem, FramTierId_t id, const FramAggregate_t *agg) {
+	FramTier_t *tier = &mem->tier[id];
+	uint32_t start = agg->start - agg->start % tier->span_s;
+
+	if (tier->open.samples > 0 && tier->open.start != start) {
+		HAL_StatusTypeDef status = tierClose(mem, id);
+		if (status != HAL_OK) return status;
+	}
+
+	if (tier->open.samples == 0) FRAM_AggClear(&tier->open, start, tier->span_s);
+	FRAM_AggMerge(&tier->open, agg);
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef tierFeed(FramRing_t *mem, const DataSample_t *data) {
+	BlockSample_t s;
+	sampleToBlock(data, &s);
+
+	// Sin hora válida la muestra no se puede asignar a ningún intervalo
+	if (s.timestamp == 0) return HAL_OK;
+
+	FramAggregate_t one;
+	FRAM_AggClear(&one, s.timestamp, 0);
+	FRAM_AggAddSample(&one, &s);
+
+	return tierPush(mem, FRAM_TIER_HOURLY, &one);
+}
+
+static HAL_StatusTypeDef tierNewest(FramRing_t *mem, FramTierId_t id, uint16_t back, FramAggRecord_t *rec, uint8_t *valid) {
+	FramTier_t *tier = &mem->tier[id];
+	uint32_t seq = tier->next_seq - 1 - back;
+
+	return tierRead(mem, tier, (uint16_t)(seq % tier->slots), rec, valid);
+}
+
+/*
+ * Los intervalos en curso solo existen en RAM: se reconstruyen a partir de las
+ * horas cerradas posteriores al último día y de las muestras posteriores a la
+ * última hora. Si un corte dejó intervalos sin cerrar, se cierran aquí.
+ */
+static HAL_StatusTypeDef tierRecover(FramRing_t *mem) {
+	HAL_StatusTypeDef status;
+	FramAggRecord_t rec;
+	FramAggregate_t agg;
+	DataSample_t d;
+	BlockSample_t s;
+	uint8_t valid;
+
+	for (uint8_t id = 0; id < FRAM_TIER_COUNT; ++id) {
+		FramTier_t *tier = &mem->tier[id];
+
+		status = seqRecover(mem, tier, &tier->next_seq, &tier->count);
+		if (status != HAL_OK) return status;
+
+		FRAM_AggClear(&tier->open, 0, tier->span_s);
+	}
+
+	FramTier_t *hourly = &mem->tier[FRAM_TIER_HOURLY];
+	FramTier_t *daily = &mem->tier[FRAM_TIER_DAILY];
+	uint32_t dayEnd = 0, hourEnd = 0;
+
+	if (daily->count > 0) {
+		status = tierNewest(mem, FRAM_TIER_DAILY, 0, &rec, &valid);
+		if (status != HAL_OK) return status;
+		if (valid) dayEnd = rec.start + daily->span_s;
+	}
+
+	// Horas cerradas que todavía no forman parte de un día cerrado
+	uint16_t back = 0;
+	while (back < hourly->count) {
+		status = tierNewest(mem, FRAM_TIER_HOURLY, back, &rec, &valid);
+		if (status != HAL_OK) return status;
+		if (!valid || rec.start < dayEnd) break;
+
+		if (back == 0) hourEnd = rec.start + hourly->span_s;
+		back++;
+	}
+
+	while (back > 0) {
+		status = tierNewest(mem, FRAM_TIER_HOURLY, --back, &rec, &valid);
+		if (status != HAL_OK) return status;
+
+		FRAM_AggFromRecord(&rec, hourly->span_s, &agg);
+		status = tierPush(mem, FRAM_TIER_DAILY, &agg);
+		if (status != HAL_OK) return status;
+	}
+
+	if (hourly->count > 0 && hourEnd == 0) {
+		status = tierNewest(mem, FRAM_TIER_HOURLY, 0, &rec, &valid);
+		if (status != HAL_OK) return status;
+		if (valid) hourEnd = rec.start + hourly->span_s;
+	}
+
+	// Muestras posteriores a la última hora cerrada
+	uint32_t first = mem->next_seq - mem->count;
+	uint32_t seq = mem->next_seq;
+
+	while (seq > first) {
+		status = FRAM_GetSample(mem, seq - 1, &d, &valid);
+		if (status != HAL_OK) return status;
+
+		if (valid) {
+			sampleToBlock(&d, &s);
+			if (s.timestamp != 0 && s.timestamp < hourEnd) break;
+		}
+		seq--;
+	}
+
+	for (; seq < mem->next_seq; ++seq) {
+		status = FRAM_GetSample(mem, seq, &d, &valid);
+		if (status != HAL_OK) return status;
+		if (!valid) continue;
+
+		status = tierFeed(mem, &d);
+		if (status != HAL_OK) return status;
+	}
+
+	return HAL_OK;
+}
+
+// Acumula los registros de un nivel con inicio en [from, to) y los intervalos en curso
+static HAL_StatusTypeDef tierMergeRange(FramRing_t *mem, FramTierId_t id, uint32_t from, uint32_t to, FramAggregate_t *out) {
+	HAL_StatusTypeDef status;
+	FramTier_t *tier = &mem->tier[id];
+	FramAggRecord_t rec;
+	FramAggregate_t agg;
+	uint8_t valid;
+
+	if (from >= to) return HAL_OK;
+
+	// Búsqueda binaria del primer registro con inicio >= from
+	uint32_t lo = tier->next_seq - tier->count, hi = tier->next_seq;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		status = tierRead(mem, tier, (uint16_t)(mid % tier->slots), &rec, &valid);
+		if (status != HAL_OK) return status;
+
+		if (!valid || rec.start < from) lo = mid + 1;
+		else hi = mid;
+	}
+
+	for (uint32_t seq = lo; seq < tier->next_seq; ++seq) {
+		status = tierRead(mem, tier, (uint16_t)(seq % tier->slots), &rec, &valid);
+		if (status != HAL_OK) return status;
+
+		if (!valid) continue;
+		if (rec.start >= to) break;
+
+		FRAM_AggFromRecord(&rec, tier->span_s, &agg);
+		FRAM_AggMerge(out, &agg);
+	}
+
+	// El día en curso solo tiene las horas cerradas: la hora en curso se suma aparte
+	const FramAggregate_t *open[2] = { &tier->open, (id == FRAM_TIER_DAILY) ? &mem->tier[FRAM_TIER_HOURLY].open : NULL };
+	for (uint8_t k = 0; k < 2; ++k) {
+		if (open[k] && open[k]->samples > 0 && open[k]->start >= from && open[k]->start < to) FRAM_AggMerge(out, open[k]);
+	}
+
+	return HAL_OK;
+}
+
+// Zonas clave-valor y de eventos: solo existen en la FRAM particionada
+static HAL_StatusTypeDef zonesAttach(FramRing_t *mem) {
+	HAL_StatusTypeDef status = FRAM_KvInit(&mem->kv, mem->dev, FRAM_KV_START, mem->tiers ? FRAM_KV_KEYS : 0);
+	if (status != HAL_OK) return status;
+
+	return FRAM_EventInit(&mem->events, mem->dev, FRAM_EVENT_START, mem->tiers ? FRAM_EVENT_SLOTS : 0);
+}
+
+// Registro del cursor en su clave
+static HAL_StatusTypeDef cursorCommit(FramRing_t *mem, uint8_t id) {
+	FramCursor_t *cur = &mem->cursor[id];
+
+	if (!cur->used) return FRAM_KvDelete(&mem->kv, (uint8_t)(FRAM_KEY_CURSOR + id));
+
+	CursorValue_t val = {0};
+	val.ack = cur->ack;
+	val.gen = mem->gen;
+	memcpy(val.name, cur->name, FRAM_CURSOR_NAME_LEN);
+
+	return FRAM_KvPut(&mem->kv, (uint8_t)(FRAM_KEY_CURSOR + id), &val, sizeof(val));
+}
+
+static HAL_StatusTypeDef cursorRecover(FramRing_t *mem) {
+	memset(mem->cursor, 0, sizeof(mem->cursor));
+
+	for (uint8_t id = 0; id < FRAM_CURSOR_MAX && mem->kv.keys > 0; ++id) {
+		FramCursor_t *cur = &mem->cursor[id];
+		CursorValue_t val;
+		uint8_t len;
+
+		HAL_StatusTypeDef status = FRAM_KvGet(&mem->kv, (uint8_t)(FRAM_KEY_CURSOR + id), &val, sizeof(val), &len);
+		if (status != HAL_OK) return status;
+		if (len != sizeof(val) || val.name[0] == '\0') continue;
+
+		cur->used = 1;
+		memcpy(cur->name, val.name, FRAM_CURSOR_NAME_LEN);
+
+		// Tras FRAM_Reset las secuencias vuelven a empezar
+		cur->ack = (val.gen == mem->gen) ? val.ack : 0;
+	}
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_SelfTest(FramDev_t *dev) {
     uint8_t w[8] = { 0x5A, 0xA5, 0xC3, 0x3C, 0x00, 0xFF, 0x12, 0x34 };
     uint8_t r[8];
 
     HAL_StatusTypeDef status;
 
-    status = MB85RS256B_Write(fram, FRAM_TEST_START, w, 8);
+    status = FRAM_DevWrite(dev, FRAM_TEST_START, w, 8);
     if (status != HAL_OK) return status;
 
-    status = MB85RS256B_Read(fram, FRAM_TEST_START, r, 8);
+    status = FRAM_DevRead(dev, FRAM_TEST_START, r, 8);
     if (status != HAL_OK) return status;
 
     if (memcmp(w, r, 8) != 0) return HAL_ERROR;
@@ -89,22 +994,138 @@ HAL_StatusTypeDef FRAM_SelfTest(MB85RS256B_t *fram) {
 }
 
 
+static HAL_StatusTypeDef ringRestart(FramRing_t *mem, uint8_t gen) {
+	uint8_t prevGen = mem->gen;
+	uint16_t prevLap = mem->lap;
+
+	mem->gen = gen;
+	mem->lap = 0;
+
+	HAL_StatusTypeDef status = genCommit(mem);
+	if (status != HAL_OK) {
+		mem->gen = prevGen;
+		mem->lap = prevLap;
+		return status;
+	}
+
+	mem->write_idx = 0;
+	mem->count = 0;
+	mem->next_seq = 0;
+	mem->blk_stage = 0;
+	FRAM_BlockBegin(&mem->blk, 0, 0, gen);
+	cacheValid = 0;
+	setTiers(mem, mem->tiers);
+
+	// Las muestras retenidas pertenecían a la generación anterior
+	mem->stage_len = 0;
+
+	// Los cursores conservan su nombre y vuelven al principio
+	for (uint8_t id = 0; id < FRAM_CURSOR_MAX; ++id) {
+		FramCursor_t *cur = &mem->cursor[id];
+
+		if (!mem->tiers) {
+			memset(cur, 0, sizeof(*cur));
+			continue;
+		}
+
+		cur->ack = 0;
+		if (cur->used) {
+			status = cursorCommit(mem, id);
+			if (status != HAL_OK) return status;
+		}
+	}
+
+	return HAL_OK;
+}
+
+// Cambio de formato o de particiones: los slots se solapan, borrado físico
+static HAL_StatusTypeDef relayout(FramRing_t *mem, FramFormat_t format, uint8_t tiers) {
+	FramFormat_t prevFormat = mem->format;
+	uint8_t prevTiers = mem->tiers;
+
+	setTiers(mem, tiers);
+	setFormat(mem, format);
+
+	// Al particionar, las zonas clave-valor y de eventos ocupan slots del anillo anterior
+	HAL_StatusTypeDef status = zonesAttach(mem);
+	if (status == HAL_OK && mem->tiers && !prevTiers) status = FRAM_KvFormat(&mem->kv);
+	if (status == HAL_OK && mem->tiers && !prevTiers) status = FRAM_EventFormat(&mem->events);
+	if (status == HAL_OK) status = FRAM_SecureErase(mem);
+
+	if (status != HAL_OK) {
+		setTiers(mem, prevTiers);
+		setFormat(mem, prevFormat);
+		zonesAttach(mem);
+	}
+
+	return status;
+}
+
 HAL_StatusTypeDef FRAM_Init(FramRing_t *mem) {
 	HAL_StatusTypeDef status;
 
-	// Inicializar FRAM
-	status = MB85RS256B_Init(mem->fram);
-	if (status != HAL_OK) return status;
+	// Motor CRC (tablas; el periférico solo con FRAM_CrcSelect)
+	FRAM_CrcInit();
+
+	mem->stage_len = 0;
+
+	// La caché de bloques puede ser de otra imagen (reinicio sin reset o varias FRAM en el host)
+	cacheValid = 0;
+
+	// Inicializar FRAM
+	if (mem->dev == NULL || mem->dev->size < FRAM_SIZE) return HAL_ERROR;
+
+	if (mem->dev->init != NULL) {
+		status = mem->dev->init(mem->dev->ctx);
+		if (status != HAL_OK) return status;
+	}
+
+	status = FRAM_SelfTest(mem->dev);
+	if (status != HAL_OK) return status;
+
+	if (mem->layout == FRAM_LAYOUT_SEQ) {
+		FramFormat_t preferred = (mem->format == FRAM_FORMAT_V2 || mem->format == FRAM_FORMAT_BLOCK) ?
+								 mem->format : FRAM_FORMAT_V1;
+		uint8_t preferredTiers = mem->tiers ? 1 : 0;
+
+		// El formato grabado en la cabecera manda para poder leer el histórico
+		status = genRecover(mem);
+		if (status != HAL_OK) return status;
+
+		status = zonesAttach(mem);
+		if (status != HAL_OK) return status;
+
+		status = (mem->format == FRAM_FORMAT_BLOCK) ? blockRecover(mem) : slotRecover(mem);
+		if (status != HAL_OK) return status;
+
+		if (mem->tiers) {
+			status = tierRecover(mem);
+			if (status != HAL_OK) return status;
+		}
+
+		status = cursorRecover(mem);
+		if (status != HAL_OK) return status;
+
+		// FRAM vacía en otro formato: se adopta el preferido sin perder datos
+		uint8_t empty = (mem->count == 0) && (mem->tier[FRAM_TIER_HOURLY].count == 0) && (mem->tier[FRAM_TIER_DAILY].count == 0);
+		if (empty && (mem->format != preferred || mem->tiers != preferredTiers)) return relayout(mem, preferred, preferredTiers);
+
+		return HAL_OK;
+	}
+
+	setTiers(mem, 0);
+	setFormat(mem, FRAM_FORMAT_V1);
+	memset(mem->cursor, 0, sizeof(mem->cursor));
 
-	status = FRAM_SelfTest(mem->fram);
+	status = zonesAttach(mem);
 	if (status != HAL_OK) return status;
 
 	MetaFrame_t metaA, metaB, best;
 
 	// Leer ambas cabeceras meta
-	status = MB85RS256B_Read(mem->fram, FRAM_META_A_START, (uint8_t *)&metaA, sizeof(metaA));
+	status = FRAM_DevRead(mem->dev, FRAM_META_A_START, (uint8_t *)&metaA, sizeof(metaA));
 	if (status != HAL_OK) return status;
-	status = MB85RS256B_Read(mem->fram, FRAM_META_B_START, (uint8_t *)&metaB, sizeof(metaB));
+	status = FRAM_DevRead(mem->dev, FRAM_META_B_START, (uint8_t *)&metaB, sizeof(metaB));
 	if (status != HAL_OK) return status;
 
 	uint8_t validA = metaIsValid(&metaA);
@@ -112,7 +1133,7 @@ HAL_StatusTypeDef FRAM_Init(FramRing_t *mem) {
 
 	// Meta A y Meta B validas: se guarda la más nueva
 	if (validA && validB) {
-		best = (seqIsNewer(metaA.seq, metaB.seq)) ? metaA : metaB;
+		best = (FRAM_SeqIsNewer(metaA.seq, metaB.seq)) ? metaA : metaB;
 		//printf("Both meta valid\r\n");
 	}
 	// Meta A o Meta B validas: se guarda la valida
@@ -129,10 +1150,10 @@ HAL_StatusTypeDef FRAM_Init(FramRing_t *mem) {
 		best.count = 0;
 		best.seq = 0;
 
-		status = metaWriteSafe(mem->fram, FRAM_META_A_START, &best);
+		status = metaWriteSafe(mem->dev, FRAM_META_A_START, &best);
 		if (status != HAL_OK) return status;
 
-		status = metaClear(mem->fram, FRAM_META_B_START);
+		status = metaClear(mem->dev, FRAM_META_B_START);
 		if (status != HAL_OK) return status;
 	}
 
@@ -140,86 +1161,367 @@ HAL_StatusTypeDef FRAM_Init(FramRing_t *mem) {
 	mem->write_idx = best.write_idx;
 	mem->count = best.count;
 	mem->seq = best.seq;
+	mem->next_seq = best.count;
 
 	return HAL_OK;
 }
 
-HAL_StatusTypeDef FRAM_SaveData(FramRing_t *mem, DataSample_t *data) {
+// Cabecera meta con write_idx y count, alternando A/B con la secuencia
+static HAL_StatusTypeDef metaCommit(FramRing_t *mem, uint16_t count) {
+	mem->seq++;
+
+	MetaFrame_t meta = {0};
+	meta.write_idx = mem->write_idx;
+	meta.count = count;
+	meta.seq = mem->seq;
+
+	uint16_t meta_addr = (meta.seq & 1) ? FRAM_META_B_START : FRAM_META_A_START;
+	//printf("Write Meta %c\r\n", (meta_addr == FRAM_META_A_START) ? 'A':'B');
+	return metaWriteSafe(mem->dev, meta_addr, &meta);
+}
+
+/*
+ * Guarda n muestras consecutivas (n <= FRAM_STAGE_MAX). Las tramas de slots
+ * contiguos van en una sola escritura con el commit a 0 y después se escriben
+ * los commits en orden: un corte deja siempre un prefijo de las muestras.
+ */
+static HAL_StatusTypeDef ringSave(FramRing_t *mem, const DataSample_t *data, uint8_t n) {
 	HAL_StatusTypeDef status;
+	uint8_t buf[FRAM_STAGE_MAX * FRAM_SLOT_SIZE];
+	uint8_t commit[FRAM_STAGE_MAX];
+	FramSeg_t seg[FRAM_STAGE_MAX + 1];
 
-	uint16_t addr = dataSlotAddr(mem->write_idx);
-	//printf("Write Slot: %u (0x%04X)\r\n", mem->write_idx, addr);
+	if (mem->format == FRAM_FORMAT_BLOCK) return blockSave(mem, data, n);
 
-	status = dataWriteSafe(mem->fram, addr, data);
-	if (status != HAL_OK) return status;
+	// Con meta, los slots más antiguos salen de count antes de sobrescribirlos: un corte
+	// antes de la cabecera no puede dejar una muestra nueva en el lugar de la más antigua
+	if (mem->layout != FRAM_LAYOUT_SEQ && mem->count + n > mem->slots) {
+		status = metaCommit(mem, (uint16_t)(mem->slots - n));
+		if (status != HAL_OK) return status;
+	}
+
+	uint16_t size = slotSize(mem);
+	uint16_t commitOffset = (mem->format == FRAM_FORMAT_V2) ? offsetof(SampleV2_t, commit) : offsetof(DataFrame_t, commit);
+
+	while (n > 0) {
+		uint32_t lap = mem->next_seq / mem->slots;
+		uint16_t run = (uint16_t)(mem->slots - mem->write_idx);
+		if (run > n) run = n;
+
+		// v2 solo guarda la paridad: el primer slot de cada vuelta va solo y se registra la vuelta tras escribirlo
+		uint8_t newLap = (mem->layout == FRAM_LAYOUT_SEQ && mem->format == FRAM_FORMAT_V2 && lap != mem->lap);
+		if (newLap) run = 1;
+
+		uint16_t addr = dataSlotAddr(mem, mem->write_idx);
+		//printf("Write Slot: %u (0x%04X)\r\n", mem->write_idx, addr);
+
+		for (uint16_t i = 0; i < run; ++i) commit[i] = slotImage(mem, &data[i], mem->next_seq + i, &buf[i * size]);
 
-	mem->write_idx = (uint16_t)((mem->write_idx + 1) % FRAM_DATA_SLOTS);
-	mem->count = (mem->count < FRAM_DATA_SLOTS) ? mem->count + 1 : FRAM_DATA_SLOTS;
+		seg[0] = (FramSeg_t){ .addr = addr, .data = buf, .len = (uint16_t)(run * size) };
+		for (uint16_t i = 0; i < run; ++i) {
+			seg[i + 1] = (FramSeg_t){ .addr = (uint16_t)(addr + i * size + commitOffset), .data = &commit[i], .len = 1, .barrier = 1 };
+		}
+
+		status = FRAM_DevWritev(mem->dev, seg, (size_t)run + 1);
+		if (status != HAL_OK) return status;
+
+		// Sin meta la secuencia de la trama basta para recuperar el anillo; con meta solo vive en RAM
+		mem->write_idx = (uint16_t)((mem->write_idx + run) % mem->slots);
+		mem->count = (mem->count + run < mem->slots) ? mem->count + run : mem->slots;
+		mem->next_seq += run;
+		data += run;
+		n = (uint8_t)(n - run);
+
+		if (newLap) {
+			mem->lap = (uint16_t)lap;
+			status = genCommit(mem);
+			if (status != HAL_OK) return status;
+		}
+	}
+
+	if (mem->layout == FRAM_LAYOUT_SEQ) return HAL_OK;
 
 	//printf("Write Count: %u\r\n", mem->count);
 
-	mem->seq++;
+	return metaCommit(mem, mem->count);
+}
 
-	MetaFrame_t meta = {0};
-	meta.write_idx = mem->write_idx;
-	meta.count = mem->count;
-	meta.seq = mem->seq;
+static HAL_StatusTypeDef saveBatch(FramRing_t *mem, const DataSample_t *data, uint8_t n) {
+	HAL_StatusTypeDef status = ringSave(mem, data, n);
+	if (status != HAL_OK || !mem->tiers) return status;
 
-	uint16_t meta_addr = (meta.seq & 1) ? FRAM_META_B_START : FRAM_META_A_START;
-	//printf("Write Meta %c\r\n", (meta_addr == FRAM_META_A_START) ? 'A':'B');
-	return metaWriteSafe(mem->fram, meta_addr, &meta);
+	// Las muestras ya están en el anillo: si falla o se corta aquí, FRAM_Init rehace los agregados
+	for (uint8_t i = 0; i < n; ++i) {
+		status = tierFeed(mem, &data[i]);
+		if (status != HAL_OK) return status;
+	}
+
+	return HAL_OK;
+}
+
+// Las muestras retenidas se dan por entregadas aunque la escritura falle: un reintento las duplicaría
+static HAL_StatusTypeDef stageFlush(FramRing_t *mem) {
+	uint8_t n = mem->stage_len;
+	if (n == 0) return HAL_OK;
+
+	mem->stage_len = 0;
+	return saveBatch(mem, mem->stage, n);
+}
+
+/*
+ * Con stage_batch > 1 las muestras se retienen en RAM (se conserva en STOP2) y
+ * se escriben de stage_batch en stage_batch. Las retenidas todavía no cuentan
+ * en next_seq/count ni se pueden leer.
+ */
+HAL_StatusTypeDef FRAM_SaveData(FramRing_t *mem, DataSample_t *data) {
+	uint8_t batch = (mem->stage_batch > FRAM_STAGE_MAX) ? FRAM_STAGE_MAX : mem->stage_batch;
+
+	if (batch <= 1 && mem->stage_len == 0) return saveBatch(mem, data, 1);
+
+	mem->stage[mem->stage_len++] = *data;
+
+	if (mem->stage_len >= batch) return stageFlush(mem);
+	return HAL_OK;
+}
+
+// Solo desde el bucle principal: la FRAM y la CRC no admiten accesos desde interrupciones
+HAL_StatusTypeDef FRAM_Flush(FramRing_t *mem) {
+	return stageFlush(mem);
 }
 
 HAL_StatusTypeDef FRAM_GetSlot(FramRing_t *mem, uint16_t slot, DataSample_t *data, uint8_t *valid) {
 	HAL_StatusTypeDef status;
 
-	uint16_t addr = dataSlotAddr(slot);
-	//printf("Read Slot: %u (0x%04X)\r\n", slot, addr);
+	// Los slots de bloques no contienen una única muestra
+	if (mem->format == FRAM_FORMAT_BLOCK) return HAL_ERROR;
 
-	DataFrame_t frame;
-	status = MB85RS256B_Read(mem->fram, addr, (uint8_t *)&frame, sizeof(frame));
+	//printf("Read Slot: %u (0x%04X)\r\n", slot, dataSlotAddr(mem, slot));
+
+	status = readSlot(mem, slot, data, valid, NULL);
 	if (status != HAL_OK) return status;
 
-	*valid = frameIsValid(&frame);
 	//printf("Read Valid: %u\r\n", *valid);
 
-	*data = frame.data;
+	return HAL_OK;
+}
+
+/*
+ * Lee la muestra con número de secuencia seq en cualquier formato. valid = 0 si
+ * ya no está en el anillo, todavía no existe o su slot no es válido.
+ */
+HAL_StatusTypeDef FRAM_GetSample(FramRing_t *mem, uint32_t seq, DataSample_t *data, uint8_t *valid) {
+	*valid = 0;
+	if (seq >= mem->next_seq || mem->next_seq - seq > mem->count) return HAL_OK;
+
+	if (mem->format == FRAM_FORMAT_BLOCK) return blockGetSample(mem, seq, data, valid);
+
+	uint16_t back = (uint16_t)((mem->next_seq - seq) % mem->slots);
+	uint16_t slot = (uint16_t)((mem->write_idx + mem->slots - back) % mem->slots);
+	return readSlot(mem, slot, data, valid, NULL);
+}
+
+/*
+ * Entrega a fn las muestras con secuencia en [from, to) en orden. En v1 y v2
+ * los slots contiguos se leen de una vez (hasta FRAM_BULK_READ bytes) para que
+ * el driver pueda usar DMA; los bloques ya se leen enteros.
+ */
+HAL_StatusTypeDef FRAM_ReadRange(FramRing_t *mem, uint32_t from, uint32_t to, FramSampleFn_t fn, void *ctx) {
+	static uint8_t buf[FRAM_BULK_READ];
+	HAL_StatusTypeDef status;
+	DataSample_t data = {0};
+	uint8_t valid = 0;
+
+	// Sobrescritas o todavía sin escribir
+	uint32_t oldest = mem->next_seq - mem->count;
+	uint32_t end = (to < mem->next_seq) ? to : mem->next_seq;
+
+	for (; from < to && from < oldest; ++from) fn(ctx, from, &data, 0);
+
+	uint16_t size = slotSize(mem);
+
+	while (from < end && mem->format == FRAM_FORMAT_BLOCK) {
+		status = FRAM_GetSample(mem, from, &data, &valid);
+		if (status != HAL_OK) return status;
+
+		fn(ctx, from, &data, valid);
+		from++;
+	}
+
+	while (from < end) {
+		uint16_t back = (uint16_t)((mem->next_seq - from) % mem->slots);
+		uint16_t slot = (uint16_t)((mem->write_idx + mem->slots - back) % mem->slots);
+
+		// Sin cruzar el final del anillo
+		uint32_t n = end - from;
+		if (n > FRAM_BULK_READ / size) n = FRAM_BULK_READ / size;
+		if (n > (uint32_t)(mem->slots - slot)) n = mem->slots - slot;
+
+		status = FRAM_DevRead(mem->dev, dataSlotAddr(mem, slot), buf, n * size);
+		if (status != HAL_OK) return status;
+
+		for (uint32_t k = 0; k < n; ++k, ++from) {
+			decodeSlot(mem, (uint16_t)(slot + k), buf + k * size, &data, &valid, NULL);
+			fn(ctx, from, &data, valid);
+		}
+	}
+
+	data = (DataSample_t){0};
+	for (; from < to; ++from) fn(ctx, from, &data, 0);
+
 	return HAL_OK;
 }
 
 HAL_StatusTypeDef FRAM_WriteData(FramRing_t *mem, uint16_t addr, DataSample_t *data) {
-	HAL_StatusTypeDef status = dataWriteSafe(mem->fram, addr, data);
+	HAL_StatusTypeDef status = dataWriteSafe(mem, addr, data, 0);
 
 	return status;
 }
 
+// En la FRAM particionada va en su clave (A/B con CRC); si no, en FRAM_DEVICE_START sin protección
 HAL_StatusTypeDef FRAM_WriteDeviceInfo(FramRing_t *mem, DeviceFrame_t *dev_info) {
-	HAL_StatusTypeDef status = MB85RS256B_Write(mem->fram, FRAM_DEVICE_START, (uint8_t *)dev_info, sizeof(*dev_info));
+	if (mem->kv.keys > 0) return FRAM_KvPut(&mem->kv, FRAM_KEY_DEVICE, dev_info, sizeof(*dev_info));
+
+	HAL_StatusTypeDef status = FRAM_DevWrite(mem->dev, FRAM_DEVICE_START, (uint8_t *)dev_info, sizeof(*dev_info));
 
 	return status;
 }
 
-HAL_StatusTypeDef FRAM_Reset(FramRing_t *mem) {
+HAL_StatusTypeDef FRAM_ReadDeviceInfo(FramRing_t *mem, DeviceFrame_t *dev_info, uint8_t *valid) {
+	*valid = 0;
+
+	if (mem->kv.keys > 0) {
+		uint8_t len;
+
+		HAL_StatusTypeDef status = FRAM_KvGet(&mem->kv, FRAM_KEY_DEVICE, dev_info, sizeof(*dev_info), &len);
+		if (status != HAL_OK) return status;
+
+		*valid = (len == sizeof(*dev_info));
+		return HAL_OK;
+	}
+
+	HAL_StatusTypeDef status = FRAM_DevRead(mem->dev, FRAM_DEVICE_START, (uint8_t *)dev_info, sizeof(*dev_info));
+	if (status != HAL_OK) return status;
+
+	*valid = 1;
+	return HAL_OK;
+}
+
+// Solo en la FRAM particionada (sin ella no se guarda nada): las dos claves por separado, cada una A/B
+HAL_StatusTypeDef FRAM_WriteEnergy(FramRing_t *mem, const EnergyValue_t *energy, const ChargeValue_t *charge) {
+	if (mem->kv.keys == 0) return HAL_OK;
+
+	HAL_StatusTypeDef status = FRAM_KvPut(&mem->kv, FRAM_KEY_ENERGY, energy, sizeof(*energy));
+	if (status != HAL_OK) return status;
+
+	return FRAM_KvPut(&mem->kv, FRAM_KEY_CHARGE, charge, sizeof(*charge));
+}
+
+// valid solo con las dos claves; un corte entre ambas deja la carga de la actualización anterior
+HAL_StatusTypeDef FRAM_ReadEnergy(FramRing_t *mem, EnergyValue_t *energy, ChargeValue_t *charge, uint8_t *valid) {
+	uint8_t lenEnergy = 0, lenCharge = 0;
 	HAL_StatusTypeDef status;
 
-	const uint8_t chunk[32] = {0};
+	*valid = 0;
+	if (mem->kv.keys == 0) return HAL_OK;
+
+	status = FRAM_KvGet(&mem->kv, FRAM_KEY_ENERGY, energy, sizeof(*energy), &lenEnergy);
+	if (status == HAL_OK) status = FRAM_KvGet(&mem->kv, FRAM_KEY_CHARGE, charge, sizeof(*charge), &lenCharge);
+	if (status != HAL_OK) return status;
+
+	*valid = (lenEnergy == sizeof(*energy)) && (lenCharge == sizeof(*charge));
+	return HAL_OK;
+}
+
+// Una vez al día, como FRAM_WriteEnergy
+HAL_StatusTypeDef FRAM_WriteEnergyDay(FramRing_t *mem, const EnergyDayValue_t *day) {
+	if (mem->kv.keys == 0) return HAL_OK;
+
+	return FRAM_KvPut(&mem->kv, FRAM_KEY_ENERGY_DAY, day, sizeof(*day));
+}
+
+HAL_StatusTypeDef FRAM_ReadEnergyDay(FramRing_t *mem, EnergyDayValue_t *day, uint8_t *valid) {
+	uint8_t len = 0;
+
+	*valid = 0;
+	if (mem->kv.keys == 0) return HAL_OK;
+
+	HAL_StatusTypeDef status = FRAM_KvGet(&mem->kv, FRAM_KEY_ENERGY_DAY, day, sizeof(*day), &len);
+	if (status != HAL_OK) return status;
+
+	*valid = (len == sizeof(*day));
+	return HAL_OK;
+}
+
+// Configuración de funcionamiento: sin zona clave-valor el nodo usa la compilada
+HAL_StatusTypeDef FRAM_WriteConfig(FramRing_t *mem, const ConfigValue_t *cfg) {
+	if (mem->kv.keys == 0) return HAL_OK;
+
+	return FRAM_KvPut(&mem->kv, FRAM_KEY_CONFIG, cfg, sizeof(*cfg));
+}
+
+HAL_StatusTypeDef FRAM_ReadConfig(FramRing_t *mem, ConfigValue_t *cfg, uint8_t *valid) {
+	uint8_t len = 0;
+
+	*valid = 0;
+	if (mem->kv.keys == 0) return HAL_OK;
+
+	HAL_StatusTypeDef status = FRAM_KvGet(&mem->kv, FRAM_KEY_CONFIG, cfg, sizeof(*cfg), &len);
+	if (status != HAL_OK) return status;
+
+	*valid = (len == sizeof(*cfg));
+	return HAL_OK;
+}
+
+// Un error más en el contador persistente; *total recibe el nuevo valor si no es NULL
+HAL_StatusTypeDef FRAM_CountError(FramRing_t *mem, uint32_t *total) {
+	if (mem->kv.keys == 0) return HAL_OK;
+
+	return FRAM_KvAdd32(&mem->kv, FRAM_KEY_ERRORS, 1, total);
+}
+
+static HAL_StatusTypeDef zeroRange(FramDev_t *dev, uint32_t from, uint32_t to) {
+	static const uint8_t chunk[FRAM_SLOT_SIZE * 8] = {0};
 
-	for (uint16_t slot = 0; slot < FRAM_DATA_SLOTS; ++slot) {
-		uint16_t addr = dataSlotAddr(slot);
+	for (uint32_t addr = from; addr < to; addr += sizeof(chunk)) {
+		uint32_t len = to - addr;
+		if (len > sizeof(chunk)) len = sizeof(chunk);
 
-		status = MB85RS256B_Write(mem->fram, addr, chunk, sizeof(chunk));
+		HAL_StatusTypeDef status = FRAM_DevWrite(dev, (uint16_t)addr, chunk, len);
 		if (status != HAL_OK) return status;
 	}
 
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_Reset(FramRing_t *mem) {
+	HAL_StatusTypeDef status;
+
+	// FRAM_LAYOUT_SEQ: basta con avanzar la generación, las tramas antiguas dejan de ser válidas
+	if (mem->layout == FRAM_LAYOUT_SEQ) {
+		// Al dar la vuelta podrían reaparecer tramas de generaciones antiguas
+		uint8_t next = (uint8_t)(mem->gen + 1);
+		if ((next & genMask(mem)) == 0) return FRAM_SecureErase(mem);
+
+		return ringRestart(mem, next);
+	}
+
+	// Slots contiguos: escrituras grandes para que el driver pueda usar DMA
+	uint32_t start = dataSlotAddr(mem, 0);
+
+	status = zeroRange(mem->dev, start, start + (uint32_t)FRAM_DATA_SLOTS * FRAM_SLOT_SIZE);
+	if (status != HAL_OK) return status;
+
+	mem->next_seq = 0;
+
 	MetaFrame_t meta = {0};
 	meta.write_idx = 0;
 	meta.count = 0;
 	meta.seq = 0;
 
-	status = metaWriteSafe(mem->fram, FRAM_META_A_START, &meta);
+	status = metaWriteSafe(mem->dev, FRAM_META_A_START, &meta);
 	if (status != HAL_OK) return status;
 
-	status = metaClear(mem->fram, FRAM_META_B_START);
+	status = metaClear(mem->dev, FRAM_META_B_START);
 	if (status != HAL_OK) return status;
 
 	mem->write_idx = meta.write_idx;
@@ -229,19 +1531,302 @@ HAL_StatusTypeDef FRAM_Reset(FramRing_t *mem) {
 	return HAL_OK;
 }
 
+HAL_StatusTypeDef FRAM_SetFormat(FramRing_t *mem, FramFormat_t format) {
+	if (format < FRAM_FORMAT_V1 || format > FRAM_FORMAT_BLOCK) return HAL_ERROR;
+
+	// v2 y bloques necesitan la cabecera de generación del anillo sin meta
+	if (mem->layout != FRAM_LAYOUT_SEQ) return (format == FRAM_FORMAT_V1) ? HAL_OK : HAL_ERROR;
+
+	return relayout(mem, format, mem->tiers);
+}
+
+HAL_StatusTypeDef FRAM_SetTiers(FramRing_t *mem, uint8_t enable) {
+	// Los agregados necesitan la generación para invalidarse con FRAM_Reset
+	if (mem->layout != FRAM_LAYOUT_SEQ) return enable ? HAL_ERROR : HAL_OK;
+
+	return relayout(mem, mem->format, enable ? 1 : 0);
+}
+
+HAL_StatusTypeDef FRAM_GetAggregate(FramRing_t *mem, FramTierId_t tier, uint16_t back, FramAggregate_t *agg, uint8_t *valid) {
+	*valid = 0;
+	if (!mem->tiers || tier >= FRAM_TIER_COUNT) return HAL_ERROR;
+	if (back >= mem->tier[tier].count) return HAL_OK;
+
+	FramAggRecord_t rec;
+	HAL_StatusTypeDef status = tierNewest(mem, tier, back, &rec, valid);
+	if (status != HAL_OK) return status;
+
+	if (*valid) FRAM_AggFromRecord(&rec, mem->tier[tier].span_s, agg);
+	return HAL_OK;
+}
+
+/*
+ * Resumen de [from, to) a partir de los agregados: días completos del anillo
+ * diario y horas completas en los extremos. Las horas incompletas de los
+ * extremos no se incluyen.
+ */
+HAL_StatusTypeDef FRAM_QueryRange(FramRing_t *mem, uint32_t from, uint32_t to, FramAggregate_t *agg) {
+	HAL_StatusTypeDef status;
+
+	FRAM_AggClear(agg, from, (to > from) ? to - from : 0);
+	if (!mem->tiers) return HAL_ERROR;
+
+	uint32_t hour = mem->tier[FRAM_TIER_HOURLY].span_s;
+	uint32_t day = mem->tier[FRAM_TIER_DAILY].span_s;
+
+	uint32_t hFrom = from + (hour - from % hour) % hour, hTo = to - to % hour;
+	uint32_t dFrom = from + (day - from % day) % day, dTo = to - to % day;
+
+	if (dFrom >= dTo) return tierMergeRange(mem, FRAM_TIER_HOURLY, hFrom, hTo, agg);
+
+	status = tierMergeRange(mem, FRAM_TIER_DAILY, dFrom, dTo, agg);
+	if (status != HAL_OK) return status;
+
+	status = tierMergeRange(mem, FRAM_TIER_HOURLY, hFrom, dFrom, agg);
+	if (status != HAL_OK) return status;
+
+	return tierMergeRange(mem, FRAM_TIER_HOURLY, dTo, hTo, agg);
+}
+
+HAL_StatusTypeDef FRAM_SecureErase(FramRing_t *mem) {
+	HAL_StatusTypeDef status;
+
+	// FRAM_LAYOUT_META: el reset ya borra físicamente los slots
+	if (mem->layout != FRAM_LAYOUT_SEQ) return FRAM_Reset(mem);
+
+	// Borrado físico de todos los slots de datos (las zonas clave-valor y de eventos se conservan)
+	uint32_t end = (mem->kv.keys > 0) ? mem->kv.start : FRAM_SIZE;
+
+	if (mem->events.slots > 0) {
+		uint32_t evtEnd = mem->events.start + (uint32_t)mem->events.slots * FRAM_EVENT_RECORD_SIZE;
+
+		status = zeroRange(mem->dev, FRAM_DATA_START, mem->events.start);
+		if (status == HAL_OK) status = zeroRange(mem->dev, evtEnd, end);
+	}
+	else status = zeroRange(mem->dev, FRAM_DATA_START, end);
+
+	if (status != HAL_OK) return status;
+
+	return ringRestart(mem, 0);
+}
+
 HAL_StatusTypeDef FRAM_EraseAll(FramRing_t *mem) {
 	HAL_StatusTypeDef status;
 
-	const uint8_t chunk[32] = {0};
+	// Bloques grandes para que el driver pueda usar DMA
+	static const uint8_t chunk[256] = {0};
 
-	for (uint16_t addr = 0; addr < MB85RS256B_SIZE; addr += sizeof(chunk)) {
-		status = MB85RS256B_Write(mem->fram, addr, chunk, sizeof(chunk));
+	for (uint32_t addr = 0; addr < FRAM_SIZE; addr += sizeof(chunk)) {
+		status = FRAM_DevWrite(mem->dev, addr, chunk, sizeof(chunk));
 		if (status != HAL_OK) return status;
 	}
 
 	mem->write_idx = 0;
 	mem->count = 0;
 	mem->seq = 0;
+	mem->next_seq = 0;
+
+	// Registro de generación, cursores, claves y eventos borrados: se vuelve a la generación 0
+	if (mem->layout == FRAM_LAYOUT_SEQ) {
+		mem->gen_seq = 0xFF;
+		memset(mem->cursor, 0, sizeof(mem->cursor));
+
+		status = zonesAttach(mem);
+		if (status != HAL_OK) return status;
+
+		return ringRestart(mem, 0);
+	}
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_CursorOpen(FramRing_t *mem, const char *name, uint8_t *id) {
+	if (!mem->tiers || !name || name[0] == '\0') return HAL_ERROR;
+
+	uint8_t slot = FRAM_CURSOR_MAX;
+	for (uint8_t i = 0; i < FRAM_CURSOR_MAX; ++i) {
+		FramCursor_t *cur = &mem->cursor[i];
+
+		if (cur->used && strncmp(cur->name, name, FRAM_CURSOR_NAME_LEN) == 0) {
+			*id = i;
+			return HAL_OK;
+		}
+		if (!cur->used && slot == FRAM_CURSOR_MAX) slot = i;
+	}
+
+	// Sin cursores libres
+	if (slot == FRAM_CURSOR_MAX) return HAL_ERROR;
+
+	FramCursor_t *cur = &mem->cursor[slot];
+	memset(cur->name, 0, sizeof(cur->name));
+	strncpy(cur->name, name, FRAM_CURSOR_NAME_LEN);
+	cur->used = 1;
+
+	// Un cursor nuevo empieza en la muestra más antigua del anillo
+	cur->ack = mem->next_seq - mem->count;
+
+	HAL_StatusTypeDef status = cursorCommit(mem, slot);
+	if (status != HAL_OK) {
+		cur->used = 0;
+		return status;
+	}
+
+	*id = slot;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_CursorClose(FramRing_t *mem, uint8_t id) {
+	if (id >= FRAM_CURSOR_MAX || !mem->cursor[id].used) return HAL_ERROR;
+
+	FramCursor_t *cur = &mem->cursor[id];
+	cur->used = 0;
+	cur->ack = 0;
+	memset(cur->name, 0, sizeof(cur->name));
+
+	return cursorCommit(mem, id);
+}
+
+// Primera secuencia sin confirmar que sigue en el anillo
+HAL_StatusTypeDef FRAM_CursorGet(FramRing_t *mem, uint8_t id, uint32_t *seq) {
+	if (id >= FRAM_CURSOR_MAX || !mem->cursor[id].used) return HAL_ERROR;
+
+	uint32_t oldest = mem->next_seq - mem->count;
+	uint32_t ack = mem->cursor[id].ack;
+
+	*seq = (ack < oldest) ? oldest : (ack > mem->next_seq) ? mem->next_seq : ack;
+	return HAL_OK;
+}
+
+// Confirma todas las muestras anteriores a seq
+HAL_StatusTypeDef FRAM_CursorAck(FramRing_t *mem, uint8_t id, uint32_t seq) {
+	if (id >= FRAM_CURSOR_MAX || !mem->cursor[id].used) return HAL_ERROR;
+	if (seq > mem->next_seq) return HAL_ERROR;
+
+	FramCursor_t *cur = &mem->cursor[id];
+	if (seq <= cur->ack) return HAL_OK;
+
+	uint32_t prev = cur->ack;
+	cur->ack = seq;
+
+	HAL_StatusTypeDef status = cursorCommit(mem, id);
+	if (status != HAL_OK) cur->ack = prev;
+
+	return status;
+}
+
+/*
+ * Entrega a fn las muestras posteriores al cursor (como mucho max, 0 = todas)
+ * sin avanzarlo: el consumidor confirma con FRAM_CursorAck(end) cuando las
+ * tiene. Un hueco en las secuencias indica muestras sobrescritas sin confirmar.
+ */
+HAL_StatusTypeDef FRAM_Export(FramRing_t *mem, uint8_t id, uint16_t max, FramSampleFn_t fn, void *ctx, uint32_t *end) {
+	HAL_StatusTypeDef status;
+	uint32_t seq;
+
+	status = FRAM_CursorGet(mem, id, &seq);
+	if (status != HAL_OK) return status;
+
+	uint32_t stop = mem->next_seq;
+	if (max > 0 && stop - seq > max) stop = seq + max;
+
+	status = FRAM_ReadRange(mem, seq, stop, fn, ctx);
+	if (status != HAL_OK) return status;
+
+	if (end) *end = stop;
+	return HAL_OK;
+}
+
+/*
+ * Entrega a fn las muestras con hora en [from, to) en orden de secuencia. Se
+ * supone que la hora no retrocede dentro del anillo: búsqueda binaria por
+ * secuencia (el giro del anillo no afecta) y lectura solo de los slots del
+ * intervalo. Las muestras sin hora válida se omiten.
+ */
+HAL_StatusTypeDef FRAM_FindRange(FramRing_t *mem, uint32_t from, uint32_t to, FramSampleFn_t fn, void *ctx) {
+	HAL_StatusTypeDef status;
+	DataSample_t data;
+	uint8_t valid;
+
+	if (from >= to) return HAL_OK;
+	if (mem->format == FRAM_FORMAT_BLOCK) return blockFindRange(mem, from, to, fn, ctx);
+
+	uint32_t lo = mem->next_seq - mem->count;
+
+	status = timeLowerBound(mem, from, &lo, mem->next_seq);
+	if (status != HAL_OK) return status;
+
+	for (uint32_t seq = lo; seq < mem->next_seq; ++seq) {
+		status = FRAM_GetSample(mem, seq, &data, &valid);
+		if (status != HAL_OK) return status;
+		if (!valid) continue;
+
+		uint32_t t = sampleTime(&data);
+		if (t >= to) break;
+		if (t == 0 || t < from) continue;
+
+		fn(ctx, seq, &data, 1);
+	}
+
+	return HAL_OK;
+}
+
+// Los eventos van a su propia zona: no pasan por el anillo de muestras ni por el lote en RAM
+HAL_StatusTypeDef FRAM_LogEvent(FramRing_t *mem, FramEventCode_t code, uint32_t timestamp, uint32_t arg) {
+	return FRAM_EventAppend(&mem->events, (uint8_t)code, timestamp, arg);
+}
+
+// back = 0 es el evento más reciente
+HAL_StatusTypeDef FRAM_GetEvent(FramRing_t *mem, uint16_t back, FramEventRecord_t *evt, uint8_t *valid) {
+	*valid = 0;
+	if (back >= mem->events.count) return HAL_OK;
+
+	return FRAM_EventGet(&mem->events, mem->events.next_seq - 1 - back, evt, valid);
+}
+
+HAL_StatusTypeDef FRAM_ExportEvents(FramRing_t *mem, uint32_t from, uint16_t max, FramEventFn_t fn, void *ctx, uint32_t *end) {
+	return FRAM_EventExport(&mem->events, from, max, fn, ctx, end);
+}
+
+uint32_t FRAM_SampleTime(const DataSample_t *data) {
+	return sampleTime(data);
+}
+
+HAL_StatusTypeDef FRAM_CrcBenchmark(FramRing_t *mem, uint32_t cycles[3]) {
+#ifdef FRAM_HOST
+	// Sin contador de ciclos DWT en el host
+	(void)mem;
+	(void)cycles;
+	return HAL_ERROR;
+#else
+	static uint8_t chunk[256];
+
+	FramCrcEngine_t engines[3] = { FRAM_CRC_BITWISE, FRAM_CRC_TABLE, FRAM_CRC_HARDWARE };
+	FramCrcEngine_t prev = FRAM_CrcEngine();
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	for (int e = 0; e < 3; ++e) {
+		FRAM_CrcSelect(engines[e]);
+		cycles[e] = 0;
+
+		// Imagen completa de 32 KB; solo se mide el cálculo, no la lectura SPI
+		for (uint32_t addr = 0; addr < FRAM_SIZE; addr += sizeof(chunk)) {
+			HAL_StatusTypeDef status = FRAM_DevRead(mem->dev, (uint16_t)addr, chunk, sizeof(chunk));
+			if (status != HAL_OK) {
+				FRAM_CrcSelect(prev);
+				return status;
+			}
+
+			uint32_t t0 = DWT->CYCCNT;
+			for (uint16_t off = 0; off < sizeof(chunk); off += FRAM_SLOT_SIZE) {
+				(void)FRAM_Crc16(&chunk[off], offsetof(DataFrame_t, crc));
+			}
+			cycles[e] += DWT->CYCCNT - t0;
+		}
+	}
 
+	FRAM_CrcSelect(prev);
 	return HAL_OK;
+#endif
 }
@@ -8,17 +8,57 @@
 #ifndef FRAM_H_
 #define FRAM_H_
 
-#include "stm32wbxx_hal.h"
-
 #include <stdio.h>
 #include <string.h>
 
-#include "MB85RS256B.h"
+#include "fram_dev.h"
+#include "fram_crc.h"
+#include "fram_block.h"
+#include "fram_tier.h"
+#include "fram_kv.h"
+#include "fram_event.h"
+#include "fram_seq.h"
 
 #define FRAM_SLOT_SIZE			32
-#define FRAM_TOTAL_SLOTS		(MB85RS256B_SIZE / FRAM_SLOT_SIZE)
+#define FRAM_TOTAL_SLOTS		(FRAM_SIZE / FRAM_SLOT_SIZE)
 #define FRAM_DATA_SLOTS			(FRAM_TOTAL_SLOTS - 1)
 
+#define FRAM_SLOT_SIZE_V2		16
+#define FRAM_DATA_SLOTS_V2		((FRAM_SIZE - FRAM_DATA_START) / FRAM_SLOT_SIZE_V2)
+
+#define FRAM_BULK_READ			256		// Bytes per read when walking the ring (DMA in the driver)
+
+// Formato por bloques: copias A/B del bloque abierto y anillo de bloques cerrados
+#define FRAM_BLOCK_STAGE_A		FRAM_DATA_START
+#define FRAM_BLOCK_STAGE_B		(FRAM_BLOCK_STAGE_A + FRAM_BLOCK_SIZE)
+#define FRAM_BLOCK_RING_START	(FRAM_BLOCK_STAGE_B + FRAM_BLOCK_SIZE)
+#define FRAM_BLOCK_SLOTS		((FRAM_SIZE - FRAM_BLOCK_RING_START) / FRAM_BLOCK_SIZE)
+
+// Particiones de agregados (FramRing_t.tiers): 16 KB de muestras, 6 KB por hora, 2 KB de eventos, 7 KB por día y registros clave-valor
+#define FRAM_TIER_RAW_END		0x4000
+#define FRAM_TIER_HOURLY_START	0x4000
+#define FRAM_TIER_HOURLY_SLOTS	96		// 4 días
+#define FRAM_TIER_DAILY_START	0x6000
+#define FRAM_TIER_DAILY_SLOTS	112		// 16 semanas
+
+// Registro de eventos (solo FRAM particionada): 128 eventos de 16 bytes
+#define FRAM_EVENT_START		0x5800
+#define FRAM_EVENT_SLOTS		128
+
+// Registros clave-valor (solo FRAM particionada): 16 claves de 2 x 32 bytes
+#define FRAM_KV_START			0x7C00
+#define FRAM_KV_KEYS			16
+
+// Cursores de exportación: una clave por cursor
+#define FRAM_CURSOR_MAX			8
+#define FRAM_CURSOR_NAME_LEN	7
+
+// Muestras retenidas en RAM como máximo antes de escribirlas de una vez (FramRing_t.stage_batch)
+#define FRAM_STAGE_MAX			8
+
+// Bit del formato en el registro de generación que indica FRAM particionada
+#define FRAM_GEN_FORMAT_TIERS	0x80
+
 #define FRAM_START				0x0000
 #define FRAM_DEVICE_START		0x0000
 #define FRAM_TEST_START			0x0008
@@ -28,6 +68,21 @@
 
 #define FRAM_FRAME_COMMIT_VALUE		0x3C
 #define FRAM_META_COMMIT_VALUE		0xA5
+#define FRAM_GEN_COMMIT_VALUE		0x96
+
+// Byte de commit v2: marca | paridad de vuelta | 6 bits bajos de la generación
+#define FRAM_V2_COMMIT_MARK		0x80
+#define FRAM_V2_COMMIT_LAP		0x40
+#define FRAM_V2_GEN_MASK		0x3F
+
+// Valores reservados para canales no válidos en v2
+#define FRAM_V2_TEMP_INVALID	INT16_MIN
+#define FRAM_V2_U16_INVALID		0xFFFF
+#define FRAM_V2_U8_INVALID		0xFF
+
+// En FRAM_LAYOUT_SEQ las cabeceras meta A/B guardan el registro de generación
+#define FRAM_GEN_A_START		FRAM_META_A_START
+#define FRAM_GEN_B_START		FRAM_META_B_START
 
 enum validDataBit { IRRADIANCE_BIT, AIR_TEMP_BIT, SOIL_TEMP_BIT, AIR_HUM_BIT, SOIL_MOIST_BIT, BATT_VOLT_BIT, HOURS_BIT, MINUTES_BIT, SECONDS_BIT, DAY_BIT, MONTH_BIT, YEAR_BIT };
 
@@ -49,16 +104,31 @@ typedef struct {
 	uint8_t hours, minutes, seconds;	// 3 bytes
 	uint8_t day, month, year;			// 3 bytes
 
-	uint16_t validDataVector;			// 2 bytes
+	uint16_t validDataVector;			// 2 bytes (0 = sin información: en v2 se guardan todos los canales)
 } DataSample_t; // 24 bytes aligned
 
 typedef struct {
 	DataSample_t data;		// 24 bytes
 	uint16_t crc;			// 2 bytes
 	uint8_t commit;			// 1 bytes
-	uint8_t  _reserved[5];	// 5 bytes
+	uint8_t gen;			// 1 bytes (solo FRAM_LAYOUT_SEQ)
+	uint32_t seq;			// 4 bytes (solo FRAM_LAYOUT_SEQ)
 } DataFrame_t; // 32 bytes aligned
 
+// Registro v2: enteros escalados y marca de tiempo epoch.
+// El commit va primero: un corte a mitad de escritura ya lo ha puesto a 0.
+typedef struct {
+	uint8_t commit;				// 1 byte
+	uint8_t crc;				// 1 byte (byte bajo del CRC-16 del resto)
+	uint16_t irradiance_dWm2;	// 2 bytes (0.1 W/m2)
+	uint16_t batteryVoltage_mV;	// 2 bytes
+	int16_t airTemp_cC;			// 2 bytes (0.01 ºC)
+	int16_t soilTemp_cC;		// 2 bytes (0.01 ºC)
+	uint8_t airHumidity_perc;	// 1 byte
+	uint8_t soilMoisture_perc;	// 1 byte
+	uint32_t timestamp;			// 4 bytes (epoch Unix, 0 = no válida)
+} SampleV2_t; // 16 bytes aligned
+
 typedef struct {
     uint16_t write_idx; // 2 bytes
     uint16_t count;		// 2 bytes
@@ -67,32 +137,218 @@ typedef struct {
 	uint8_t commit;		// 1 bytes
 } MetaFrame_t; // 8 bytes aligned
 
+typedef struct {
+	uint8_t gen;		// 1 bytes
+	uint8_t seq;		// 1 bytes
+	uint16_t crc;		// 2 bytes
+	uint8_t commit;		// 1 bytes
+	uint8_t format;		// 1 bytes (FramFormat_t)
+	uint16_t lap;		// 2 bytes (vuelta actual del anillo, solo v2)
+} GenFrame_t; // 8 bytes aligned
+
+// Valor de la clave FRAM_KEY_CURSOR + id
+typedef struct {
+	uint32_t ack;		// 4 bytes (primera secuencia sin confirmar)
+	uint8_t gen;		// 1 bytes (generación de ack)
+	char name[FRAM_CURSOR_NAME_LEN];	// 7 bytes
+} CursorValue_t; // 12 bytes aligned
 
 typedef struct {
 	uint32_t system_id;
 	uint32_t modified_date;
 } DeviceFrame_t; // 8 bytes aligned
 
+// Valor de la clave FRAM_KEY_ENERGY: totales desde que se creó el registro
+typedef struct {
+	uint32_t pv_uWh;		// 4 bytes (cosechada)
+	uint32_t bat_in_uWh;	// 4 bytes (carga de la batería)
+	uint32_t bat_out_uWh;	// 4 bytes (descarga de la batería)
+	uint32_t load_uWh;		// 4 bytes (consumo del nodo)
+	uint32_t soc_uAh;		// 4 bytes (carga restante de la batería)
+	uint32_t timestamp;		// 4 bytes (epoch de la última actualización)
+} EnergyValue_t; // 24 bytes aligned
+
+// Valor de la clave FRAM_KEY_CHARGE, mismos flujos que EnergyValue_t
+typedef struct {
+	uint32_t pv_uAh;
+	uint32_t bat_in_uAh;
+	uint32_t bat_out_uAh;
+	uint32_t load_uAh;
+} ChargeValue_t; // 16 bytes aligned
+
+// Valor de la clave FRAM_KEY_ENERGY_DAY: totales al empezar el día del balance diario
+typedef struct {
+	uint32_t day;			// 4 bytes (días desde el epoch)
+	uint32_t pv_uWh;		// 4 bytes
+	uint32_t load_uWh;		// 4 bytes
+} EnergyDayValue_t; // 12 bytes aligned
+
+// Valor de la clave FRAM_KEY_CONFIG: niveles de muestreo y límites del modo supervivencia
+typedef struct {
+	uint16_t battery_mV[4];		// 8 bytes (umbrales de nivel, SamplingConfig_t.battery_mV)
+	uint16_t hysteresis_mV;		// 2 bytes
+	uint16_t period_s[5];		// 10 bytes (periodo de cada nivel, SamplingConfig_t.period_s)
+	uint16_t batCritical_mA;	// 2 bytes (alerta crítica del canal de batería)
+	uint16_t loadCritical_mA;	// 2 bytes (alerta crítica del canal de carga)
+} ConfigValue_t; // 24 bytes aligned
+
 _Static_assert(sizeof(DataFrame_t) == 32, "DataFrame_t must be 32 bytes");
 _Static_assert(sizeof(MetaFrame_t) == 8, "MetaFrame_t must be 8 bytes");
+_Static_assert(sizeof(GenFrame_t) == 8, "GenFrame_t must be 8 bytes");
+_Static_assert(sizeof(EnergyValue_t) <= FRAM_KV_VALUE_MAX, "EnergyValue_t does not fit a key-value record");
+_Static_assert(sizeof(ChargeValue_t) <= FRAM_KV_VALUE_MAX, "ChargeValue_t does not fit a key-value record");
+_Static_assert(sizeof(EnergyDayValue_t) <= FRAM_KV_VALUE_MAX, "EnergyDayValue_t does not fit a key-value record");
+_Static_assert(sizeof(ConfigValue_t) <= FRAM_KV_VALUE_MAX, "ConfigValue_t does not fit a key-value record");
+_Static_assert(sizeof(CursorValue_t) == 12, "CursorValue_t must be 12 bytes");
+_Static_assert(FRAM_TIER_HOURLY_START + FRAM_TIER_HOURLY_SLOTS * FRAM_AGG_RECORD_SIZE <= FRAM_EVENT_START, "Hourly tier overlaps the event log");
+_Static_assert(FRAM_EVENT_START + FRAM_EVENT_SLOTS * FRAM_EVENT_RECORD_SIZE <= FRAM_TIER_DAILY_START, "Event log overlaps the daily tier");
+_Static_assert(FRAM_TIER_DAILY_START + FRAM_TIER_DAILY_SLOTS * FRAM_AGG_RECORD_SIZE <= FRAM_KV_START, "Daily tier overlaps the key-value region");
+_Static_assert(FRAM_KV_START + FRAM_KV_REGION_SIZE(FRAM_KV_KEYS) <= FRAM_SIZE, "Key-value region out of range");
+_Static_assert(sizeof(SampleV2_t) == FRAM_SLOT_SIZE_V2, "SampleV2_t must be 16 bytes");
+
+// Formato del anillo
+typedef enum {
+	FRAM_LAYOUT_META = 0,	// Cabeceras meta A/B con write_idx/count
+	FRAM_LAYOUT_SEQ			// Sin meta: secuencia en cada trama, cabeza por búsqueda binaria
+} FramLayout_t;
+
+// Formato de registro
+typedef enum {
+	FRAM_FORMAT_V1 = 1,		// DataFrame_t, 32 bytes
+	FRAM_FORMAT_V2 = 2,		// SampleV2_t, 16 bytes (solo FRAM_LAYOUT_SEQ)
+	FRAM_FORMAT_BLOCK = 3	// Bloques comprimidos de 128 bytes (solo FRAM_LAYOUT_SEQ)
+} FramFormat_t;
+
+// Niveles de agregados
+typedef enum {
+	FRAM_TIER_HOURLY = 0,
+	FRAM_TIER_DAILY,
+	FRAM_TIER_COUNT
+} FramTierId_t;
+
+typedef struct {
+	uint16_t start;			// Dirección del primer registro
+	uint16_t slots;
+	uint32_t span_s;		// Duración del intervalo (3600 / 86400 s)
+	uint32_t next_seq;		// Secuencia del próximo registro
+	uint16_t count;			// Registros cerrados en el anillo
+	FramAggregate_t open;	// Intervalo en curso (solo RAM, se reconstruye en FRAM_Init)
+} FramTier_t;
+
+// Claves de la zona clave-valor
+typedef enum {
+	FRAM_KEY_DEVICE = 0,	// DeviceFrame_t
+	FRAM_KEY_CONFIG,		// Configuración de funcionamiento (ConfigValue_t)
+	FRAM_KEY_ENERGY,		// Contadores de energía (EnergyValue_t)
+	FRAM_KEY_ERRORS,		// Errores de sensores y FRAM registrados (uint32_t, FRAM_KvAdd32)
+	FRAM_KEY_CURSOR,		// Cursores de exportación (FRAM_CURSOR_MAX claves)
+	FRAM_KEY_CHARGE = FRAM_KEY_CURSOR + FRAM_CURSOR_MAX,	// Contadores de carga (ChargeValue_t)
+	FRAM_KEY_ENERGY_DAY,	// Inicio del balance diario (EnergyDayValue_t)
+	FRAM_KEY_USER			// Libres hasta FRAM_KV_KEYS
+} FramKey_t;
+
+_Static_assert(FRAM_KEY_USER <= FRAM_KV_KEYS, "FRAM_KV_KEYS too small for the fixed keys");
+
+// Códigos del registro de eventos (FramEventRecord_t.code) y significado de arg.
+// Los despertares periódicos del RTC no se registran: llenarían el anillo.
+typedef enum {
+	FRAM_EVENT_RESET = 1,		// Arranque: flags de reset (RCC->CSR)
+	FRAM_EVENT_AEM,				// Despertar por cambio de estado del AEM: bits S2..S0 | ms << 16
+	FRAM_EVENT_INA_ALERT,		// Despertar por alerta del INA3221: pin (PV/CRI/WAR) | ms << 16
+	FRAM_EVENT_SENSOR_ERROR,	// Error de lectura: FramSensorId_t
+	FRAM_EVENT_POWER,			// Caída de tensión detectada por el PVD: batería en mV
+	FRAM_EVENT_QUEUE_DROP,		// Eventos de interrupción perdidos con la cola llena: cuántos
+	FRAM_EVENT_PERIOD,			// Cambio del periodo de muestreo: segundos | nivel << 16
+	FRAM_EVENT_JOB,				// Tarea diferida ejecutada: id | minutos de espera << 16
+	FRAM_EVENT_SURVIVAL,		// Modo supervivencia por alertas del INA3221: 1 entra / 0 sale | batería mV << 16
+	FRAM_EVENT_ENERGY,			// Balance del día anterior: mWh cosechados | mWh consumidos << 16
+	FRAM_EVENT_USER = 0x80		// Libres para la aplicación
+} FramEventCode_t;
+
+typedef enum {
+	FRAM_SENSOR_INA3221 = 0,
+	FRAM_SENSOR_TSL2591,
+	FRAM_SENSOR_SHT3X,
+	FRAM_SENSOR_DFR0198,
+	FRAM_SENSOR_SEN0308,
+	FRAM_SENSOR_RTC,
+	FRAM_SENSOR_FRAM
+} FramSensorId_t;
 
 typedef struct {
-	MB85RS256B_t *fram;
-    uint16_t write_idx; // [0..1022]
-    uint16_t count; // [0..1023]
+	char name[FRAM_CURSOR_NAME_LEN + 1];
+	uint32_t ack;			// Primera secuencia sin confirmar
+	uint8_t used;
+} FramCursor_t;
+
+// Muestra entregada por FRAM_Export y FRAM_FindRange
+typedef void (*FramSampleFn_t)(void *ctx, uint32_t seq, const DataSample_t *data, uint8_t valid);
+
+typedef struct {
+	FramDev_t *dev;
+	FramLayout_t layout;
+	FramFormat_t format;	// Preferido antes de FRAM_Init, vigente después
+    uint16_t slots;		// Slots de datos del formato vigente (bloques en FRAM_FORMAT_BLOCK)
+    uint16_t write_idx; // [0..slots-1]
+    uint16_t count; // Muestras guardadas ([0..slots] salvo en bloques)
     uint8_t  seq;
+    uint32_t next_seq;	// Secuencia de la próxima trama (FRAM_LAYOUT_SEQ)
+    uint8_t  gen;		// Generación vigente (FRAM_LAYOUT_SEQ)
+    uint8_t  gen_seq;	// Selección A/B del registro de generación
+    uint16_t lap;		// Vuelta registrada en la cabecera (v2)
+    FramBlock_t blk;	// Bloque abierto (FRAM_FORMAT_BLOCK)
+    uint8_t  blk_stage;	// Copia A/B donde se guardará el bloque abierto
+    uint8_t  tiers;		// Agregados por hora y día (FRAM_LAYOUT_SEQ): preferido antes de FRAM_Init, vigente después
+    FramTier_t tier[FRAM_TIER_COUNT];
+    FramCursor_t cursor[FRAM_CURSOR_MAX];	// Cursores de exportación (FRAM particionada)
+    FramKv_t kv;			// Registros clave-valor (FRAM particionada; kv.keys = 0 si no)
+    FramEventLog_t events;	// Registro de eventos (FRAM particionada; events.slots = 0 si no)
+    volatile uint8_t stage_batch;	// Muestras por escritura (0 o 1: escritura inmediata, máximo FRAM_STAGE_MAX); la cambia el PVD
+    uint8_t  stage_len;
+    DataSample_t stage[FRAM_STAGE_MAX];
 } FramRing_t;
 
 HAL_StatusTypeDef FRAM_Init(FramRing_t *mem);
 
 HAL_StatusTypeDef FRAM_SaveData(FramRing_t *mem, DataSample_t *data);
+HAL_StatusTypeDef FRAM_Flush(FramRing_t *mem);
 HAL_StatusTypeDef FRAM_GetSlot(FramRing_t *mem, uint16_t slot, DataSample_t *data, uint8_t *valid);
+HAL_StatusTypeDef FRAM_GetSample(FramRing_t *mem, uint32_t seq, DataSample_t *data, uint8_t *valid);
 
 HAL_StatusTypeDef FRAM_WriteData(FramRing_t *mem, uint16_t addr, DataSample_t *data);
 HAL_StatusTypeDef FRAM_WriteDeviceInfo(FramRing_t *mem, DeviceFrame_t *dev_info);
+HAL_StatusTypeDef FRAM_ReadDeviceInfo(FramRing_t *mem, DeviceFrame_t *dev_info, uint8_t *valid);
+HAL_StatusTypeDef FRAM_WriteEnergy(FramRing_t *mem, const EnergyValue_t *energy, const ChargeValue_t *charge);
+HAL_StatusTypeDef FRAM_ReadEnergy(FramRing_t *mem, EnergyValue_t *energy, ChargeValue_t *charge, uint8_t *valid);
+HAL_StatusTypeDef FRAM_WriteEnergyDay(FramRing_t *mem, const EnergyDayValue_t *day);
+HAL_StatusTypeDef FRAM_ReadEnergyDay(FramRing_t *mem, EnergyDayValue_t *day, uint8_t *valid);
+HAL_StatusTypeDef FRAM_WriteConfig(FramRing_t *mem, const ConfigValue_t *cfg);
+HAL_StatusTypeDef FRAM_ReadConfig(FramRing_t *mem, ConfigValue_t *cfg, uint8_t *valid);
+HAL_StatusTypeDef FRAM_CountError(FramRing_t *mem, uint32_t *total);
 
 HAL_StatusTypeDef FRAM_Reset(FramRing_t *mem);
+HAL_StatusTypeDef FRAM_SetFormat(FramRing_t *mem, FramFormat_t format);
+HAL_StatusTypeDef FRAM_SetTiers(FramRing_t *mem, uint8_t enable);
+HAL_StatusTypeDef FRAM_SecureErase(FramRing_t *mem);
 HAL_StatusTypeDef FRAM_EraseAll(FramRing_t *mem);
 
+HAL_StatusTypeDef FRAM_GetAggregate(FramRing_t *mem, FramTierId_t tier, uint16_t back, FramAggregate_t *agg, uint8_t *valid);
+HAL_StatusTypeDef FRAM_QueryRange(FramRing_t *mem, uint32_t from, uint32_t to, FramAggregate_t *agg);
+
+HAL_StatusTypeDef FRAM_CursorOpen(FramRing_t *mem, const char *name, uint8_t *id);
+HAL_StatusTypeDef FRAM_CursorClose(FramRing_t *mem, uint8_t id);
+HAL_StatusTypeDef FRAM_CursorGet(FramRing_t *mem, uint8_t id, uint32_t *seq);
+HAL_StatusTypeDef FRAM_CursorAck(FramRing_t *mem, uint8_t id, uint32_t seq);
+HAL_StatusTypeDef FRAM_ReadRange(FramRing_t *mem, uint32_t from, uint32_t to, FramSampleFn_t fn, void *ctx);
+HAL_StatusTypeDef FRAM_Export(FramRing_t *mem, uint8_t id, uint16_t max, FramSampleFn_t fn, void *ctx, uint32_t *end);
+HAL_StatusTypeDef FRAM_FindRange(FramRing_t *mem, uint32_t from, uint32_t to, FramSampleFn_t fn, void *ctx);
+
+HAL_StatusTypeDef FRAM_LogEvent(FramRing_t *mem, FramEventCode_t code, uint32_t timestamp, uint32_t arg);
+HAL_StatusTypeDef FRAM_GetEvent(FramRing_t *mem, uint16_t back, FramEventRecord_t *evt, uint8_t *valid);
+HAL_StatusTypeDef FRAM_ExportEvents(FramRing_t *mem, uint32_t from, uint16_t max, FramEventFn_t fn, void *ctx, uint32_t *end);
+uint32_t FRAM_SampleTime(const DataSample_t *data);
+
+HAL_StatusTypeDef FRAM_CrcBenchmark(FramRing_t *mem, uint32_t cycles[3]);
+
 
 #endif /* FRAM_H_ */
@@ -0,0 +1,213 @@
+/*
+ * fram_block.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "fram_block.h"
+
+#include <string.h>
+
+#define PAYLOAD_BITS	(FRAM_BLOCK_PAYLOAD * 8)
+
+// Anchura de cada canal en la primera muestra del bloque
+static const uint8_t rawBits[FRAM_BLOCK_CHANNELS] = { 32, 16, 16, 16, 16, 8, 8 };
+
+static void toChannels(const BlockSample_t *s, int32_t ch[FRAM_BLOCK_CHANNELS]) {
+	ch[0] = (int32_t)s->timestamp;
+	ch[1] = s->irradiance_dWm2;
+	ch[2] = s->batteryVoltage_mV;
+	ch[3] = s->airTemp_cC;
+	ch[4] = s->soilTemp_cC;
+	ch[5] = s->airHumidity_perc;
+	ch[6] = s->soilMoisture_perc;
+}
+
+static void fromChannels(const int32_t ch[FRAM_BLOCK_CHANNELS], BlockSample_t *s) {
+	s->timestamp = (uint32_t)ch[0];
+	s->irradiance_dWm2 = (uint16_t)ch[1];
+	s->batteryVoltage_mV = (uint16_t)ch[2];
+	s->airTemp_cC = (int16_t)ch[3];
+	s->soilTemp_cC = (int16_t)ch[4];
+	s->airHumidity_perc = (uint8_t)ch[5];
+	s->soilMoisture_perc = (uint8_t)ch[6];
+}
+
+static inline uint32_t zigzag(int32_t v) {
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+	return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static uint8_t codeBits(uint32_t zz) {
+	if (zz == 0) return 1;
+	if (zz < (1u << 4)) return 2 + 4;
+	if (zz < (1u << 8)) return 3 + 8;
+	if (zz < (1u << 16)) return 4 + 16;
+	return 4 + 32;
+}
+
+static void putBits(uint8_t *buf, uint16_t *pos, uint32_t value, uint8_t n) {
+	while (n--) {
+		if ((value >> n) & 1) buf[*pos >> 3] |= (uint8_t)(0x80 >> (*pos & 7));
+		(*pos)++;
+	}
+}
+
+// Más allá de la carga útil no se lee: la posición queda fuera de rango para el llamador
+static uint32_t getBits(const uint8_t *buf, uint16_t *pos, uint8_t n) {
+	if (*pos + n > PAYLOAD_BITS) {
+		*pos = PAYLOAD_BITS + 1;
+		return 0;
+	}
+
+	uint32_t value = 0;
+	while (n--) {
+		value = (value << 1) | ((buf[*pos >> 3] >> (7 - (*pos & 7))) & 1);
+		(*pos)++;
+	}
+	return value;
+}
+
+static void putCode(uint8_t *buf, uint16_t *pos, uint32_t zz) {
+	if (zz == 0) putBits(buf, pos, 0x0, 1);
+	else if (zz < (1u << 4)) { putBits(buf, pos, 0x2, 2); putBits(buf, pos, zz, 4); }
+	else if (zz < (1u << 8)) { putBits(buf, pos, 0x6, 3); putBits(buf, pos, zz, 8); }
+	else if (zz < (1u << 16)) { putBits(buf, pos, 0xE, 4); putBits(buf, pos, zz, 16); }
+	else { putBits(buf, pos, 0xF, 4); putBits(buf, pos, zz, 32); }
+}
+
+static uint32_t getCode(const uint8_t *buf, uint16_t *pos) {
+	if (!getBits(buf, pos, 1)) return 0;
+	if (!getBits(buf, pos, 1)) return getBits(buf, pos, 4);
+	if (!getBits(buf, pos, 1)) return getBits(buf, pos, 8);
+	if (!getBits(buf, pos, 1)) return getBits(buf, pos, 16);
+	return getBits(buf, pos, 32);
+}
+
+// Residuos de la muestra frente al estado anterior
+static void residuals(const FramBlock_t *blk, const int32_t ch[FRAM_BLOCK_CHANNELS], uint32_t zz[FRAM_BLOCK_CHANNELS], int32_t *delta) {
+	*delta = (int32_t)((uint32_t)ch[0] - (uint32_t)blk->prev[0]);
+	zz[0] = zigzag(*delta - blk->prevDelta);
+
+	for (int c = 1; c < FRAM_BLOCK_CHANNELS; ++c) zz[c] = zigzag(ch[c] - blk->prev[c]);
+}
+
+void FRAM_BlockBegin(FramBlock_t *blk, uint32_t blockSeq, uint32_t firstSeq, uint8_t gen) {
+	memset(blk, 0, sizeof(*blk));
+	blk->img.blockSeq = blockSeq;
+	blk->img.firstSeq = firstSeq;
+	blk->img.gen = gen;
+}
+
+uint8_t FRAM_BlockAppend(FramBlock_t *blk, const BlockSample_t *s) {
+	int32_t ch[FRAM_BLOCK_CHANNELS];
+	toChannels(s, ch);
+
+	if (blk->img.count >= FRAM_BLOCK_MAX_SAMPLES) return 0;
+
+	if (blk->img.count == 0) {
+		for (int c = 0; c < FRAM_BLOCK_CHANNELS; ++c) {
+			putBits(blk->img.payload, &blk->bitPos, (uint32_t)ch[c] & (0xFFFFFFFFu >> (32 - rawBits[c])), rawBits[c]);
+			blk->prev[c] = ch[c];
+		}
+		blk->prevDelta = 0;
+		blk->img.count = 1;
+		return 1;
+	}
+
+	uint32_t zz[FRAM_BLOCK_CHANNELS];
+	int32_t delta;
+	residuals(blk, ch, zz, &delta);
+
+	// Se comprueba el tamaño antes de escribir: un bloque lleno no se modifica
+	uint16_t bits = 0;
+	for (int c = 0; c < FRAM_BLOCK_CHANNELS; ++c) bits += codeBits(zz[c]);
+	if (blk->bitPos + bits > PAYLOAD_BITS) return 0;
+
+	for (int c = 0; c < FRAM_BLOCK_CHANNELS; ++c) {
+		putCode(blk->img.payload, &blk->bitPos, zz[c]);
+		blk->prev[c] = ch[c];
+	}
+	blk->prevDelta = delta;
+	blk->img.count++;
+	return 1;
+}
+
+// count y todo lo que sigue al CRC: un count dañado no puede hacer leer fuera del bloque
+static uint16_t blockCrc(const FramBlockImage_t *img) {
+	const uint8_t *body = (const uint8_t *)img + offsetof(FramBlockImage_t, blockSeq);
+
+	uint16_t crc = FRAM_Crc16(&img->count, sizeof(img->count));
+	return FRAM_Crc16Update(crc, body, FRAM_BLOCK_SIZE - offsetof(FramBlockImage_t, blockSeq));
+}
+
+void FRAM_BlockSeal(FramBlock_t *blk) {
+	blk->img.commit = 0;
+	blk->img.crc = blockCrc(&blk->img);
+}
+
+uint8_t FRAM_BlockIsValid(const FramBlockImage_t *img, uint8_t gen) {
+	if (img->commit != FRAM_BLOCK_COMMIT_VALUE) return 0;
+	if (img->count == 0 || img->gen != gen) return 0;
+
+	return (img->crc == blockCrc(img));
+}
+
+void FRAM_BlockDecodeBegin(FramBlock_t *dec, const FramBlockImage_t *img) {
+	memset(dec, 0, sizeof(*dec));
+	dec->img = *img;
+}
+
+uint8_t FRAM_BlockDecodeNext(FramBlock_t *dec, BlockSample_t *s) {
+	if (dec->index >= dec->img.count) return 0;
+
+	int32_t ch[FRAM_BLOCK_CHANNELS];
+
+	if (dec->index == 0) {
+		for (int c = 0; c < FRAM_BLOCK_CHANNELS; ++c) {
+			uint32_t v = getBits(dec->img.payload, &dec->bitPos, rawBits[c]);
+
+			// Extensión de signo de las temperaturas
+			if (c == 3 || c == 4) ch[c] = (int16_t)v;
+			else ch[c] = (int32_t)v;
+		}
+		dec->prevDelta = 0;
+	}
+	else {
+		// Aritmética sin signo: un bloque dañado puede desbordar
+		int32_t delta = (int32_t)((uint32_t)unzigzag(getCode(dec->img.payload, &dec->bitPos)) + (uint32_t)dec->prevDelta);
+		ch[0] = (int32_t)((uint32_t)dec->prev[0] + (uint32_t)delta);
+		dec->prevDelta = delta;
+
+		for (int c = 1; c < FRAM_BLOCK_CHANNELS; ++c) {
+			ch[c] = (int32_t)((uint32_t)dec->prev[c] + (uint32_t)unzigzag(getCode(dec->img.payload, &dec->bitPos)));
+		}
+	}
+
+	// Carga útil agotada antes de count: el decodificador se detiene aquí
+	if (dec->bitPos > PAYLOAD_BITS) {
+		dec->index = dec->img.count;
+		return 0;
+	}
+
+	for (int c = 0; c < FRAM_BLOCK_CHANNELS; ++c) dec->prev[c] = ch[c];
+	dec->index++;
+
+	if (s) fromChannels(ch, s);
+	return 1;
+}
+
+// Reconstruye el estado del codificador a partir de un bloque abierto guardado
+uint8_t FRAM_BlockResume(FramBlock_t *blk, const FramBlockImage_t *img) {
+	FRAM_BlockDecodeBegin(blk, img);
+	while (FRAM_BlockDecodeNext(blk, NULL));
+
+	if (blk->bitPos > PAYLOAD_BITS) return 0;
+
+	blk->img.commit = 0;
+	return 1;
+}
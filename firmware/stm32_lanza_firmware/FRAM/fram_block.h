@@ -0,0 +1,80 @@
+/*
+ * fram_block.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef FRAM_BLOCK_H_
+#define FRAM_BLOCK_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fram_crc.h"
+
+/*
+ * Bloques comprimidos de muestras: la primera muestra se guarda completa y las
+ * siguientes como deltas zig-zag (delta de delta en la marca de tiempo) con un
+ * código de longitud variable por canal:
+ *
+ *   0                  delta nulo          1 bit
+ *   10   + 4 bits      |zz| < 16           6 bits
+ *   110  + 8 bits      |zz| < 256          11 bits
+ *   1110 + 16 bits     |zz| < 65536        20 bits
+ *   1111 + 32 bits     resto               36 bits
+ */
+
+#define FRAM_BLOCK_SIZE			128
+#define FRAM_BLOCK_HEADER		13
+#define FRAM_BLOCK_PAYLOAD		(FRAM_BLOCK_SIZE - FRAM_BLOCK_HEADER)
+#define FRAM_BLOCK_CHANNELS		7
+#define FRAM_BLOCK_MAX_SAMPLES	255
+
+#define FRAM_BLOCK_COMMIT_VALUE	0x5A
+
+// Mismas unidades que SampleV2_t
+typedef struct {
+	uint32_t timestamp;			// epoch Unix
+	uint16_t irradiance_dWm2;	// 0.1 W/m2
+	uint16_t batteryVoltage_mV;
+	int16_t airTemp_cC;			// 0.01 ºC
+	int16_t soilTemp_cC;		// 0.01 ºC
+	uint8_t airHumidity_perc;
+	uint8_t soilMoisture_perc;
+} BlockSample_t;
+
+// Imagen del bloque tal y como se guarda en FRAM (commit primero, como v2)
+typedef struct {
+	uint8_t commit;				// 1 byte
+	uint8_t count;				// 1 byte (muestras en el bloque)
+	uint16_t crc;				// 2 bytes (CRC-16 de count y de blockSeq en adelante)
+	uint32_t blockSeq;			// 4 bytes (secuencia del bloque, slot = blockSeq % N)
+	uint32_t firstSeq;			// 4 bytes (secuencia de la primera muestra)
+	uint8_t gen;				// 1 byte
+	uint8_t payload[FRAM_BLOCK_PAYLOAD];
+} FramBlockImage_t;
+
+_Static_assert(sizeof(FramBlockImage_t) == FRAM_BLOCK_SIZE, "FramBlockImage_t must be 128 bytes");
+_Static_assert(offsetof(FramBlockImage_t, payload) == FRAM_BLOCK_HEADER, "FramBlockImage_t header must be 13 bytes");
+
+// Estado del codificador/decodificador
+typedef struct {
+	FramBlockImage_t img;
+	uint16_t bitPos;
+	uint8_t index;
+	int32_t prev[FRAM_BLOCK_CHANNELS];
+	int32_t prevDelta;			// Último delta de la marca de tiempo
+} FramBlock_t;
+
+void FRAM_BlockBegin(FramBlock_t *blk, uint32_t blockSeq, uint32_t firstSeq, uint8_t gen);
+uint8_t FRAM_BlockAppend(FramBlock_t *blk, const BlockSample_t *s);
+void FRAM_BlockSeal(FramBlock_t *blk);
+
+uint8_t FRAM_BlockIsValid(const FramBlockImage_t *img, uint8_t gen);
+uint8_t FRAM_BlockResume(FramBlock_t *blk, const FramBlockImage_t *img);
+
+void FRAM_BlockDecodeBegin(FramBlock_t *dec, const FramBlockImage_t *img);
+uint8_t FRAM_BlockDecodeNext(FramBlock_t *dec, BlockSample_t *s);
+
+#endif /* FRAM_BLOCK_H_ */
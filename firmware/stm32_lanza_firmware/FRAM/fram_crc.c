@@ -0,0 +1,140 @@
+/*
+ * fram_crc.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "fram_crc.h"
+
+#define CRC_SLICES	4
+
+static uint16_t crcTable[CRC_SLICES][256];
+static uint8_t tableReady = 0;
+
+static FramCrcEngine_t activeEngine = FRAM_CRC_BITWISE;
+
+// T0 = CRC de un byte; Tk = CRC del byte seguido de k bytes a cero
+static void buildTable(void) {
+	for (uint16_t i = 0; i < 256; ++i) {
+		uint16_t crc = (uint16_t)(i << 8);
+		for (int b = 0; b < 8; b++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ FRAM_CRC_POLY) : (uint16_t)(crc << 1);
+		}
+		crcTable[0][i] = crc;
+	}
+
+	for (int k = 1; k < CRC_SLICES; ++k) {
+		for (uint16_t i = 0; i < 256; ++i) {
+			uint16_t prev = crcTable[k - 1][i];
+			crcTable[k][i] = (uint16_t)((prev << 8) ^ crcTable[0][prev >> 8]);
+		}
+	}
+
+	tableReady = 1;
+}
+
+#ifdef FRAM_CRC_HW_AVAILABLE
+static void hwInit(void) {
+	RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+	(void)RCC->AHB1ENR;
+
+	// Polinomio de 16 bits, sin reflexión de entrada ni salida
+	CRC->POL = FRAM_CRC_POLY;
+	CRC->INIT = FRAM_CRC_INIT;
+	CRC->CR = CRC_CR_POLYSIZE_0;
+}
+#endif
+
+// Tablas por defecto, las medidas en host (crc_bench); el periférico se elige con
+// FRAM_CrcSelect cuando FRAM_CrcBenchmark() lo mida más rápido en placa
+void FRAM_CrcInit(void) {
+	if (!tableReady) buildTable();
+
+	activeEngine = FRAM_CRC_TABLE;
+}
+
+void FRAM_CrcSelect(FramCrcEngine_t engine) {
+#ifndef FRAM_CRC_HW_AVAILABLE
+	if (engine == FRAM_CRC_HARDWARE) engine = FRAM_CRC_TABLE;
+#else
+	if (engine == FRAM_CRC_HARDWARE) hwInit();
+#endif
+	if (engine == FRAM_CRC_TABLE && !tableReady) buildTable();
+
+	activeEngine = engine;
+}
+
+FramCrcEngine_t FRAM_CrcEngine(void) {
+	return activeEngine;
+}
+
+uint16_t FRAM_Crc16Bitwise(uint16_t crc, const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ FRAM_CRC_POLY) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint16_t FRAM_Crc16Table(uint16_t crc, const uint8_t *data, size_t len) {
+	if (!tableReady) buildTable();
+
+	// 4 bytes por iteración: solo los dos primeros se mezclan con el CRC
+	while (len >= CRC_SLICES) {
+		crc = (uint16_t)(crcTable[3][(crc >> 8) ^ data[0]] ^
+						 crcTable[2][(crc & 0xFF) ^ data[1]] ^
+						 crcTable[1][data[2]] ^
+						 crcTable[0][data[3]]);
+		data += CRC_SLICES;
+		len -= CRC_SLICES;
+	}
+
+	while (len--) {
+		crc = (uint16_t)((crc << 8) ^ crcTable[0][(crc >> 8) ^ *data++]);
+	}
+
+	return crc;
+}
+
+#ifdef FRAM_CRC_HW_AVAILABLE
+uint16_t FRAM_Crc16Hardware(uint16_t crc, const uint8_t *data, size_t len) {
+	// El valor inicial permite continuar un CRC parcial
+	CRC->INIT = crc;
+	CRC->CR |= CRC_CR_RESET;
+
+	// Palabras de 32 bits: el periférico procesa primero el bit 31
+	while (len >= 4) {
+		uint32_t w = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+					 ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+		CRC->DR = w;
+		data += 4;
+		len -= 4;
+	}
+
+	while (len--) {
+		*(__IO uint8_t *)&CRC->DR = *data++;
+	}
+
+	return (uint16_t)CRC->DR;
+}
+#endif
+
+uint16_t FRAM_Crc16Update(uint16_t crc, const uint8_t *data, size_t len) {
+	switch (activeEngine) {
+#ifdef FRAM_CRC_HW_AVAILABLE
+	case FRAM_CRC_HARDWARE:
+		return FRAM_Crc16Hardware(crc, data, len);
+#endif
+	case FRAM_CRC_TABLE:
+		return FRAM_Crc16Table(crc, data, len);
+	default:
+		return FRAM_Crc16Bitwise(crc, data, len);
+	}
+}
+
+uint16_t FRAM_Crc16(const uint8_t *data, size_t len) {
+	return FRAM_Crc16Update(FRAM_CRC_INIT, data, len);
+}
@@ -0,0 +1,45 @@
+/*
+ * fram_crc.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef FRAM_CRC_H_
+#define FRAM_CRC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, sin reflexión, sin XOR final
+#define FRAM_CRC_POLY		0x1021
+#define FRAM_CRC_INIT		0xFFFF
+
+// Periférico CRC disponible solo en el firmware (CMSIS define CRC)
+#if defined(USE_HAL_DRIVER)
+#include "stm32wbxx.h"
+#if defined(CRC)
+#define FRAM_CRC_HW_AVAILABLE	1
+#endif
+#endif
+
+typedef enum {
+	FRAM_CRC_BITWISE = 0,	// Bit a bit (implementación original)
+	FRAM_CRC_TABLE,			// Tablas slice-by-4
+	FRAM_CRC_HARDWARE		// Periférico CRC del STM32WB
+} FramCrcEngine_t;
+
+void FRAM_CrcInit(void);
+void FRAM_CrcSelect(FramCrcEngine_t engine);
+FramCrcEngine_t FRAM_CrcEngine(void);
+
+uint16_t FRAM_Crc16(const uint8_t *data, size_t len);
+uint16_t FRAM_Crc16Update(uint16_t crc, const uint8_t *data, size_t len);
+
+uint16_t FRAM_Crc16Bitwise(uint16_t crc, const uint8_t *data, size_t len);
+uint16_t FRAM_Crc16Table(uint16_t crc, const uint8_t *data, size_t len);
+#ifdef FRAM_CRC_HW_AVAILABLE
+uint16_t FRAM_Crc16Hardware(uint16_t crc, const uint8_t *data, size_t len);
+#endif
+
+#endif /* FRAM_CRC_H_ */
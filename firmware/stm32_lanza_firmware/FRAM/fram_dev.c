@@ -0,0 +1,108 @@
+/*
+ * fram_dev.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "fram_dev.h"
+
+#ifdef FRAM_HOST
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static HAL_StatusTypeDef fileRead(void *ctx, uint16_t addr, uint8_t *data, size_t len) {
+	FramFile_t *file = ctx;
+
+	if ((uint32_t)addr + len > FRAM_SIZE) return HAL_ERROR;
+
+	memcpy(data, file->map + addr, len);
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef fileWritev(void *ctx, const FramSeg_t *seg, size_t n) {
+	FramFile_t *file = ctx;
+
+	for (size_t i = 0; i < n; ++i) {
+		if ((uint32_t)seg[i].addr + seg[i].len > FRAM_SIZE) return HAL_ERROR;
+	}
+
+	for (size_t i = 0; i < n; ++i) memcpy(file->map + seg[i].addr, seg[i].data, seg[i].len);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_DevOpenFile(FramDev_t *dev, FramFile_t *file, const char *path, uint8_t flags) {
+	struct stat st;
+
+	file->fd = open(path, (flags & FRAM_FILE_CREATE) ? O_RDWR | O_CREAT : O_RDWR, 0644);
+	if (file->fd < 0 && !(flags & FRAM_FILE_CREATE)) file->fd = open(path, O_RDONLY);
+	if (file->fd < 0) return HAL_ERROR;
+
+	if (fstat(file->fd, &st) != 0) goto fail;
+
+	// Una imagen corta solo se acepta si se puede completar
+	if (st.st_size < FRAM_SIZE) {
+		if (!(flags & FRAM_FILE_CREATE) || ftruncate(file->fd, FRAM_SIZE) != 0) goto fail;
+	}
+
+	// Solo lectura: siempre copia privada
+	int writable = (fcntl(file->fd, F_GETFL) & O_ACCMODE) == O_RDWR;
+	int shared = writable && !(flags & FRAM_FILE_PRIVATE);
+
+	file->map = mmap(NULL, FRAM_SIZE, PROT_READ | PROT_WRITE, shared ? MAP_SHARED : MAP_PRIVATE, file->fd, 0);
+	if (file->map == MAP_FAILED) goto fail;
+
+	dev->init = NULL;
+	dev->read = fileRead;
+	dev->writev = fileWritev;
+	dev->size = FRAM_SIZE;
+	dev->ctx = file;
+	return HAL_OK;
+
+fail:
+	close(file->fd);
+	file->fd = -1;
+	return HAL_ERROR;
+}
+
+void FRAM_DevCloseFile(FramDev_t *dev) {
+	FramFile_t *file = dev->ctx;
+
+	munmap(file->map, FRAM_SIZE);
+	close(file->fd);
+	file->fd = -1;
+	dev->ctx = NULL;
+}
+
+#else
+
+_Static_assert(sizeof(FramSeg_t) == sizeof(MB85RS256B_Seg_t), "FramSeg_t must match MB85RS256B_Seg_t");
+_Static_assert(offsetof(FramSeg_t, data) == offsetof(MB85RS256B_Seg_t, data), "FramSeg_t must match MB85RS256B_Seg_t");
+_Static_assert(offsetof(FramSeg_t, len) == offsetof(MB85RS256B_Seg_t, len), "FramSeg_t must match MB85RS256B_Seg_t");
+_Static_assert(offsetof(FramSeg_t, barrier) == offsetof(MB85RS256B_Seg_t, barrier), "FramSeg_t must match MB85RS256B_Seg_t");
+
+static HAL_StatusTypeDef spiInit(void *ctx) {
+	return MB85RS256B_Init(ctx);
+}
+
+static HAL_StatusTypeDef spiRead(void *ctx, uint16_t addr, uint8_t *data, size_t len) {
+	return MB85RS256B_Read(ctx, addr, data, len);
+}
+
+static HAL_StatusTypeDef spiWritev(void *ctx, const FramSeg_t *seg, size_t n) {
+	return MB85RS256B_Writev(ctx, (const MB85RS256B_Seg_t *)seg, n);
+}
+
+void FRAM_DevMB85RS256B(FramDev_t *dev, MB85RS256B_t *fram) {
+	dev->init = spiInit;
+	dev->read = spiRead;
+	dev->writev = spiWritev;
+	dev->size = MB85RS256B_SIZE;
+	dev->ctx = fram;
+}
+
+#endif
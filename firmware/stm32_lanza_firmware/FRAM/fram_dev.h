@@ -0,0 +1,97 @@
+/*
+ * fram_dev.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef FRAM_DEV_H_
+#define FRAM_DEV_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Dispositivo de almacenamiento bajo FramRing_t: lectura, escritura por
+ * segmentos y tamaño. En el equipo es la MB85RS256B; en Linux (herramientas y
+ * pruebas de host) un fichero de imagen de 32 KB mapeado en memoria, sin HAL.
+ */
+
+#if defined(__linux__) && !defined(USE_HAL_DRIVER)
+#define FRAM_HOST
+#endif
+
+#ifdef FRAM_HOST
+typedef enum {
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+#define FRAM_SIZE				32768
+#else
+#include "stm32wbxx_hal.h"
+#include "MB85RS256B.h"
+
+#define FRAM_SIZE				MB85RS256B_SIZE
+#endif
+
+// Mismo formato que MB85RS256B_Seg_t: los segmentos se escriben en orden
+typedef struct {
+	uint16_t addr;
+	const uint8_t *data;
+	uint16_t len;
+	uint8_t barrier;			// No se fusiona con el segmento anterior
+} FramSeg_t;
+
+typedef struct {
+	HAL_StatusTypeDef (*init)(void *ctx);
+	HAL_StatusTypeDef (*read)(void *ctx, uint16_t addr, uint8_t *data, size_t len);
+	HAL_StatusTypeDef (*writev)(void *ctx, const FramSeg_t *seg, size_t n);
+	uint32_t size;				// Bytes direccionables
+	void *ctx;
+} FramDev_t;
+
+static inline HAL_StatusTypeDef FRAM_DevRead(FramDev_t *dev, uint16_t addr, uint8_t *data, size_t len) {
+	return dev->read(dev->ctx, addr, data, len);
+}
+
+static inline HAL_StatusTypeDef FRAM_DevWritev(FramDev_t *dev, const FramSeg_t *seg, size_t n) {
+	return dev->writev(dev->ctx, seg, n);
+}
+
+static inline HAL_StatusTypeDef FRAM_DevWrite(FramDev_t *dev, uint16_t addr, const uint8_t *data, size_t len) {
+	if (len > UINT16_MAX) return HAL_ERROR;
+
+	FramSeg_t seg = { .addr = addr, .data = data, .len = (uint16_t)len };
+	return dev->writev(dev->ctx, &seg, 1);
+}
+
+// Registro con el commit a 0 y después su byte de commit, en una sola llamada al dispositivo
+static inline HAL_StatusTypeDef FRAM_DevWriteCommitted(FramDev_t *dev, uint16_t addr, const void *rec, uint16_t len, uint16_t commitOffset, uint8_t commit) {
+	FramSeg_t seg[2] = {
+		{ .addr = addr, .data = (const uint8_t*)rec, .len = len },
+		{ .addr = (uint16_t)(addr + commitOffset), .data = &commit, .len = 1, .barrier = 1 }
+	};
+
+	return dev->writev(dev->ctx, seg, 2);
+}
+
+#ifdef FRAM_HOST
+// Opciones de FRAM_DevOpenFile
+#define FRAM_FILE_CREATE		0x01	// Crea el fichero o lo completa con ceros hasta 32 KB
+#define FRAM_FILE_PRIVATE		0x02	// Copia privada: las escrituras no llegan al fichero
+
+typedef struct {
+	int fd;
+	uint8_t *map;
+} FramFile_t;
+
+HAL_StatusTypeDef FRAM_DevOpenFile(FramDev_t *dev, FramFile_t *file, const char *path, uint8_t flags);
+void FRAM_DevCloseFile(FramDev_t *dev);
+#else
+void FRAM_DevMB85RS256B(FramDev_t *dev, MB85RS256B_t *fram);
+#endif
+
+#endif /* FRAM_DEV_H_ */
@@ -0,0 +1,137 @@
+/*
+ * fram_event.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "fram_event.h"
+#include "fram_seq.h"
+
+#include <string.h>
+
+static uint16_t recordCrc(const FramEventRecord_t *rec) {
+	uint16_t crc = FRAM_Crc16(&rec->code, 1);
+
+	const uint8_t *tail = (const uint8_t*)rec + offsetof(FramEventRecord_t, seq);
+	return FRAM_Crc16Update(crc, tail, sizeof(*rec) - offsetof(FramEventRecord_t, seq));
+}
+
+static inline uint16_t slotAddr(const FramEventLog_t *log, uint16_t slot) {
+	return (uint16_t)(log->start + slot * FRAM_EVENT_RECORD_SIZE);
+}
+
+static HAL_StatusTypeDef readSlot(FramEventLog_t *log, uint16_t slot, FramEventRecord_t *rec, uint8_t *valid) {
+	HAL_StatusTypeDef status = FRAM_DevRead(log->dev, slotAddr(log, slot), (uint8_t *)rec, sizeof(*rec));
+	if (status != HAL_OK) return status;
+
+	*valid = (rec->commit == FRAM_EVENT_COMMIT_VALUE) && (rec->seq % log->slots == slot) && (rec->crc == recordCrc(rec));
+	return HAL_OK;
+}
+
+// Vuelta del slot (seq / N) para FRAM_SeqRecover()
+static HAL_StatusTypeDef probeSlot(void *ctx, uint16_t slot, uint8_t *valid, uint32_t *lap) {
+	FramEventLog_t *log = ctx;
+	FramEventRecord_t rec;
+
+	HAL_StatusTypeDef status = readSlot(log, slot, &rec, valid);
+	if (status != HAL_OK) return status;
+
+	if (lap) *lap = rec.seq / log->slots;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_EventInit(FramEventLog_t *log, FramDev_t *dev, uint16_t start, uint16_t slots) {
+	log->dev = dev;
+	log->start = start;
+	log->slots = slots;
+	log->next_seq = 0;
+	log->count = 0;
+
+	if (slots == 0) return HAL_OK;
+	if (dev == NULL || (uint32_t)start + (uint32_t)slots * FRAM_EVENT_RECORD_SIZE > dev->size) {
+		log->slots = 0;
+		return HAL_ERROR;
+	}
+
+	return FRAM_SeqRecover(slots, probeSlot, log, &log->next_seq, &log->count);
+}
+
+// Borra la zona completa (p. ej. al reservarla sobre datos de otro uso)
+HAL_StatusTypeDef FRAM_EventFormat(FramEventLog_t *log) {
+	static const uint8_t zero[8 * FRAM_EVENT_RECORD_SIZE] = {0};
+
+	for (uint16_t slot = 0; slot < log->slots; slot += 8) {
+		uint16_t n = (log->slots - slot < 8) ? (uint16_t)(log->slots - slot) : 8;
+
+		HAL_StatusTypeDef status = FRAM_DevWrite(log->dev, slotAddr(log, slot), zero, n * FRAM_EVENT_RECORD_SIZE);
+		if (status != HAL_OK) return status;
+	}
+
+	log->next_seq = 0;
+	log->count = 0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_EventAppend(FramEventLog_t *log, uint8_t code, uint32_t timestamp, uint32_t arg) {
+	FramEventRecord_t rec = {0};
+
+	if (log->slots == 0) return HAL_ERROR;
+
+	rec.code = code;
+	rec.seq = log->next_seq;
+	rec.timestamp = timestamp;
+	rec.arg = arg;
+	rec.commit = 0;
+	rec.crc = recordCrc(&rec);
+
+	uint16_t slot = (uint16_t)(rec.seq % log->slots);
+	HAL_StatusTypeDef status = FRAM_DevWriteCommitted(log->dev, slotAddr(log, slot), &rec, sizeof(rec),
+													  offsetof(FramEventRecord_t, commit), FRAM_EVENT_COMMIT_VALUE);
+	if (status != HAL_OK) return status;
+
+	log->next_seq++;
+	if (log->count < log->slots) log->count++;
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_EventGet(FramEventLog_t *log, uint32_t seq, FramEventRecord_t *evt, uint8_t *valid) {
+	*valid = 0;
+	if (log->slots == 0 || seq >= log->next_seq || log->next_seq - seq > log->count) return HAL_OK;
+
+	HAL_StatusTypeDef status = readSlot(log, (uint16_t)(seq % log->slots), evt, valid);
+	if (status != HAL_OK) return status;
+
+	*valid = *valid && (evt->seq == seq);
+	return HAL_OK;
+}
+
+/*
+ * Entrega a fn los eventos desde la secuencia from (como mucho max, 0 = todos).
+ * *end es la secuencia por la que seguir; si from ya se ha sobrescrito se
+ * empieza por el más antiguo.
+ */
+HAL_StatusTypeDef FRAM_EventExport(FramEventLog_t *log, uint32_t from, uint16_t max, FramEventFn_t fn, void *ctx, uint32_t *end) {
+	uint32_t oldest = log->next_seq - log->count;
+	uint32_t seq = (from < oldest) ? oldest : (from > log->next_seq) ? log->next_seq : from;
+
+	uint32_t stop = log->next_seq;
+	if (max > 0 && stop - seq > max) stop = seq + max;
+
+	for (; seq < stop; ++seq) {
+		FramEventRecord_t evt;
+		uint8_t valid;
+
+		HAL_StatusTypeDef status = FRAM_EventGet(log, seq, &evt, &valid);
+		if (status != HAL_OK) {
+			if (end) *end = seq;
+			return status;
+		}
+
+		if (valid) fn(ctx, &evt);
+	}
+
+	if (end) *end = seq;
+	return HAL_OK;
+}
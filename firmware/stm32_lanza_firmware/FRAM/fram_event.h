@@ -0,0 +1,58 @@
+/*
+ * fram_event.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef FRAM_EVENT_H_
+#define FRAM_EVENT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fram_dev.h"
+#include "fram_crc.h"
+
+/*
+ * Registro de eventos en su propia zona de la FRAM: registros fijos de 16
+ * bytes (hora, código, argumento) en un anillo independiente del de muestras.
+ * El evento de secuencia s vive en el slot s % N y la cabeza se recupera por
+ * búsqueda binaria, igual que en los anillos de agregados. No depende de la
+ * generación del anillo de muestras: FRAM_Reset no borra los eventos.
+ */
+
+#define FRAM_EVENT_RECORD_SIZE	16
+#define FRAM_EVENT_COMMIT_VALUE	0xE1
+
+// Registro en FRAM (commit primero, como los agregados)
+typedef struct {
+	uint8_t commit;				// 1 byte
+	uint8_t code;				// 1 byte
+	uint16_t crc;				// 2 bytes (CRC-16 de code y de seq en adelante)
+	uint32_t seq;				// 4 bytes (slot = seq % N)
+	uint32_t timestamp;			// 4 bytes (epoch Unix, 0 = sin hora)
+	uint32_t arg;				// 4 bytes
+} FramEventRecord_t;
+
+_Static_assert(sizeof(FramEventRecord_t) == FRAM_EVENT_RECORD_SIZE, "FramEventRecord_t must be 16 bytes");
+
+typedef struct {
+	FramDev_t *dev;
+	uint16_t start;
+	uint16_t slots;				// 0 = sin registro de eventos
+	uint32_t next_seq;			// Secuencia del próximo evento
+	uint16_t count;				// Eventos en el anillo
+} FramEventLog_t;
+
+// Evento entregado por FRAM_EventExport
+typedef void (*FramEventFn_t)(void *ctx, const FramEventRecord_t *evt);
+
+HAL_StatusTypeDef FRAM_EventInit(FramEventLog_t *log, FramDev_t *dev, uint16_t start, uint16_t slots);
+HAL_StatusTypeDef FRAM_EventFormat(FramEventLog_t *log);
+
+HAL_StatusTypeDef FRAM_EventAppend(FramEventLog_t *log, uint8_t code, uint32_t timestamp, uint32_t arg);
+HAL_StatusTypeDef FRAM_EventGet(FramEventLog_t *log, uint32_t seq, FramEventRecord_t *evt, uint8_t *valid);
+HAL_StatusTypeDef FRAM_EventExport(FramEventLog_t *log, uint32_t from, uint16_t max, FramEventFn_t fn, void *ctx, uint32_t *end);
+
+#endif /* FRAM_EVENT_H_ */
@@ -0,0 +1,143 @@
+/*
+ * fram_kv.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "fram_kv.h"
+#include "fram_seq.h"
+
+#include <string.h>
+
+static uint16_t recordCrc(const FramKvRecord_t *rec) {
+	uint16_t crc = FRAM_Crc16(&rec->seq, 1);
+
+	const uint8_t *tail = (const uint8_t*)rec + offsetof(FramKvRecord_t, key);
+	return FRAM_Crc16Update(crc, tail, sizeof(*rec) - offsetof(FramKvRecord_t, key));
+}
+
+static uint8_t recordIsValid(const FramKvRecord_t *rec, uint8_t key) {
+	if (rec->commit != FRAM_KV_COMMIT_VALUE) return 0;
+	if (rec->key != key || rec->len > FRAM_KV_VALUE_MAX) return 0;
+
+	return (rec->crc == recordCrc(rec));
+}
+
+static inline uint16_t recordAddr(const FramKv_t *kv, uint8_t key, uint8_t seq) {
+	return (uint16_t)(kv->start + (2 * key + (seq & 1)) * FRAM_KV_RECORD_SIZE);
+}
+
+// Lee las dos copias de cada clave (una transferencia por clave) y se queda con la vigente
+HAL_StatusTypeDef FRAM_KvInit(FramKv_t *kv, FramDev_t *dev, uint16_t start, uint8_t keys) {
+	FramKvRecord_t rec[2];
+
+	if (keys > FRAM_KV_KEYS_MAX) return HAL_ERROR;
+	if (keys > 0 && (dev == NULL || (uint32_t)start + FRAM_KV_REGION_SIZE(keys) > dev->size)) return HAL_ERROR;
+
+	kv->dev = dev;
+	kv->start = start;
+	kv->keys = keys;
+	kv->present = 0;
+
+	for (uint8_t key = 0; key < keys; ++key) {
+		HAL_StatusTypeDef status = FRAM_DevRead(dev, recordAddr(kv, key, 0), (uint8_t *)rec, sizeof(rec));
+		if (status != HAL_OK) {
+			kv->keys = 0;
+			return status;
+		}
+
+		uint8_t valid[2] = { recordIsValid(&rec[0], key), recordIsValid(&rec[1], key) };
+
+		// Sin copias válidas la próxima escritura va a la A
+		kv->seq[key] = 0xFF;
+		if (!valid[0] && !valid[1]) continue;
+
+		const FramKvRecord_t *best = (valid[0] && valid[1]) ? (FRAM_SeqIsNewer(rec[0].seq, rec[1].seq) ? &rec[0] : &rec[1])
+															: (valid[0] ? &rec[0] : &rec[1]);
+		kv->seq[key] = best->seq;
+		if (best->len > 0) kv->present |= (uint32_t)1 << key;
+	}
+
+	return HAL_OK;
+}
+
+// Borra la zona completa (p. ej. al reservarla sobre datos de otro uso)
+HAL_StatusTypeDef FRAM_KvFormat(FramKv_t *kv) {
+	static const uint8_t zero[2 * FRAM_KV_RECORD_SIZE] = {0};
+
+	for (uint8_t key = 0; key < kv->keys; ++key) {
+		HAL_StatusTypeDef status = FRAM_DevWrite(kv->dev, recordAddr(kv, key, 0), zero, sizeof(zero));
+		if (status != HAL_OK) return status;
+
+		kv->seq[key] = 0xFF;
+	}
+
+	kv->present = 0;
+	return HAL_OK;
+}
+
+// *len = 0 si la clave no tiene valor; un valor mayor que size no se copia (HAL_ERROR)
+HAL_StatusTypeDef FRAM_KvGet(FramKv_t *kv, uint8_t key, void *value, uint8_t size, uint8_t *len) {
+	FramKvRecord_t rec;
+
+	*len = 0;
+	if (key >= kv->keys) return HAL_ERROR;
+	if (!FRAM_KvHas(kv, key)) return HAL_OK;
+
+	HAL_StatusTypeDef status = FRAM_DevRead(kv->dev, recordAddr(kv, key, kv->seq[key]), (uint8_t *)&rec, sizeof(rec));
+	if (status != HAL_OK) return status;
+
+	// La copia vigente solo cambia con FRAM_KvPut: si no es válida, la FRAM se ha alterado por otra vía
+	if (!recordIsValid(&rec, key) || rec.seq != kv->seq[key]) return HAL_ERROR;
+	if (rec.len > size) return HAL_ERROR;
+
+	memcpy(value, rec.value, rec.len);
+	*len = rec.len;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_KvPut(FramKv_t *kv, uint8_t key, const void *value, uint8_t len) {
+	FramKvRecord_t rec = {0};
+
+	if (key >= kv->keys || len > FRAM_KV_VALUE_MAX) return HAL_ERROR;
+
+	rec.seq = (uint8_t)(kv->seq[key] + 1);
+	rec.key = key;
+	rec.len = len;
+	if (len > 0) memcpy(rec.value, value, len);
+	rec.commit = 0;
+	rec.crc = recordCrc(&rec);
+
+	HAL_StatusTypeDef status = FRAM_DevWriteCommitted(kv->dev, recordAddr(kv, key, rec.seq), &rec, sizeof(rec),
+													  offsetof(FramKvRecord_t, commit), FRAM_KV_COMMIT_VALUE);
+	if (status != HAL_OK) return status;
+
+	kv->seq[key] = rec.seq;
+	if (len > 0) kv->present |= (uint32_t)1 << key;
+	else kv->present &= ~((uint32_t)1 << key);
+
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef FRAM_KvDelete(FramKv_t *kv, uint8_t key) {
+	if (!FRAM_KvHas(kv, key)) return (key < kv->keys) ? HAL_OK : HAL_ERROR;
+
+	return FRAM_KvPut(kv, key, NULL, 0);
+}
+
+// Contador de 32 bits (0 si la clave no existe); *value recibe el nuevo valor si no es NULL
+HAL_StatusTypeDef FRAM_KvAdd32(FramKv_t *kv, uint8_t key, uint32_t delta, uint32_t *value) {
+	uint32_t v = 0;
+	uint8_t len;
+
+	HAL_StatusTypeDef status = FRAM_KvGet(kv, key, &v, sizeof(v), &len);
+	if (status != HAL_OK) return status;
+	if (len != 0 && len != sizeof(v)) return HAL_ERROR;
+
+	v += delta;
+	status = FRAM_KvPut(kv, key, &v, sizeof(v));
+	if (status == HAL_OK && value) *value = v;
+
+	return status;
+}
@@ -0,0 +1,65 @@
+/*
+ * fram_kv.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef FRAM_KV_H_
+#define FRAM_KV_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fram_dev.h"
+#include "fram_crc.h"
+
+/*
+ * Registros clave-valor en una zona reservada de la FRAM. Cada clave tiene una
+ * posición fija con dos copias A/B de 32 bytes: se escribe siempre la copia que
+ * no es la vigente, con el commit al final, y al leer gana la válida con la
+ * secuencia más reciente (mismo esquema que el registro de generación). La
+ * dirección sale de la clave, así que leer o escribir una clave es una única
+ * transferencia.
+ */
+
+#define FRAM_KV_RECORD_SIZE		32
+#define FRAM_KV_VALUE_MAX		24
+#define FRAM_KV_KEYS_MAX		32
+#define FRAM_KV_COMMIT_VALUE	0x4B
+
+#define FRAM_KV_REGION_SIZE(keys)	((keys) * 2 * FRAM_KV_RECORD_SIZE)
+
+typedef struct {
+	uint8_t commit;				// 1 byte
+	uint8_t seq;				// 1 byte (selección A/B)
+	uint16_t crc;				// 2 bytes (CRC-16 de seq y de key en adelante)
+	uint8_t key;				// 1 byte
+	uint8_t len;				// 1 byte (0 = clave borrada)
+	uint16_t reserved;			// 2 bytes
+	uint8_t value[FRAM_KV_VALUE_MAX];
+} FramKvRecord_t;
+
+_Static_assert(sizeof(FramKvRecord_t) == FRAM_KV_RECORD_SIZE, "FramKvRecord_t must be 32 bytes");
+
+typedef struct {
+	FramDev_t *dev;
+	uint16_t start;				// Dirección de la clave 0 (copia A)
+	uint8_t keys;				// 0 = sin zona clave-valor
+	uint8_t seq[FRAM_KV_KEYS_MAX];	// Secuencia de la copia vigente de cada clave
+	uint32_t present;			// Bit por clave con valor guardado
+} FramKv_t;
+
+HAL_StatusTypeDef FRAM_KvInit(FramKv_t *kv, FramDev_t *dev, uint16_t start, uint8_t keys);
+HAL_StatusTypeDef FRAM_KvFormat(FramKv_t *kv);
+
+HAL_StatusTypeDef FRAM_KvGet(FramKv_t *kv, uint8_t key, void *value, uint8_t size, uint8_t *len);
+HAL_StatusTypeDef FRAM_KvPut(FramKv_t *kv, uint8_t key, const void *value, uint8_t len);
+HAL_StatusTypeDef FRAM_KvDelete(FramKv_t *kv, uint8_t key);
+HAL_StatusTypeDef FRAM_KvAdd32(FramKv_t *kv, uint8_t key, uint32_t delta, uint32_t *value);
+
+static inline uint8_t FRAM_KvHas(const FramKv_t *kv, uint8_t key) {
+	return (key < kv->keys) && ((kv->present >> key) & 1);
+}
+
+#endif /* FRAM_KV_H_ */
@@ -0,0 +1,66 @@
+/*
+ * fram_seq.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "fram_seq.h"
+
+/*
+ * Recupera la cabeza de un anillo sin cabeceras meta. El registro de secuencia
+ * s vive en el slot s % N, así que todos los slots de la vuelta actual comparten
+ * vuelta con el slot 0 y a partir de la cabeza deja de cumplirse: búsqueda
+ * binaria, O(log N) lecturas. Devuelve la próxima secuencia y los slots válidos.
+ */
+HAL_StatusTypeDef FRAM_SeqRecover(uint16_t slots, FramSeqProbeFn_t probe, void *ctx, uint32_t *next, uint16_t *used) {
+	HAL_StatusTypeDef status;
+	uint8_t valid;
+	uint32_t lap, last;
+	uint16_t n = slots;
+
+	*next = 0;
+	*used = 0;
+	if (n == 0) return HAL_OK;
+
+	status = probe(ctx, 0, &valid, &lap);
+	if (status != HAL_OK) return status;
+
+	if (valid) {
+		uint32_t lap0 = lap;
+		uint16_t lo = 0, hi = n;
+
+		while (hi - lo > 1) {
+			uint16_t mid = (uint16_t)((lo + hi) / 2);
+
+			status = probe(ctx, mid, &valid, &lap);
+			if (status != HAL_OK) return status;
+
+			if (valid && lap == lap0) lo = mid;
+			else hi = mid;
+		}
+
+		last = lap0 * n + lo;
+	}
+	else {
+		// Slot 0 vacío o cortado a medio escribir: la cabeza solo puede ser el último slot
+		status = probe(ctx, n - 1, &valid, &lap);
+		if (status != HAL_OK) return status;
+		if (!valid) return HAL_OK;
+
+		last = lap * n + (n - 1);
+	}
+
+	*next = last + 1;
+	*used = (*next < n) ? (uint16_t)*next : n;
+
+	// Anillo lleno: si el slot más antiguo quedó cortado no se cuenta
+	if (*used == n) {
+		status = probe(ctx, (uint16_t)(*next % n), &valid, NULL);
+		if (status != HAL_OK) return status;
+
+		if (!valid) (*used)--;
+	}
+
+	return HAL_OK;
+}
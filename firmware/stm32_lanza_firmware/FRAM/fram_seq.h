@@ -0,0 +1,30 @@
+/*
+ * fram_seq.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef FRAM_SEQ_H_
+#define FRAM_SEQ_H_
+
+#include <stdint.h>
+
+#include "fram_dev.h"
+
+/*
+ * Secuencias compartidas por los anillos de la FRAM (muestras, agregados y
+ * eventos) y por las copias A/B (cabecera, generación, valores clave).
+ */
+
+// Lee el slot: *valid y, si lap no es NULL, la vuelta a la que pertenece
+typedef HAL_StatusTypeDef (*FramSeqProbeFn_t)(void *ctx, uint16_t slot, uint8_t *valid, uint32_t *lap);
+
+// Secuencias de 8 bits de las copias A/B: a es más reciente que b (o igual)
+static inline uint8_t FRAM_SeqIsNewer(uint8_t a, uint8_t b) {
+	return (uint8_t)((uint8_t)(a - b) < 128);
+}
+
+HAL_StatusTypeDef FRAM_SeqRecover(uint16_t slots, FramSeqProbeFn_t probe, void *ctx, uint32_t *next, uint16_t *used);
+
+#endif /* FRAM_SEQ_H_ */
@@ -0,0 +1,124 @@
+/*
+ * fram_tier.c
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include "fram_tier.h"
+
+#include <string.h>
+
+// Valor no válido y signo de cada canal (mismos valores que FRAM_V2_*_INVALID)
+static const int32_t invalidValue[FRAM_AGG_CHANNELS] = { 0xFFFF, 0xFFFF, INT16_MIN, INT16_MIN, 0xFF, 0xFF };
+static const uint8_t isSigned[FRAM_AGG_CHANNELS] = { 0, 0, 1, 1, 0, 0 };
+
+static void toChannels(const BlockSample_t *s, int32_t v[FRAM_AGG_CHANNELS]) {
+	v[FRAM_AGG_IRRADIANCE] = s->irradiance_dWm2;
+	v[FRAM_AGG_BATTERY] = s->batteryVoltage_mV;
+	v[FRAM_AGG_AIR_TEMP] = s->airTemp_cC;
+	v[FRAM_AGG_SOIL_TEMP] = s->soilTemp_cC;
+	v[FRAM_AGG_AIR_HUM] = s->airHumidity_perc;
+	v[FRAM_AGG_SOIL_MOIST] = s->soilMoisture_perc;
+}
+
+static inline int32_t decode(int c, uint16_t v) {
+	return isSigned[c] ? (int32_t)(int16_t)v : (int32_t)v;
+}
+
+static uint16_t recordCrc(const FramAggRecord_t *rec) {
+	const uint8_t *body = (const uint8_t *)rec + offsetof(FramAggRecord_t, seq);
+	return FRAM_Crc16(body, sizeof(*rec) - offsetof(FramAggRecord_t, seq));
+}
+
+void FRAM_AggClear(FramAggregate_t *agg, uint32_t start, uint32_t span_s) {
+	memset(agg, 0, sizeof(*agg));
+	agg->start = start;
+	agg->span_s = span_s;
+}
+
+void FRAM_AggAddSample(FramAggregate_t *agg, const BlockSample_t *s) {
+	int32_t v[FRAM_AGG_CHANNELS];
+	toChannels(s, v);
+
+	agg->samples++;
+
+	for (int c = 0; c < FRAM_AGG_CHANNELS; ++c) {
+		if (v[c] == invalidValue[c]) continue;
+
+		if (agg->count[c] == 0 || v[c] < agg->min[c]) agg->min[c] = v[c];
+		if (agg->count[c] == 0 || v[c] > agg->max[c]) agg->max[c] = v[c];
+		agg->sum[c] += v[c];
+		agg->count[c]++;
+	}
+}
+
+void FRAM_AggMerge(FramAggregate_t *dst, const FramAggregate_t *src) {
+	dst->samples += src->samples;
+
+	for (int c = 0; c < FRAM_AGG_CHANNELS; ++c) {
+		if (src->count[c] == 0) continue;
+
+		if (dst->count[c] == 0 || src->min[c] < dst->min[c]) dst->min[c] = src->min[c];
+		if (dst->count[c] == 0 || src->max[c] > dst->max[c]) dst->max[c] = src->max[c];
+		dst->sum[c] += src->sum[c];
+		dst->count[c] += src->count[c];
+	}
+}
+
+// Media redondeada; el valor no válido del canal si no hay muestras
+int32_t FRAM_AggMean(const FramAggregate_t *agg, FramAggChannel_t ch) {
+	if (agg->count[ch] == 0) return invalidValue[ch];
+
+	int64_t n = agg->count[ch];
+	int64_t s = agg->sum[ch];
+	return (int32_t)((s >= 0) ? (s + n / 2) / n : (s - n / 2) / n);
+}
+
+void FRAM_AggToRecord(const FramAggregate_t *agg, FramAggRecord_t *rec, uint32_t seq, uint8_t gen) {
+	memset(rec, 0, sizeof(*rec));
+	rec->gen = gen;
+	rec->seq = seq;
+	rec->start = agg->start;
+	rec->samples = agg->samples;
+
+	for (int c = 0; c < FRAM_AGG_CHANNELS; ++c) {
+		FramAggChannelRecord_t *r = &rec->ch[c];
+
+		if (agg->count[c] == 0) {
+			r->min = r->max = r->mean = (uint16_t)invalidValue[c];
+			continue;
+		}
+
+		r->min = (uint16_t)agg->min[c];
+		r->max = (uint16_t)agg->max[c];
+		r->mean = (uint16_t)FRAM_AggMean(agg, (FramAggChannel_t)c);
+		r->count = (agg->count[c] > 0xFFFF) ? 0xFFFF : (uint16_t)agg->count[c];
+	}
+
+	rec->commit = 0;
+	rec->crc = recordCrc(rec);
+}
+
+// La suma se reconstruye con la media guardada: error de redondeo < 0.5 unidades por intervalo
+void FRAM_AggFromRecord(const FramAggRecord_t *rec, uint32_t span_s, FramAggregate_t *agg) {
+	FRAM_AggClear(agg, rec->start, span_s);
+	agg->samples = rec->samples;
+
+	for (int c = 0; c < FRAM_AGG_CHANNELS; ++c) {
+		const FramAggChannelRecord_t *r = &rec->ch[c];
+		if (r->count == 0) continue;
+
+		agg->min[c] = decode(c, r->min);
+		agg->max[c] = decode(c, r->max);
+		agg->count[c] = r->count;
+		agg->sum[c] = (int64_t)decode(c, r->mean) * r->count;
+	}
+}
+
+uint8_t FRAM_AggRecordIsValid(const FramAggRecord_t *rec, uint8_t gen) {
+	if (rec->commit != FRAM_AGG_COMMIT_VALUE) return 0;
+	if (rec->gen != gen) return 0;
+
+	return (rec->crc == recordCrc(rec));
+}
@@ -0,0 +1,76 @@
+/*
+ * fram_tier.h
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#ifndef FRAM_TIER_H_
+#define FRAM_TIER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "fram_crc.h"
+#include "fram_block.h"
+
+/*
+ * Agregados por intervalo (hora, día): mínimo, máximo, media y número de
+ * muestras válidas de cada canal, en las mismas unidades que SampleV2_t.
+ * Se actualizan muestra a muestra en RAM y se guardan al cerrar el intervalo.
+ */
+
+#define FRAM_AGG_RECORD_SIZE	64
+#define FRAM_AGG_COMMIT_VALUE	0xC3
+
+typedef enum {
+	FRAM_AGG_IRRADIANCE = 0,	// 0.1 W/m2
+	FRAM_AGG_BATTERY,			// mV
+	FRAM_AGG_AIR_TEMP,			// 0.01 ºC
+	FRAM_AGG_SOIL_TEMP,			// 0.01 ºC
+	FRAM_AGG_AIR_HUM,			// %
+	FRAM_AGG_SOIL_MOIST,		// %
+	FRAM_AGG_CHANNELS
+} FramAggChannel_t;
+
+// Agregado en RAM
+typedef struct {
+	uint32_t start;				// Inicio del intervalo (epoch Unix)
+	uint32_t span_s;			// Duración del intervalo
+	uint32_t samples;			// Muestras con hora válida
+	int32_t min[FRAM_AGG_CHANNELS];
+	int32_t max[FRAM_AGG_CHANNELS];
+	int64_t sum[FRAM_AGG_CHANNELS];
+	uint32_t count[FRAM_AGG_CHANNELS];
+} FramAggregate_t;
+
+typedef struct {
+	uint16_t min;				// Codificación de SampleV2_t (temperaturas con signo)
+	uint16_t max;
+	uint16_t mean;
+	uint16_t count;				// Saturado a 65535
+} FramAggChannelRecord_t; // 8 bytes
+
+// Registro en FRAM (commit primero, como v2 y los bloques)
+typedef struct {
+	uint8_t commit;				// 1 byte
+	uint8_t gen;				// 1 byte
+	uint16_t crc;				// 2 bytes (CRC-16 de seq en adelante)
+	uint32_t seq;				// 4 bytes (slot = seq % N)
+	uint32_t start;				// 4 bytes
+	uint32_t samples;			// 4 bytes
+	FramAggChannelRecord_t ch[FRAM_AGG_CHANNELS];
+} FramAggRecord_t;
+
+_Static_assert(sizeof(FramAggRecord_t) == FRAM_AGG_RECORD_SIZE, "FramAggRecord_t must be 64 bytes");
+
+void FRAM_AggClear(FramAggregate_t *agg, uint32_t start, uint32_t span_s);
+void FRAM_AggAddSample(FramAggregate_t *agg, const BlockSample_t *s);
+void FRAM_AggMerge(FramAggregate_t *dst, const FramAggregate_t *src);
+int32_t FRAM_AggMean(const FramAggregate_t *agg, FramAggChannel_t ch);
+
+void FRAM_AggToRecord(const FramAggregate_t *agg, FramAggRecord_t *rec, uint32_t seq, uint8_t gen);
+void FRAM_AggFromRecord(const FramAggRecord_t *rec, uint32_t span_s, FramAggregate_t *agg);
+uint8_t FRAM_AggRecordIsValid(const FramAggRecord_t *rec, uint8_t gen);
+
+#endif /* FRAM_TIER_H_ */
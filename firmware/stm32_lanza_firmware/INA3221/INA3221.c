@@ -21,6 +21,25 @@ static HAL_StatusTypeDef writeRegister(INA3221_t *dev, uint8_t reg, uint16_t val
                              HAL_MAX_DELAY);
 }
 
+static uint32_t convTime_us(INA3221_ConversionTime_t ct) {
+    switch (ct) {
+        case INA3221_CT_140us:  return 140;
+        case INA3221_CT_204us:  return 204;
+        case INA3221_CT_332us:  return 332;
+        case INA3221_CT_588us:  return 588;
+        case INA3221_CT_1100us: return 1100;
+        case INA3221_CT_2116us: return 2116;
+        case INA3221_CT_4156us: return 4156;
+        default:                return 8244;
+    }
+}
+
+static uint32_t averages(INA3221_AveragingMode_t avg) {
+    static const uint16_t n[8] = { 1, 4, 16, 64, 128, 256, 512, 1024 };
+
+    return n[avg & 0x07];
+}
+
 static HAL_StatusTypeDef readRegister(INA3221_t *dev, uint8_t reg, uint8_t *value) {
     return HAL_I2C_Mem_Read(dev->hi2c,
                             INA3221_ADDRESS,
@@ -31,10 +50,151 @@ static HAL_StatusTypeDef readRegister(INA3221_t *dev, uint8_t reg, uint8_t *valu
                             HAL_MAX_DELAY);
 }
 
+static uint16_t configValue(INA3221_t *dev) {
+	return (1<<14) | (1<<13) | (1<<12) | (dev->averagingMode << 9) | (dev->convTimeBus << 6) | (dev->convTimeShunt << 3) | (dev->operatingMode);
+}
+
+static HAL_StatusTypeDef writeConfig(INA3221_t *dev, uint16_t config) {
+    HAL_StatusTypeDef status = writeRegister(dev, INA3221_REG_CONFIG, config);
+    if (status == HAL_OK) dev->regConfig = config;
+
+    return status;
+}
+
 HAL_StatusTypeDef INA3221_Init(INA3221_t *dev) {
-	uint16_t config = (1<<14) | (1<<13) | (1<<12) | (dev->averagingMode << 9) | (dev->convTimeBus << 6) | (dev->convTimeShunt << 3) | (dev->operatingMode);
+    return writeConfig(dev, configValue(dev));
+}
+
+HAL_StatusTypeDef INA3221_Configure(INA3221_t *dev) {
+	// Only writes the configuration when it differs from the device
+	if (dev->regConfig == configValue(dev)) return HAL_OK;
+
+	return INA3221_Init(dev);
+}
+
+void INA3221_PowerLost(INA3221_t *dev) {
+	dev->regConfig = INA3221_CONFIG_DEFAULT;
+}
+
+HAL_StatusTypeDef INA3221_StartConversion(INA3221_t *dev) {
+    // Escribir la configuración reinicia el ciclo de conversión (o lanza uno en modo triggered)
+    return INA3221_Init(dev);
+}
+
+HAL_StatusTypeDef INA3221_IsConversionReady(INA3221_t *dev, uint8_t *ready) {
+    uint8_t buf[2];
+    HAL_StatusTypeDef ret;
+
+    // Leer el registro borra CVRF y los flags de alerta: se guardan para INA3221_ReadFlags
+    ret = readRegister(dev, INA3221_REG_MASK_ENABLE, buf);
+    if (ret != HAL_OK) return ret;
+
+    dev->flags |= (((uint16_t)buf[0] << 8) | buf[1]) & INA3221_MASK_ALERTS;
+    *ready = (buf[1] & INA3221_MASK_CVRF) ? 1 : 0;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef INA3221_PowerDown(INA3221_t *dev) {
+    // Los registros de resultado y la configuración de promediado se mantienen
+    return writeConfig(dev, (configValue(dev) & ~0x0007) | INA3221_MODE_POWER_DOWN);
+}
+
+uint32_t INA3221_ConversionTime_ms(INA3221_t *dev) {
+    uint32_t t_us = 0;
+
+    // Los 3 canales se convierten en serie: shunt y/o bus por canal
+    if (dev->operatingMode & 0b001) t_us += convTime_us(dev->convTimeShunt);
+    if (dev->operatingMode & 0b010) t_us += convTime_us(dev->convTimeBus);
 
-    return writeRegister(dev, INA3221_REG_CONFIG, config);
+    t_us *= 3 * averages(dev->averagingMode);
+
+    return (t_us + 999) / 1000;
+}
+
+// Promediado y tiempo de conversión del shunt con el menor tiempo total que da el ruido pedido
+void INA3221_SetNoiseTarget(INA3221_t *dev, float noise_uV) {
+    // Ruido ~ SHUNT_NOISE * sqrt(1100 us / (tiempo de conversión * promedios)): solo cuenta el producto
+    float ratio = (noise_uV > 0.0f) ? INA3221_SHUNT_NOISE_UV / noise_uV : 1e3f;
+    float need_us = 1100.0f * ratio * ratio;
+    uint32_t best_us = UINT32_MAX;
+
+    // Sin combinación suficiente se queda la más larga
+    dev->averagingMode = INA3221_AVG_1024;
+    dev->convTimeShunt = INA3221_CT_8244us;
+
+    // Con el mismo producto gana menos promedios con conversión más larga (mejor rechazo de 50 Hz)
+    for (uint8_t avg = INA3221_AVG_1; avg <= INA3221_AVG_1024; avg++) {
+        for (uint8_t ct = INA3221_CT_140us; ct <= INA3221_CT_8244us; ct++) {
+            uint32_t t_us = convTime_us((INA3221_ConversionTime_t)ct) * averages((INA3221_AveragingMode_t)avg);
+
+            if ((float)t_us >= need_us && t_us < best_us) {
+                best_us = t_us;
+                dev->averagingMode = (INA3221_AveragingMode_t)avg;
+                dev->convTimeShunt = (INA3221_ConversionTime_t)ct;
+            }
+        }
+    }
+}
+
+// Límite en el formato del registro de shunt (LSB 40 uV, bits 15..3), saturado a +-163.8 mV
+static uint16_t shuntLimit(INA3221_t *dev, uint8_t channel, float current_mA) {
+    float code = current_mA / 1000.0f * dev->shuntResistance[channel - 1] / INA3221_SHUNT_VOLTAGE_LSB;
+
+    if (code > 4095.0f) code = 4095.0f;
+    if (code < -4096.0f) code = -4096.0f;
+
+    return (uint16_t)((int16_t)code * 8);
+}
+
+// Límite en el formato del registro de bus (LSB 8 mV, bits 15..3)
+static uint16_t busLimit(float voltage_V) {
+    float code = voltage_V / INA3221_BUS_VOLTAGE_LSB;
+
+    if (code > 4095.0f) code = 4095.0f;
+    if (code < 0.0f) code = 0.0f;
+
+    return (uint16_t)((uint16_t)code << 3);
+}
+
+// Crítico: cada conversión de shunt; aviso: el valor promediado. Corriente positiva de IN+ a IN-
+HAL_StatusTypeDef INA3221_SetCurrentLimits(INA3221_t *dev, uint8_t channel, float critical_mA, float warning_mA) {
+    if (channel < 1 || channel > 3) return HAL_ERROR;
+
+    uint8_t reg = (uint8_t)((channel - 1) * 2);
+    HAL_StatusTypeDef status = writeRegister(dev, INA3221_REG_CRITICAL_1 + reg, shuntLimit(dev, channel, critical_mA));
+    if (status != HAL_OK) return status;
+
+    return writeRegister(dev, INA3221_REG_WARNING_1 + reg, shuntLimit(dev, channel, warning_mA));
+}
+
+// PV sube con los tres buses por encima de upper y baja en cuanto uno cae por debajo de lower
+HAL_StatusTypeDef INA3221_SetPowerValid(INA3221_t *dev, float upper_V, float lower_V) {
+    if (lower_V > upper_V) return HAL_ERROR;
+
+    HAL_StatusTypeDef status = writeRegister(dev, INA3221_REG_PV_UPPER, busLimit(upper_V));
+    if (status != HAL_OK) return status;
+
+    return writeRegister(dev, INA3221_REG_PV_LOWER, busLimit(lower_V));
+}
+
+// Con latch, los pines de crítico y aviso quedan activos hasta leer el registro aunque la condición desaparezca
+HAL_StatusTypeDef INA3221_SetAlertLatch(INA3221_t *dev, uint8_t latch) {
+    return writeRegister(dev, INA3221_REG_MASK_ENABLE, latch ? (INA3221_MASK_WEN | INA3221_MASK_CEN) : 0);
+}
+
+// Flags de alerta (INA3221_MASK_*) desde la última llamada; libera los pines con latch
+HAL_StatusTypeDef INA3221_ReadFlags(INA3221_t *dev, uint16_t *flags) {
+    uint8_t buf[2];
+    HAL_StatusTypeDef ret;
+
+    ret = readRegister(dev, INA3221_REG_MASK_ENABLE, buf);
+    if (ret != HAL_OK) return ret;
+
+    *flags = dev->flags | ((((uint16_t)buf[0] << 8) | buf[1]) & INA3221_MASK_ALERTS);
+    dev->flags = 0;
+
+    return HAL_OK;
 }
 
 HAL_StatusTypeDef INA3221_ReadVoltage(INA3221_t *dev, uint8_t channel, float *busVoltage, float *shuntVoltage) {
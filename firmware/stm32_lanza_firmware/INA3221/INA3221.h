@@ -20,11 +20,31 @@
 #define INA3221_REG_BUS_VOLTAGE_2   0x04 // Channel 2 bus voltage register
 #define INA3221_REG_SHUNT_VOLTAGE_3 0x05 // Channel 3 shunt voltage register
 #define INA3221_REG_BUS_VOLTAGE_3   0x06 // Channel 3 bus voltage register
+#define INA3221_REG_CRITICAL_1      0x07 // Channel 1 critical alert limit register (+2 per channel)
+#define INA3221_REG_WARNING_1       0x08 // Channel 1 warning alert limit register (+2 per channel)
+#define INA3221_REG_MASK_ENABLE     0x0F // Mask/enable register (flags clear on read)
+#define INA3221_REG_PV_UPPER        0x10 // Power-valid upper limit register
+#define INA3221_REG_PV_LOWER        0x11 // Power-valid lower limit register
+
+// Mask/enable bits
+#define INA3221_MASK_WEN            0x0800 // Warning alert latched until the register is read
+#define INA3221_MASK_CEN            0x0400 // Critical alert latched until the register is read
+#define INA3221_MASK_CF(ch)         (0x0200 >> ((ch) - 1)) // Critical flag of channel 1..3
+#define INA3221_MASK_WF(ch)         (0x0020 >> ((ch) - 1)) // Warning flag of channel 1..3
+#define INA3221_MASK_PVF            0x0004 // Power-valid flag
+#define INA3221_MASK_TCF            0x0002 // Timing-control flag
+#define INA3221_MASK_CVRF           0x0001 // Conversion ready flag
+#define INA3221_MASK_ALERTS         0x03BC // Critical, warning and power-valid flags
 
 // Constants
 #define INA3221_SHUNT_VOLTAGE_LSB   40e-6f // Shunt voltage LSB (40 µV/bit)
 #define INA3221_BUS_VOLTAGE_LSB     0.008f // Bus voltage LSB (8 mV/bit)
 
+#define INA3221_POWERUP_MS          1      // Power-on time (40 us max)
+#define INA3221_CONFIG_DEFAULT      0x7127 // Configuration register reset value
+#define INA3221_SHUNT_NOISE_UV      40.0f  // Shunt noise of one 1.1 ms conversion (~1 LSB, board estimate)
+#define INA3221_LIMIT_OFF           1e6f   // Current limit that saturates to the reset value: never fires
+
 // Averaging mode
 typedef enum {
     INA3221_AVG_1    = 0b000, // 1
@@ -68,11 +88,26 @@ typedef struct {
     INA3221_ConversionTime_t convTimeShunt; // Shunt voltage conversion time
     INA3221_ConversionTime_t convTimeBus; // Bus voltage conversion time
     INA3221_OperatingMode_t operatingMode; // Operating mode
+    uint16_t regConfig; // Last value written to the configuration register
+    uint16_t flags; // Alert flags read since the last INA3221_ReadFlags
 } INA3221_t;
 
 // Functions
 HAL_StatusTypeDef INA3221_Init(INA3221_t *dev);
 
+HAL_StatusTypeDef INA3221_Configure(INA3221_t *dev);
+void INA3221_PowerLost(INA3221_t *dev);
+HAL_StatusTypeDef INA3221_StartConversion(INA3221_t *dev);
+HAL_StatusTypeDef INA3221_IsConversionReady(INA3221_t *dev, uint8_t *ready);
+HAL_StatusTypeDef INA3221_PowerDown(INA3221_t *dev);
+uint32_t INA3221_ConversionTime_ms(INA3221_t *dev);
+void INA3221_SetNoiseTarget(INA3221_t *dev, float noise_uV);
+
+HAL_StatusTypeDef INA3221_SetCurrentLimits(INA3221_t *dev, uint8_t channel, float critical_mA, float warning_mA);
+HAL_StatusTypeDef INA3221_SetPowerValid(INA3221_t *dev, float upper_V, float lower_V);
+HAL_StatusTypeDef INA3221_SetAlertLatch(INA3221_t *dev, uint8_t latch);
+HAL_StatusTypeDef INA3221_ReadFlags(INA3221_t *dev, uint16_t *flags);
+
 HAL_StatusTypeDef INA3221_ReadVoltage(INA3221_t *dev, uint8_t channel, float *busVoltage, float *shuntVoltage);
 float INA3221_CalculateCurrent_mA(INA3221_t *dev, uint8_t channel, float shuntVoltage);
 float INA3221_CalculatePower_mW(float busVoltage, float shuntCurrent_mA);
@@ -14,9 +14,57 @@ HAL_StatusTypeDef SEN0308_Init(SEN0308_t *dev) {
 	return HAL_OK;
 }
 
+// DMA destination of the oversampled conversion
+static uint16_t dmaResult;
+
+static const uint32_t ovsRatio[] = {
+	0, ADC_OVERSAMPLING_RATIO_2, ADC_OVERSAMPLING_RATIO_4, ADC_OVERSAMPLING_RATIO_8, ADC_OVERSAMPLING_RATIO_16,
+	ADC_OVERSAMPLING_RATIO_32, ADC_OVERSAMPLING_RATIO_64, ADC_OVERSAMPLING_RATIO_128, ADC_OVERSAMPLING_RATIO_256
+};
+
+static const uint32_t ovsShift[] = {
+	ADC_RIGHTBITSHIFT_NONE, ADC_RIGHTBITSHIFT_1, ADC_RIGHTBITSHIFT_2, ADC_RIGHTBITSHIFT_3, ADC_RIGHTBITSHIFT_4
+};
+
+// The asynchronous ADC clock from PLLSAI1 stops in STOP mode until the application restarts it
+static HAL_StatusTypeDef checkClock(void) {
+	if (LL_RCC_GetADCClockSource(LL_RCC_ADC_CLKSOURCE) == LL_RCC_ADC_CLKSOURCE_PLLSAI1 && !LL_RCC_PLLSAI1_IsReady()) return HAL_ERROR;
+
+	return HAL_OK;
+}
+
+// Reprograms the oversampler only when it changes (ADC stopped), log2Ratio 0 turns it off
+static HAL_StatusTypeDef configureOversampling(SEN0308_t *dev, uint8_t log2Ratio) {
+	ADC_InitTypeDef *init = &dev->hadc->Init;
+	uint8_t shift = (log2Ratio > SEN0308_OVS_BITS - 12) ? log2Ratio - (SEN0308_OVS_BITS - 12) : 0;
+
+	if (log2Ratio == 0) {
+		if (init->OversamplingMode == DISABLE) return HAL_OK;
+		init->OversamplingMode = DISABLE;
+	}
+	else {
+		if (init->OversamplingMode == ENABLE && init->Oversampling.Ratio == ovsRatio[log2Ratio] &&
+			init->Oversampling.RightBitShift == ovsShift[shift]) return HAL_OK;
+
+		init->OversamplingMode = ENABLE;
+		init->Oversampling.Ratio = ovsRatio[log2Ratio];
+		init->Oversampling.RightBitShift = ovsShift[shift];
+		init->Oversampling.TriggeredMode = ADC_TRIGGEREDMODE_SINGLE_TRIGGER;
+		init->Oversampling.OversamplingStopReset = ADC_REGOVERSAMPLING_CONTINUED_MODE;
+	}
+
+	return HAL_ADC_Init(dev->hadc);
+}
+
 HAL_StatusTypeDef SEN0308_ReadRaw(SEN0308_t *dev, uint16_t *rawMoisture) {
 	HAL_StatusTypeDef status;
 
+	status = checkClock();
+	if (status != HAL_OK) return status;
+
+	status = configureOversampling(dev, 0);
+	if (status != HAL_OK) return status;
+
 	status = HAL_ADC_Start(dev->hadc);
 	if (status != HAL_OK) {
 		HAL_ADC_Stop(dev->hadc);
@@ -60,6 +108,52 @@ HAL_StatusTypeDef SEN0308_ReadRawAvg(SEN0308_t *dev, uint16_t *rawMoisture, uint
 	return HAL_OK;
 }
 
+// One trigger runs the whole burst in the ADC, the DMA moves the single result; 256x takes ~240 us at the 64 MHz PLLSAI1 clock
+HAL_StatusTypeDef SEN0308_ReadOversampled(SEN0308_t *dev, uint16_t *rawMoisture, uint16_t ratio) {
+	HAL_StatusTypeDef status;
+	uint8_t log2Ratio = 0;
+
+	while ((1U << log2Ratio) < ratio) log2Ratio++;
+	if (ratio < 2 || ratio > 256 || (1U << log2Ratio) != ratio) return HAL_ERROR;
+	if (dev->hadc->DMA_Handle == NULL) return HAL_ERROR;
+
+	status = checkClock();
+	if (status != HAL_OK) return status;
+
+	status = configureOversampling(dev, log2Ratio);
+	if (status != HAL_OK) return status;
+
+	dev->dmaStatus = HAL_OK;
+	dev->dmaBusy = 1;
+	status = HAL_ADC_Start_DMA(dev->hadc, (uint32_t*)&dmaResult, 1);
+	if (status != HAL_OK) {
+		dev->dmaBusy = 0;
+		HAL_ADC_Stop_DMA(dev->hadc);
+		return status;
+	}
+
+	// Core asleep until the DMA interrupt
+	uint32_t start = HAL_GetTick();
+	while (dev->dmaBusy) {
+		if ((HAL_GetTick() - start) > SEN0308_POLL_TIMEOUT_MS) {
+			dev->dmaBusy = 0;
+			dev->dmaStatus = HAL_TIMEOUT;
+			break;
+		}
+		HAL_PWR_EnterSLEEPMode(PWR_MAINREGULATOR_ON, PWR_SLEEPENTRY_WFI);
+	}
+
+	status = HAL_ADC_Stop_DMA(dev->hadc);
+	if (dev->dmaStatus != HAL_OK) return dev->dmaStatus;
+	if (status != HAL_OK) return status;
+
+	// Ratios below 16 leave fewer bits than SEN0308_OVS_BITS
+	if (log2Ratio < SEN0308_OVS_BITS - 12) *rawMoisture = dmaResult << (SEN0308_OVS_BITS - 12 - log2Ratio);
+	else *rawMoisture = dmaResult;
+
+	return HAL_OK;
+}
+
 uint8_t SEN0308_CalculateRelative(SEN0308_t *dev, uint16_t rawMoisture) {
 	if (rawMoisture > dev->airRaw) rawMoisture = dev->airRaw;
 	if (rawMoisture < dev->waterRaw) rawMoisture = dev->waterRaw;
@@ -68,3 +162,8 @@ uint8_t SEN0308_CalculateRelative(SEN0308_t *dev, uint16_t rawMoisture) {
 	uint32_t den = (uint32_t)(dev->airRaw - dev->waterRaw);
 	return (uint8_t)((num + den / 2) / den);
 }
+
+void SEN0308_DMACallback(SEN0308_t *dev, HAL_StatusTypeDef status) {
+	dev->dmaStatus = status;
+	dev->dmaBusy = 0;
+}
@@ -12,6 +12,9 @@
 
 // Definitions
 #define SEN0308_POLL_TIMEOUT_MS	10 //
+#define SEN0308_POWERUP_MS		100 // Analog output settling time after power-up
+#define SEN0308_OVS_RATIO		256	// Default hardware oversampling ratio (power of two, 2 to 256)
+#define SEN0308_OVS_BITS		16	// Resolution of the oversampled result
 
 // Struct
 typedef struct {
@@ -19,12 +22,17 @@ typedef struct {
     GPIO_TypeDef *port;
     uint16_t pin;
     uint16_t airRaw, waterRaw;
+    volatile uint8_t dmaBusy;
+    HAL_StatusTypeDef dmaStatus;
 } SEN0308_t;
 
 HAL_StatusTypeDef SEN0308_Init(SEN0308_t *dev);
 
 HAL_StatusTypeDef SEN0308_ReadRaw(SEN0308_t *dev, uint16_t *rawMoisture);
 HAL_StatusTypeDef SEN0308_ReadRawAvg(SEN0308_t *dev, uint16_t *rawMoisture, uint8_t numSamples);
+HAL_StatusTypeDef SEN0308_ReadOversampled(SEN0308_t *dev, uint16_t *rawMoisture, uint16_t ratio);
 uint8_t SEN0308_CalculateRelative(SEN0308_t *dev, uint16_t rawMoisture);
 
+void SEN0308_DMACallback(SEN0308_t *dev, HAL_StatusTypeDef status);
+
 #endif /* SEN0308_H_ */
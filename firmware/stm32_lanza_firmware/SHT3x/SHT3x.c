@@ -63,21 +63,30 @@ HAL_StatusTypeDef SHT3X_Init(SHT3X_t *dev) {
 }
 
 HAL_StatusTypeDef SHT3X_SoftReset(SHT3X_t *dev) {
-	return sendCommand(dev, SHT3X_CMD_SOFT_RESET);
+	HAL_StatusTypeDef ret = sendCommand(dev, SHT3X_CMD_SOFT_RESET);
+	if (ret == HAL_OK) dev->heater = SHT3X_HEATER_OFF;
+
+	return ret;
 }
 
-HAL_StatusTypeDef SHT3X_ReadRaw(SHT3X_t *dev, uint16_t *rawT, uint16_t *rawRH) {
-    HAL_StatusTypeDef ret;
-    uint16_t cmd = singleShotCMD(dev);
+HAL_StatusTypeDef SHT3X_Configure(SHT3X_t *dev, SHT3X_Heater_t heater) {
+	// El estado tras el arranque ya es el pedido: sin tráfico I2C
+	if (dev->heater == heater) return HAL_OK;
+
+	return SHT3X_Heater(dev, heater);
+}
+
+void SHT3X_PowerLost(SHT3X_t *dev) {
+	dev->heater = SHT3X_HEATER_OFF;
+}
 
+HAL_StatusTypeDef SHT3X_StartSingleShot(SHT3X_t *dev) {
     // Lanzar medición
-    ret = sendCommand(dev, cmd);
-    if (ret != HAL_OK) return ret;
+    return sendCommand(dev, singleShotCMD(dev));
+}
 
-    // Si no usamos clock stretching, esperamos conversión
-    if (dev->clockStretch == SHT3X_NOSTRETCH) {
-        HAL_Delay(convTime_ms(dev));
-    }
+HAL_StatusTypeDef SHT3X_FetchRaw(SHT3X_t *dev, uint16_t *rawT, uint16_t *rawRH) {
+    HAL_StatusTypeDef ret;
 
     // Leer 6 bytes: T[2]+CRC, RH[2]+CRC
     uint8_t buf[6];
@@ -94,13 +103,21 @@ HAL_StatusTypeDef SHT3X_ReadRaw(SHT3X_t *dev, uint16_t *rawT, uint16_t *rawRH) {
     return HAL_OK;
 }
 
-HAL_StatusTypeDef SHT3X_ReadSingleShot(SHT3X_t *dev, float *temp_c, float *rh_perc) {
+HAL_StatusTypeDef SHT3X_ReadRaw(SHT3X_t *dev, uint16_t *rawT, uint16_t *rawRH) {
     HAL_StatusTypeDef ret;
-    uint16_t rawT, rawRH;
 
-    ret = SHT3X_ReadRaw(dev, &rawT, &rawRH);
+    ret = SHT3X_StartSingleShot(dev);
     if (ret != HAL_OK) return ret;
 
+    // Si no usamos clock stretching, esperamos conversión
+    if (dev->clockStretch == SHT3X_NOSTRETCH) {
+        HAL_Delay(convTime_ms(dev));
+    }
+
+    return SHT3X_FetchRaw(dev, rawT, rawRH);
+}
+
+static void convertRaw(uint16_t rawT, uint16_t rawRH, float *temp_c, float *rh_perc) {
     // Conversión
     *temp_c  = -45.0f + 175.0f * ((float)rawT  / 65535.0f);
     *rh_perc = 100.0f * ((float)rawRH / 65535.0f);
@@ -108,9 +125,34 @@ HAL_StatusTypeDef SHT3X_ReadSingleShot(SHT3X_t *dev, float *temp_c, float *rh_pe
     // Limitar RH a [0,100]
     if (*rh_perc < 0.0f)   *rh_perc = 0.0f;
     if (*rh_perc > 100.0f) *rh_perc = 100.0f;
+}
+
+HAL_StatusTypeDef SHT3X_ReadSingleShot(SHT3X_t *dev, float *temp_c, float *rh_perc) {
+    HAL_StatusTypeDef ret;
+    uint16_t rawT, rawRH;
+
+    ret = SHT3X_ReadRaw(dev, &rawT, &rawRH);
+    if (ret != HAL_OK) return ret;
+
+    convertRaw(rawT, rawRH, temp_c, rh_perc);
     return HAL_OK;
 }
 
+HAL_StatusTypeDef SHT3X_FetchSingleShot(SHT3X_t *dev, float *temp_c, float *rh_perc) {
+    HAL_StatusTypeDef ret;
+    uint16_t rawT, rawRH;
+
+    ret = SHT3X_FetchRaw(dev, &rawT, &rawRH);
+    if (ret != HAL_OK) return ret;
+
+    convertRaw(rawT, rawRH, temp_c, rh_perc);
+    return HAL_OK;
+}
+
+uint32_t SHT3X_ConversionTime_ms(SHT3X_t *dev) {
+    return convTime_ms(dev);
+}
+
 float SHT3X_CalculateDewpoint(float temp_c, float rh_perc) {
 	if (rh_perc < 1.0f) rh_perc = 1.0f; // Evita log(0)
 	if (rh_perc > 100.0f) rh_perc = 100.0f;
@@ -151,5 +193,8 @@ HAL_StatusTypeDef SHT3X_ClearStatus(SHT3X_t *dev) {
 }
 
 HAL_StatusTypeDef SHT3X_Heater(SHT3X_t *dev, SHT3X_Heater_t state) {
-    return sendCommand(dev, (state == SHT3X_HEATER_ON) ? SHT3X_CMD_HEATER_ENABLE : SHT3X_CMD_HEATER_DISABLE);
+    HAL_StatusTypeDef ret = sendCommand(dev, (state == SHT3X_HEATER_ON) ? SHT3X_CMD_HEATER_ENABLE : SHT3X_CMD_HEATER_DISABLE);
+    if (ret == HAL_OK) dev->heater = state;
+
+    return ret;
 }
@@ -31,6 +31,8 @@
 #define SHT3X_CMD_SS_CS_MED         0x2C0D // Single-shot with clock stretching, medium repeatability
 #define SHT3X_CMD_SS_CS_LOW         0x2C10 // Single-shot with clock stretching, low repeatability
 
+#define SHT3X_POWERUP_MS			2 // Power-up time (1.5 ms max)
+
 // Repeatability
 typedef enum {
     SHT3X_REPEAT_LOW, // Low
@@ -55,15 +57,22 @@ typedef struct {
     I2C_HandleTypeDef *hi2c;
     SHT3X_Repeatability_t repeatability;
 	SHT3X_ClockStretch_t clockStretch;
+	SHT3X_Heater_t heater; // Last heater state sent to the device
 } SHT3X_t;
 
 // Functions
 HAL_StatusTypeDef SHT3X_Init(SHT3X_t *dev);
 
 HAL_StatusTypeDef SHT3X_SoftReset(SHT3X_t *dev);
+HAL_StatusTypeDef SHT3X_Configure(SHT3X_t *dev, SHT3X_Heater_t heater);
+void SHT3X_PowerLost(SHT3X_t *dev);
 
 HAL_StatusTypeDef SHT3X_ReadRaw(SHT3X_t *dev, uint16_t *rawT, uint16_t *rawRH);
 HAL_StatusTypeDef SHT3X_ReadSingleShot(SHT3X_t *dev, float *temp_c, float *rh_perc);
+HAL_StatusTypeDef SHT3X_StartSingleShot(SHT3X_t *dev);
+HAL_StatusTypeDef SHT3X_FetchRaw(SHT3X_t *dev, uint16_t *rawT, uint16_t *rawRH);
+HAL_StatusTypeDef SHT3X_FetchSingleShot(SHT3X_t *dev, float *temp_c, float *rh_perc);
+uint32_t SHT3X_ConversionTime_ms(SHT3X_t *dev);
 float SHT3X_CalculateDewpoint(float temp_c, float rh_perc);
 
 HAL_StatusTypeDef SHT3X_ReadStatus(SHT3X_t *dev, uint16_t *status);
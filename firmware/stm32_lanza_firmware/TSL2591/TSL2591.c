@@ -39,19 +39,78 @@ HAL_StatusTypeDef TSL2591_Init(TSL2591_t *dev) {
     // Configurar ganancia e integración
     uint8_t ctrl = dev->integrationTime | dev->gain;
     ret = writeRegister(dev, TSL2591_CONTROL, ctrl);
+    if (ret == HAL_OK) dev->regControl = ctrl;
     HAL_Delay(100);
 
     return ret;
 }
 
+HAL_StatusTypeDef TSL2591_Configure(TSL2591_t *dev) {
+    HAL_StatusTypeDef ret;
+
+    // Solo se escriben los registros que difieren del dispositivo
+    uint8_t ctrl = dev->integrationTime | dev->gain;
+    if (dev->regControl != ctrl) {
+        ret = writeRegister(dev, TSL2591_CONTROL, ctrl);
+        if (ret != HAL_OK) return ret;
+        dev->regControl = ctrl;
+    }
+
+    uint8_t en = TSL2591_ENABLE_PON | TSL2591_ENABLE_AEN;
+    if (dev->regEnable != en) {
+        ret = writeRegister(dev, TSL2591_ENABLE, en);
+        if (ret != HAL_OK) return ret;
+        dev->regEnable = en;
+    }
+
+    return HAL_OK;
+}
+
+void TSL2591_PowerLost(TSL2591_t *dev) {
+    dev->regControl = TSL2591_CONTROL_DEFAULT;
+    dev->regEnable = TSL2591_ENABLE_DEFAULT;
+}
+
 void TSL2591_Enable(TSL2591_t *dev) {
     uint8_t val = TSL2591_ENABLE_PON | TSL2591_ENABLE_AEN;
-    writeRegister(dev, TSL2591_ENABLE, val);
+    if (writeRegister(dev, TSL2591_ENABLE, val) == HAL_OK) dev->regEnable = val;
 }
 
 void TSL2591_Disable(TSL2591_t *dev) {
     uint8_t val = 0x00;
-    writeRegister(dev, TSL2591_ENABLE, val);
+    if (writeRegister(dev, TSL2591_ENABLE, val) == HAL_OK) dev->regEnable = val;
+}
+
+HAL_StatusTypeDef TSL2591_StartIntegration(TSL2591_t *dev) {
+    HAL_StatusTypeDef ret;
+
+    // Reiniciar el ciclo ALS: AEN 1->0->1 descarta la integración en curso
+    ret = writeRegister(dev, TSL2591_ENABLE, TSL2591_ENABLE_PON);
+    if (ret != HAL_OK) return ret;
+
+    ret = writeRegister(dev, TSL2591_ENABLE, TSL2591_ENABLE_PON | TSL2591_ENABLE_AEN);
+    if (ret == HAL_OK) dev->regEnable = TSL2591_ENABLE_PON | TSL2591_ENABLE_AEN;
+
+    return ret;
+}
+
+HAL_StatusTypeDef TSL2591_IsDataValid(TSL2591_t *dev, uint8_t *valid) {
+    uint8_t status;
+    HAL_StatusTypeDef ret;
+
+    ret = readRegister(dev, TSL2591_STATUS, &status, 1);
+    if (ret != HAL_OK) return ret;
+
+    *valid = (status & TSL2591_STATUS_AVALID) ? 1 : 0;
+
+    return HAL_OK;
+}
+
+uint32_t TSL2591_IntegrationTime_ms(TSL2591_t *dev) {
+    // ATIME = 100 ms * (n + 1), +10% por tolerancia del oscilador interno
+    uint32_t atime_ms = 100 * ((uint32_t)dev->integrationTime + 1);
+
+    return atime_ms + atime_ms / 10;
 }
 
 HAL_StatusTypeDef TSL2591_ReadChannels(TSL2591_t *dev, uint16_t *ch0, uint16_t *ch1) {
@@ -18,12 +18,14 @@
 // Registers
 #define TSL2591_ENABLE        0x00 // Enable register
 #define TSL2591_CONTROL       0x01 // Control register
+#define TSL2591_STATUS        0x13 // Status register
 #define TSL2591_CHAN0_LOW     0x14 // Channel 0 data (full) register (LSB)
 #define TSL2591_CHAN1_LOW     0x16 // Channel 1 data (ir) register (LSB)
 
 // Control bits
 #define TSL2591_ENABLE_PON    0x01 // Flag to enable sensor
 #define TSL2591_ENABLE_AEN    0x02 // Flag to enable ALS
+#define TSL2591_STATUS_AVALID 0x01 // ALS integration cycle completed
 
 // Calibration
 #define TSL2591_LUX_DF        408.0f // Lux coefficient
@@ -32,6 +34,11 @@
 
 #define TSL2591_LUM_EFF       93.0f  // Luminous efficacy
 
+// Power
+#define TSL2591_POWERUP_MS    5      // Time before the first I2C access after power-up
+#define TSL2591_CONTROL_DEFAULT 0x00 // Control register reset value
+#define TSL2591_ENABLE_DEFAULT  0x00 // Enable register reset value
+
 // Gain
 typedef enum {
     TSL2591_GAIN_LOW  = 0x00, // 1x
@@ -55,14 +62,23 @@ typedef struct {
     I2C_HandleTypeDef *hi2c;
     TSL2591_Gain_t gain;
     TSL2591_IntegrationTime_t integrationTime;
+    uint8_t regControl; // Last value written to the control register
+    uint8_t regEnable;  // Last value written to the enable register
 } TSL2591_t;
 
 // Functions
 HAL_StatusTypeDef TSL2591_Init(TSL2591_t *dev);
 
+HAL_StatusTypeDef TSL2591_Configure(TSL2591_t *dev);
+void TSL2591_PowerLost(TSL2591_t *dev);
+
 void TSL2591_Enable(TSL2591_t *dev);
 void TSL2591_Disable(TSL2591_t *dev);
 
+HAL_StatusTypeDef TSL2591_StartIntegration(TSL2591_t *dev);
+HAL_StatusTypeDef TSL2591_IsDataValid(TSL2591_t *dev, uint8_t *valid);
+uint32_t TSL2591_IntegrationTime_ms(TSL2591_t *dev);
+
 HAL_StatusTypeDef TSL2591_ReadChannels(TSL2591_t *dev, uint16_t *ch0, uint16_t *ch1);
 float TSL2591_CalculateLux(TSL2591_t *dev, uint16_t full, uint16_t ir);
 float TSL2591_CalculateIrradiance(float lux);
@@ -0,0 +1,211 @@
+/*
+ * energy_replay.c
+ *
+ * Reproduce un ensayo de cosecha (harvest_05_11_25.csv) con el registro de
+ * energía del firmware (energy.c) y lo compara con la integración del propio
+ * registro a su frecuencia completa (2 Hz). El firmware solo ve una lectura
+ * del INA3221 por ciclo: se toma la fila del registro en cada ciclo de -period
+ * s y se pasa a ENERGY_Update igual que UpdateEnergy() en app.c. La referencia
+ * se integra sobre el mismo intervalo que cubre el registro de energía (de la
+ * primera a la última lectura), así que la diferencia es solo la del muestreo.
+ *
+ * El nodo del ensayo no dormía: por defecto la corriente de reposo es la media
+ * de la carga del registro (-sleep para fijarla). Con -reset s se simula un
+ * reinicio en el segundo s del registro: los totales se guardan truncados a
+ * uint32 como en FRAM_KEY_ENERGY/FRAM_KEY_CHARGE y se restauran con
+ * ENERGY_Restore; la primera lectura tras el reinicio solo prepara el registro
+ * y el ciclo perdido aparece en la diferencia.
+ *
+ * Uso:
+ *   gcc -O2 -I../../firmware/stm32_lanza_firmware/Core/Inc energy_replay.c \
+ *       ../../firmware/stm32_lanza_firmware/Core/Src/energy.c -o energy_replay
+ *   ./energy_replay harvest_05_11_25.csv [-period s] [-awake ms] [-sleep mA] [-reset s] [-csv]
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "energy.h"
+
+#define MAX_ROWS		65536
+#define FIRMWARE_DAY_S	86400.0
+#define T0				1762300800u		// 5/11/2025 00:00:00, epoch del ensayo
+
+typedef struct {
+	double t;
+	EnergyReading_t reading;
+} Row_t;
+
+static Row_t rows[MAX_ROWS];
+static int nRows;
+
+// timestamp,status_0..2,voltage_PV,current_PV,power_PV,voltage_BAT,current_BAT,power_BAT,voltage_LOAD,current_LOAD,power_LOAD,...
+static int loadCsv(const char *path) {
+	FILE *f = fopen(path, "r");
+	char line[512];
+	double offset = 0.0, last = -1.0;
+
+	if (!f) return -1;
+
+	while (fgets(line, sizeof(line), f) && nRows < MAX_ROWS) {
+		unsigned h, m, s, s0, s1, s2;
+		double vpv, ipv, ppv, vbat, ibat, pbat, vl, il, pl;
+
+		if (sscanf(line, "%u:%u:%u,%u,%u,%u,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &h, &m, &s, &s0, &s1, &s2,
+				   &vpv, &ipv, &ppv, &vbat, &ibat, &pbat, &vl, &il, &pl) != 15) continue;
+
+		// El reloj del ensayo empieza en 00:00:00; pasar de medianoche suma un día
+		double t = h * 3600.0 + m * 60.0 + s + offset;
+		if (t < last) {
+			offset += FIRMWARE_DAY_S;
+			t += FIRMWARE_DAY_S;
+		}
+		last = t;
+
+		Row_t *row = &rows[nRows++];
+		row->t = t;
+		row->reading.bus_V[ENERGY_CH_PV] = (float)vpv;
+		row->reading.bus_V[ENERGY_CH_BAT] = (float)vbat;
+		row->reading.bus_V[ENERGY_CH_LOAD] = (float)vl;
+		row->reading.current_mA[ENERGY_CH_PV] = (float)ipv;
+		row->reading.current_mA[ENERGY_CH_BAT] = (float)ibat;
+		row->reading.current_mA[ENERGY_CH_LOAD] = (float)il;
+	}
+
+	fclose(f);
+	return nRows;
+}
+
+// Integración del registro completo entre t0 y t1 (rectángulos, fila a fila), mismas unidades que el ledger
+static void reference(double t0, double t1, double uAh[ENERGY_FLOWS], double uWh[ENERGY_FLOWS]) {
+	memset(uAh, 0, ENERGY_FLOWS * sizeof(double));
+	memset(uWh, 0, ENERGY_FLOWS * sizeof(double));
+
+	for (int i = 1; i < nRows; ++i) {
+		if (rows[i - 1].t < t0 || rows[i].t > t1) continue;
+
+		const EnergyReading_t *r = &rows[i].reading;
+		double dt_h = (rows[i].t - rows[i - 1].t) / 3600.0;
+		double pv_mA = r->current_mA[ENERGY_CH_PV] > 0.0f ? r->current_mA[ENERGY_CH_PV] : 0.0;
+		double bat_mA = r->current_mA[ENERGY_CH_BAT];
+		double load_mA = r->current_mA[ENERGY_CH_LOAD];
+
+		uAh[ENERGY_PV] += pv_mA * dt_h * 1000.0;
+		uWh[ENERGY_PV] += pv_mA * r->bus_V[ENERGY_CH_PV] * dt_h * 1000.0;
+		uAh[ENERGY_LOAD] += load_mA * dt_h * 1000.0;
+		uWh[ENERGY_LOAD] += load_mA * r->bus_V[ENERGY_CH_LOAD] * dt_h * 1000.0;
+
+		EnergyFlow_t flow = (bat_mA >= 0.0) ? ENERGY_BAT_OUT : ENERGY_BAT_IN;
+		if (bat_mA < 0.0) bat_mA = -bat_mA;
+		uAh[flow] += bat_mA * dt_h * 1000.0;
+		uWh[flow] += bat_mA * r->bus_V[ENERGY_CH_BAT] * dt_h * 1000.0;
+	}
+}
+
+static double meanLoad_mA(void) {
+	double sum = 0.0;
+
+	for (int i = 0; i < nRows; ++i) sum += rows[i].reading.current_mA[ENERGY_CH_LOAD];
+	return nRows ? sum / nRows : 0.0;
+}
+
+int main(int argc, char **argv) {
+	static const char *names[ENERGY_FLOWS] = { "PV", "Batería entrada", "Batería salida", "Carga" };
+	EnergyConfig_t cfg = ENERGY_DefaultConfig;
+	double period_s = 1200.0, reset_s = -1.0, sleep_mA = -1.0;
+	uint32_t awake_ms = 500;
+	int csv = 0;
+
+	if (argc < 2) {
+		fprintf(stderr, "uso: %s harvest.csv [-period s] [-awake ms] [-sleep mA] [-reset s] [-csv]\n", argv[0]);
+		return 1;
+	}
+
+	for (int i = 2; i < argc; ++i) {
+		if (strcmp(argv[i], "-csv") == 0) csv = 1;
+		else if (i + 1 < argc && strcmp(argv[i], "-period") == 0) period_s = atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-awake") == 0) awake_ms = (uint32_t)atol(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-sleep") == 0) sleep_mA = atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-reset") == 0) reset_s = atof(argv[++i]);
+		else {
+			fprintf(stderr, "opción desconocida: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (period_s <= 0.0) {
+		fprintf(stderr, "-period debe ser positivo\n");
+		return 1;
+	}
+
+	if (loadCsv(argv[1]) < 2) {
+		fprintf(stderr, "%s: se necesitan al menos dos filas\n", argv[1]);
+		return 1;
+	}
+
+	cfg.sleep_mA = (float)(sleep_mA >= 0.0 ? sleep_mA : meanLoad_mA());
+
+	EnergyLedger_t ledger;
+	ENERGY_Init(&ledger, &cfg);
+
+	// Lecturas del firmware: la fila del registro al empezar cada ciclo
+	double first = rows[0].t, last = first, next = first;
+	int cycles = 0, resets = 0;
+	float soc0 = 0.0f;
+
+	if (csv) printf("Tiempo (s),PV (mWh),Bateria entrada (mWh),Bateria salida (mWh),Carga (mWh),SoC (%%)\n");
+
+	for (int i = 0; i < nRows; ++i) {
+		if (rows[i].t < next) continue;
+
+		// Reinicio: totales guardados en la FRAM y restaurados al arrancar
+		if (reset_s >= 0.0 && !resets && rows[i].t >= first + reset_s) {
+			uint32_t uAh[ENERGY_FLOWS], uWh[ENERGY_FLOWS];
+			for (int f = 0; f < ENERGY_FLOWS; ++f) {
+				uAh[f] = (uint32_t)ledger.uAh[f];
+				uWh[f] = (uint32_t)ledger.uWh[f];
+			}
+			uint32_t soc_uAh = (uint32_t)ledger.soc_uAh;
+
+			ENERGY_Init(&ledger, &cfg);
+			ENERGY_Restore(&ledger, uAh, uWh, soc_uAh);
+			resets++;
+		}
+
+		ENERGY_Update(&ledger, T0 + (uint32_t)rows[i].t, &rows[i].reading, awake_ms);
+		if (cycles++ == 0) soc0 = ENERGY_SoC(&ledger);
+
+		last = rows[i].t;
+		next += period_s;
+
+		if (csv) printf("%.0f,%.3f,%.3f,%.3f,%.3f,%.1f\n", rows[i].t, ledger.uWh[ENERGY_PV] / 1000.0, ledger.uWh[ENERGY_BAT_IN] / 1000.0,
+						ledger.uWh[ENERGY_BAT_OUT] / 1000.0, ledger.uWh[ENERGY_LOAD] / 1000.0, ENERGY_SoC(&ledger));
+	}
+
+	double ref_uAh[ENERGY_FLOWS], ref_uWh[ENERGY_FLOWS];
+	reference(first, last, ref_uAh, ref_uWh);
+
+	FILE *out = csv ? stderr : stdout;
+	fprintf(out, "Registro: %d filas, %.1f h; %d ciclos de %.0f s (%.2f h integradas), despierto %lu ms, reposo %.2f mA%s\n",
+			nRows, (rows[nRows - 1].t - rows[0].t) / 3600.0, cycles, period_s, (last - first) / 3600.0,
+			(unsigned long)awake_ms, cfg.sleep_mA, resets ? ", un reinicio" : "");
+
+	for (int f = 0; f < ENERGY_FLOWS; ++f) {
+		fprintf(out, "%-16s registro %8.2f mWh %8.2f mAh, ledger %8.2f mWh %8.2f mAh (%+.1f %%)\n", names[f],
+				ref_uWh[f] / 1000.0, ref_uAh[f] / 1000.0, ledger.uWh[f] / 1000.0, ledger.uAh[f] / 1000.0,
+				ref_uWh[f] > 0.0 ? (ledger.uWh[f] / ref_uWh[f] - 1.0) * 100.0 : 0.0);
+	}
+
+	// Carga neta que ve el contador de culombios; el estado de carga se fija en los extremos de tensión
+	double ref_net_mAh = (ref_uAh[ENERGY_BAT_IN] * cfg.charge_eff - ref_uAh[ENERGY_BAT_OUT]) / 1000.0;
+	double net_mAh = (ledger.uAh[ENERGY_BAT_IN] * cfg.charge_eff - ledger.uAh[ENERGY_BAT_OUT]) / 1000.0;
+	fprintf(out, "Carga neta de la batería: registro %+.2f mAh, ledger %+.2f mAh; estado de carga %.1f %% -> %.1f %% "
+			"(0 %% por debajo de %u mV, 100 %% desde %u mV)\n", ref_net_mAh, net_mAh, soc0, ENERGY_SoC(&ledger),
+			cfg.empty_mV, cfg.full_mV);
+
+	return 0;
+}
@@ -0,0 +1,331 @@
+/*
+ * sched_replay.c
+ *
+ * Reproduce un ensayo de cosecha (harvest_05_11_25.csv) con el planificador de
+ * tareas diferibles del firmware (sched.c) y lo compara con ejecutar cada
+ * tarea en cuanto se pide. El registro dura unas 6 h, así que se toma como un
+ * "día" comprimido que se repite: las primeras pasadas enseñan el perfil de
+ * irradiancia y solo se mide la última. Plazos y ciclo del firmware se escalan
+ * con la misma compresión.
+ *
+ * Bucle abierto: la tensión de batería es la del registro, y las tareas la
+ * bajan con un modelo sencillo calibrado con el propio registro:
+ *
+ *   V = V registro - k * energía de tareas sacada de la batería - R * corriente de la tarea
+ *
+ * k (mV/mWh) sale de la caída de tensión frente a la energía que entregó la
+ * batería durante el ensayo. Una tarea se paga primero con el excedente de la
+ * cosecha (potencia PV por encima del consumo medio del nodo) y el resto con
+ * la batería. Las tareas son las de app.c con sus energías estimadas; el
+ * volcado y el scrub se piden al empezar cada día y la captura del INA3221
+ * cada -every s de registro (alertas simuladas).
+ *
+ * Una petición de una tarea que ya está pendiente se agrupa con ella (como
+ * SCHED_Request en el firmware), así que la política planificada ejecuta menos
+ * tareas que la inmediata. Para no mezclar esa agrupación con la planificación
+ * se informa de las peticiones agrupadas y descartadas, y se compara la energía
+ * de batería por ejecución de cada tarea además del total.
+ *
+ * Uso:
+ *   gcc -O2 -I../../firmware/stm32_lanza_firmware/Core/Inc sched_replay.c \
+ *       ../../firmware/stm32_lanza_firmware/Core/Src/sched.c -o sched_replay
+ *   ./sched_replay harvest_05_11_25.csv [-days n] [-every s] [-load mW] [-floor mV] [-comfort mV] [-csv]
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sched.h"
+
+#define MAX_ROWS		65536
+#define R_INT_OHM		0.15		// Resistencia interna de la celda
+#define FIRMWARE_DAY_S	86400.0
+#define FIRMWARE_TICK_S	1200.0		// Ciclo de 20 min del firmware
+#define N_JOBS			3
+
+typedef struct {
+	double t;
+	double pv_mW;
+	double battery_mV;
+	double battery_mW;		// Potencia entregada por la batería (positiva descargando)
+	double irradiance_Wm2;
+} Row_t;
+
+// Mismas tareas que app.c: energía (mJ), duración (s) y plazo en el firmware (s)
+typedef struct {
+	const char *name;
+	uint32_t cost_mJ;
+	double duration_s;
+	double delay_s;
+} Job_t;
+
+static const Job_t jobs[N_JOBS] = {
+	{ "dump", 400, 10.0, 12 * 3600.0 },
+	{ "scrub", 60, 2.0, 24 * 3600.0 },
+	{ "ina_capture", 30, 1.0, 3600.0 }
+};
+
+typedef struct {
+	int requested, run;
+	int coalesced;				// Peticiones con la tarea ya pendiente
+	int dropped;				// Pendientes al acabar el día
+	double dropped_t[N_JOBS];	// Petición descartada de cada tarea (< 0: ninguna)
+	int runs[N_JOBS];
+	double battery_mWh[N_JOBS];	// Energía de batería por tarea
+	double delay_s;				// Suma de esperas (s de registro)
+	double from_battery_mWh;	// Energía de tareas sacada de la batería
+	double from_harvest_mWh;	// Energía de tareas cubierta por el excedente
+	double run_min_mV;			// Tensión mínima de batería al ejecutar una tarea
+	double floor_mV;			// Suelo de batería con el modelo de caída
+} Result_t;
+
+static Row_t rows[MAX_ROWS];
+static int nRows;
+static double k_mV_per_mWh;
+
+// timestamp,status_0..2,voltage_PV,current_PV,power_PV,voltage_BAT,current_BAT,power_BAT,...,irradiance
+static int loadCsv(const char *path) {
+	FILE *f = fopen(path, "r");
+	char line[512];
+	double offset = 0.0, last = -1.0;
+
+	if (!f) return -1;
+
+	while (fgets(line, sizeof(line), f) && nRows < MAX_ROWS) {
+		unsigned h, m, s, s0, s1, s2;
+		double vpv, ipv, ppv, vbat, ibat, pbat, vl, il, pl, total, ir, lux, irr;
+
+		if (sscanf(line, "%u:%u:%u,%u,%u,%u,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &h, &m, &s, &s0, &s1, &s2,
+				   &vpv, &ipv, &ppv, &vbat, &ibat, &pbat, &vl, &il, &pl, &total, &ir, &lux, &irr) != 19) continue;
+
+		// El reloj del ensayo empieza en 00:00:00; pasar de medianoche suma un día
+		double t = h * 3600.0 + m * 60.0 + s + offset;
+		if (t < last) {
+			offset += FIRMWARE_DAY_S;
+			t += FIRMWARE_DAY_S;
+		}
+		last = t;
+
+		rows[nRows].t = t;
+		rows[nRows].pv_mW = ppv;
+		rows[nRows].battery_mV = vbat * 1000.0;
+		rows[nRows].battery_mW = pbat;
+		rows[nRows].irradiance_Wm2 = irr;
+		nRows++;
+	}
+
+	fclose(f);
+	return nRows;
+}
+
+// Caída de tensión del ensayo frente a la energía entregada por la batería (medias de 1 min en los extremos)
+static void calibrate(void) {
+	double energy_mWh = 0.0, v0 = 0.0, v1 = 0.0;
+	int n = nRows < 120 ? nRows / 2 : 120;
+
+	for (int i = 1; i < nRows; ++i) energy_mWh += rows[i].battery_mW * (rows[i].t - rows[i - 1].t) / 3600.0;
+	for (int i = 0; i < n; ++i) {
+		v0 += rows[i].battery_mV / n;
+		v1 += rows[nRows - 1 - i].battery_mV / n;
+	}
+
+	k_mV_per_mWh = (energy_mWh > 0.0 && v0 > v1) ? (v0 - v1) / energy_mWh : 0.0;
+}
+
+static const Row_t *rowAt(double t) {
+	int lo = 0, hi = nRows - 1;
+
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		if (rows[mid].t <= t) lo = mid;
+		else hi = mid - 1;
+	}
+
+	return &rows[lo];
+}
+
+static void runJob(int j, const Row_t *row, double load_mW, Result_t *r, double *jobs_mWh, int measure) {
+	const Job_t *job = &jobs[j];
+	double job_mW = job->cost_mJ / job->duration_s;
+	double spare_mW = row->pv_mW - load_mW;
+	if (spare_mW < 0.0) spare_mW = 0.0;
+
+	double battery_mW = job_mW > spare_mW ? job_mW - spare_mW : 0.0;
+	double battery_mWh = battery_mW * job->duration_s / 3600.0;
+
+	*jobs_mWh += battery_mWh;
+	if (!measure) return;
+
+	double v = row->battery_mV - k_mV_per_mWh * *jobs_mWh - R_INT_OHM * battery_mW / (row->battery_mV / 1000.0);
+
+	r->run++;
+	r->runs[j]++;
+	r->battery_mWh[j] += battery_mWh;
+	r->from_battery_mWh += battery_mWh;
+	r->from_harvest_mWh += (job_mW - battery_mW) * job->duration_s / 3600.0;
+	if (row->battery_mV < r->run_min_mV) r->run_min_mV = row->battery_mV;
+	if (v < r->floor_mV) r->floor_mV = v;
+}
+
+static void runPolicy(int scheduled, int days, double every_s, const SchedConfig_t *cfg, int csv, Result_t *r) {
+	double span_s = rows[nRows - 1].t - rows[0].t;
+	double scale = cfg->day_s / FIRMWARE_DAY_S;
+	double tick_s = FIRMWARE_TICK_S * scale;
+	Scheduler_t sched;
+	double requested[N_JOBS];
+	int pending[N_JOBS];
+
+	SCHED_Init(&sched, cfg);
+	for (int j = 0; j < N_JOBS; ++j) SCHED_AddJob(&sched, jobs[j].cost_mJ, (uint32_t)(jobs[j].delay_s * scale));
+
+	memset(r, 0, sizeof(*r));
+	r->run_min_mV = r->floor_mV = 1e9;
+	for (int j = 0; j < N_JOBS; ++j) r->dropped_t[j] = -1.0;
+
+	for (int day = 0; day < days; ++day) {
+		int measure = (day == days - 1);
+		double jobs_mWh = 0.0, nextCapture = every_s;
+
+		memset(pending, 0, sizeof(pending));
+
+		for (double t = 0.0; t <= span_s; t += tick_s) {
+			const Row_t *row = rowAt(rows[0].t + t);
+			uint32_t now = (uint32_t)(day * cfg->day_s + t);
+			uint32_t due = 0;
+
+			double v = row->battery_mV - k_mV_per_mWh * jobs_mWh;
+			if (measure && v < r->floor_mV) r->floor_mV = v;
+
+			// Peticiones: mantenimiento diario al empezar el día y capturas periódicas
+			for (int j = 0; j < N_JOBS; ++j) {
+				int request = (j == 2) ? (t >= nextCapture) : (t == 0.0);
+				if (!request) continue;
+
+				if (measure) {
+					r->requested++;
+					if (pending[j]) r->coalesced++;
+				}
+				if (!pending[j]) requested[j] = t;
+				pending[j] = 1;
+				SCHED_Request(&sched, (uint8_t)j, now);
+			}
+			if (t >= nextCapture) nextCapture += every_s;
+
+			SCHED_AddSample(&sched, now, (float)row->irradiance_Wm2);
+
+			if (scheduled) due = SCHED_Due(&sched, now, (float)row->irradiance_Wm2, (uint16_t)(v + 0.5));
+			else {
+				for (int j = 0; j < N_JOBS; ++j) if (pending[j]) due |= 1UL << j;
+				for (int j = 0; j < N_JOBS; ++j) sched.job[j].pending = 0;
+			}
+
+			for (int j = 0; j < N_JOBS; ++j) {
+				if (!(due & (1UL << j))) continue;
+
+				runJob(j, row, cfg->load_mW, r, &jobs_mWh, measure);
+				pending[j] = 0;
+
+				if (measure) {
+					r->delay_s += t - requested[j];
+					if (csv) printf("%s,%d,%.0f,%.0f,%.3f,%.2f\n", scheduled ? "planificada" : "inmediata", j, requested[j], t,
+									row->battery_mV / 1000.0, row->irradiance_Wm2);
+				}
+			}
+		}
+
+		// Lo que no llegó a ejecutarse antes del fin del día se descarta en las dos políticas
+		for (int j = 0; j < N_JOBS; ++j) {
+			if (measure && pending[j]) {
+				r->dropped++;
+				r->dropped_t[j] = requested[j];
+			}
+			sched.job[j].pending = 0;
+		}
+	}
+}
+
+static void report(FILE *out, const char *name, const Result_t *r) {
+	fprintf(out, "%-12s %3d peticiones (%d agrupadas), %3d ejecutadas, %d descartadas, espera media %5.0f s, "
+			"batería %.3f mWh + excedente %.3f mWh, tensión mínima al ejecutar %.3f V, suelo %.4f V\n",
+			name, r->requested, r->coalesced, r->run, r->dropped, r->run ? r->delay_s / r->run : 0.0,
+			r->from_battery_mWh, r->from_harvest_mWh, r->run ? r->run_min_mV / 1000.0 : 0.0, r->floor_mV / 1000.0);
+
+	for (int j = 0; j < N_JOBS; ++j) {
+		if (r->dropped_t[j] >= 0.0) fprintf(out, "%-12s descartada %s pedida en t = %.0f s\n", "", jobs[j].name, r->dropped_t[j]);
+	}
+}
+
+static double perRun_uWh(const Result_t *r, int j) {
+	return r->runs[j] ? r->battery_mWh[j] * 1000.0 / r->runs[j] : 0.0;
+}
+
+int main(int argc, char **argv) {
+	SchedConfig_t cfg = SCHED_DefaultConfig;
+	int days = 3, csv = 0;
+	double every_s = 600;
+
+	if (argc < 2) {
+		fprintf(stderr, "uso: %s harvest.csv [-days n] [-every s] [-load mW] [-floor mV] [-comfort mV] [-csv]\n", argv[0]);
+		return 1;
+	}
+
+	for (int i = 2; i < argc; ++i) {
+		if (strcmp(argv[i], "-csv") == 0) csv = 1;
+		else if (i + 1 < argc && strcmp(argv[i], "-days") == 0) days = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-every") == 0) every_s = atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-load") == 0) cfg.load_mW = (float)atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-floor") == 0) cfg.floor_mV = (uint16_t)atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-comfort") == 0) cfg.comfort_mV = (uint16_t)atoi(argv[++i]);
+		else {
+			fprintf(stderr, "opción desconocida: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (days < 1 || every_s <= 0.0) {
+		fprintf(stderr, "-days y -every deben ser positivos\n");
+		return 1;
+	}
+
+	if (loadCsv(argv[1]) < 2) {
+		fprintf(stderr, "%s: se necesitan al menos dos filas\n", argv[1]);
+		return 1;
+	}
+
+	// Un día comprimido cubre el ensayo entero, redondeado a bins enteros
+	double span_s = rows[nRows - 1].t - rows[0].t;
+	cfg.day_s = ((uint32_t)span_s / SCHED_BINS + 1) * SCHED_BINS;
+
+	calibrate();
+
+	Result_t now, planned;
+	if (csv) printf("Politica,Tarea,Pedida (s),Ejecutada (s),Bateria (V),Irradiancia (W/m2)\n");
+	runPolicy(0, days, every_s, &cfg, csv, &now);
+	runPolicy(1, days, every_s, &cfg, csv, &planned);
+
+	FILE *out = csv ? stderr : stdout;
+	fprintf(out, "Registro: %d filas, %.1f h, %.3f -> %.3f V, k = %.2f mV/mWh\n", nRows, span_s / 3600.0,
+			rows[0].battery_mV / 1000.0, rows[nRows - 1].battery_mV / 1000.0, k_mV_per_mWh);
+	fprintf(out, "Día comprimido de %lu s (x%.3f), %d pasadas, captura cada %.0f s\n", (unsigned long)cfg.day_s,
+			cfg.day_s / FIRMWARE_DAY_S, days, every_s);
+	report(out, "Inmediata", &now);
+	report(out, "Planificada", &planned);
+	fprintf(out, "Suelo de batería: %+.1f mV, energía de batería en tareas: %+.0f %% (%d frente a %d ejecuciones)\n",
+			planned.floor_mV - now.floor_mV,
+			now.from_battery_mWh > 0.0 ? (planned.from_battery_mWh / now.from_battery_mWh - 1.0) * 100.0 : 0.0,
+			planned.run, now.run);
+
+	// Por ejecución de cada tarea: solo el efecto de elegir el momento, sin la agrupación
+	fprintf(out, "Batería por ejecución (uWh):");
+	for (int j = 0; j < N_JOBS; ++j) {
+		fprintf(out, " %s %.2f -> %.2f (%+.0f %%)%s", jobs[j].name, perRun_uWh(&now, j), perRun_uWh(&planned, j),
+				perRun_uWh(&now, j) > 0.0 ? (perRun_uWh(&planned, j) / perRun_uWh(&now, j) - 1.0) * 100.0 : 0.0,
+				(j + 1 < N_JOBS) ? "," : "\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * block_bench.c
+ *
+ * Benchmark en host del formato de bloques comprimidos de la FRAM (fram_block.c)
+ * con los CSV de logs/. Informa del tamaño en v1 (32 B), v2 (16 B) y bloques,
+ * muestras que caben en la FRAM y coste de codificación/decodificación.
+ *
+ * Los canales se identifican por el nombre de la cabecera; los que faltan se
+ * guardan con su valor no válido, igual que en el firmware. Sin Fecha/Hora se
+ * genera una marca de tiempo cada 1200 s (periodo de muestreo del equipo).
+ *
+ * Uso:
+ *   gcc -O2 -I../../../firmware/stm32_lanza_firmware/FRAM block_bench.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_block.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_crc.c -lm -o block_bench
+ *   ./block_bench ../Sistema/sensores.csv ../Sistema/hum_temp_terreno.csv \
+ *       "../../Harvest Testing/harvest_05_11_25.csv"
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fram_block.h"
+
+#define FRAM_SIZE			32768
+#define DATA_START			0x0020
+#define SLOTS_V1			(FRAM_SIZE / 32 - 1)
+#define SLOTS_V2			((FRAM_SIZE - DATA_START) / 16)
+#define SLOTS_BLOCK			((FRAM_SIZE - DATA_START - 2 * FRAM_BLOCK_SIZE) / FRAM_BLOCK_SIZE)
+
+#define DEFAULT_PERIOD_S	1200
+#define ROUNDS				20
+#define MAX_COLS			32
+#define LINE_LEN			1024
+
+#define TEMP_INVALID		INT16_MIN
+#define U16_INVALID			0xFFFF
+#define U8_INVALID			0xFF
+
+enum { COL_DATE, COL_TIME, COL_BATT, COL_IRR, COL_AIR_T, COL_AIR_H, COL_SOIL_T, COL_SOIL_H, COL_COUNT };
+
+static double nowSeconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Igual que dateToEpoch() en fram.c
+static uint32_t civilToEpoch(int y, int m, int d, int hh, int mm, int ss) {
+	y -= (m <= 2);
+	int era = y / 400;
+	int yoe = y - era * 400;
+	int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	int days = era * 146097 + doe - 719468;
+
+	return (uint32_t)days * 86400u + hh * 3600u + mm * 60u + ss;
+}
+
+static int16_t toTemp(double x) {
+	long v = lround(x * 100.0);
+	if (v <= INT16_MIN) v = INT16_MIN + 1;
+	if (v > INT16_MAX) v = INT16_MAX;
+	return (int16_t)v;
+}
+
+static uint16_t toU16(double x, double k) {
+	long v = lround(x * k);
+	if (v < 0) v = 0;
+	if (v >= U16_INVALID) v = U16_INVALID - 1;
+	return (uint16_t)v;
+}
+
+static uint8_t toU8(double x) {
+	long v = lround(x);
+	if (v < 0) v = 0;
+	if (v >= U8_INVALID) v = U8_INVALID - 1;
+	return (uint8_t)v;
+}
+
+static int splitFields(char *line, char *fields[MAX_COLS]) {
+	int n = 0;
+	char *p = line;
+
+	line[strcspn(line, ";\r\n")] = '\0';
+	while (n < MAX_COLS) {
+		fields[n++] = p;
+		p = strchr(p, ',');
+		if (!p) break;
+		*p++ = '\0';
+	}
+	return n;
+}
+
+static void mapColumns(char *fields[], int n, int col[COL_COUNT]) {
+	for (int c = 0; c < COL_COUNT; ++c) col[c] = -1;
+
+	for (int i = 0; i < n; ++i) {
+		const char *h = fields[i];
+		if (strstr(h, "Fecha")) col[COL_DATE] = i;
+		else if (strstr(h, "Hora") || strcmp(h, "timestamp") == 0) col[COL_TIME] = i;
+		else if (strstr(h, "Bateria") || strstr(h, "voltage_BAT")) col[COL_BATT] = i;
+		else if (strstr(h, "Irradiancia") || strcmp(h, "irradiance") == 0) col[COL_IRR] = i;
+		else if (strstr(h, "Temp Aire")) col[COL_AIR_T] = i;
+		else if (strstr(h, "Hum Aire")) col[COL_AIR_H] = i;
+		else if (strstr(h, "Temp Suelo")) col[COL_SOIL_T] = i;
+		else if (strstr(h, "Hum Suelo")) col[COL_SOIL_H] = i;
+	}
+}
+
+static const char *field(char *fields[], int nf, int idx) {
+	return (idx >= 0 && idx < nf && fields[idx][0]) ? fields[idx] : NULL;
+}
+
+static double number(const char *f) {
+	return f ? atof(f) : 0.0;
+}
+
+static int sameSample(const BlockSample_t *a, const BlockSample_t *b) {
+	return a->timestamp == b->timestamp && a->irradiance_dWm2 == b->irradiance_dWm2 &&
+		   a->batteryVoltage_mV == b->batteryVoltage_mV && a->airTemp_cC == b->airTemp_cC &&
+		   a->soilTemp_cC == b->soilTemp_cC && a->airHumidity_perc == b->airHumidity_perc &&
+		   a->soilMoisture_perc == b->soilMoisture_perc;
+}
+
+static size_t loadCsv(const char *path, BlockSample_t **out) {
+	FILE *f = fopen(path, "r");
+	if (!f) return 0;
+
+	char line[LINE_LEN];
+	char *fields[MAX_COLS];
+	int col[COL_COUNT];
+
+	if (!fgets(line, sizeof(line), f)) {
+		fclose(f);
+		return 0;
+	}
+	mapColumns(fields, splitFields(line, fields), col);
+
+	size_t cap = 1024, n = 0;
+	BlockSample_t *s = malloc(cap * sizeof(*s));
+
+	// Sin fecha: se parte de la fecha del primer log del equipo y se acumulan los días
+	uint32_t base = civilToEpoch(2026, 1, 8, 0, 0, 0);
+	uint32_t lastTod = 0;
+
+	while (fgets(line, sizeof(line), f)) {
+		int nf = splitFields(line, fields);
+		if (nf < 2) continue;
+
+		if (n == cap) {
+			cap *= 2;
+			s = realloc(s, cap * sizeof(*s));
+		}
+
+		BlockSample_t *r = &s[n];
+		const char *f[COL_COUNT];
+		int d, mo, y, hh, mm, ss;
+
+		for (int c = 0; c < COL_COUNT; ++c) f[c] = field(fields, nf, col[c]);
+
+		if (f[COL_DATE] && f[COL_TIME] &&
+			sscanf(f[COL_DATE], "%d/%d/%d", &d, &mo, &y) == 3 &&
+			sscanf(f[COL_TIME], "%d:%d:%d", &hh, &mm, &ss) == 3) {
+			r->timestamp = civilToEpoch(y, mo, d, hh, mm, ss);
+		}
+		else if (f[COL_TIME] && sscanf(f[COL_TIME], "%d:%d:%d", &hh, &mm, &ss) == 3) {
+			uint32_t tod = hh * 3600u + mm * 60u + ss;
+			if (n > 0 && tod < lastTod) base += 86400u;
+			lastTod = tod;
+			r->timestamp = base + tod;
+		}
+		else r->timestamp = base + (uint32_t)n * DEFAULT_PERIOD_S;
+
+		r->batteryVoltage_mV = f[COL_BATT] ? toU16(number(f[COL_BATT]), 1000.0) : U16_INVALID;
+		r->irradiance_dWm2 = f[COL_IRR] ? toU16(number(f[COL_IRR]), 10.0) : U16_INVALID;
+		r->airTemp_cC = f[COL_AIR_T] ? toTemp(number(f[COL_AIR_T])) : TEMP_INVALID;
+		r->soilTemp_cC = f[COL_SOIL_T] ? toTemp(number(f[COL_SOIL_T])) : TEMP_INVALID;
+		r->airHumidity_perc = f[COL_AIR_H] ? toU8(number(f[COL_AIR_H])) : U8_INVALID;
+		r->soilMoisture_perc = f[COL_SOIL_H] ? toU8(number(f[COL_SOIL_H])) : U8_INVALID;
+		n++;
+	}
+
+	fclose(f);
+	*out = s;
+	return n;
+}
+
+// Codifica todas las muestras; devuelve el número de bloques usados
+static size_t encodeAll(const BlockSample_t *s, size_t n, FramBlockImage_t *blocks) {
+	FramBlock_t blk;
+	size_t nb = 0;
+
+	FRAM_BlockBegin(&blk, 0, 0, 0);
+	for (size_t i = 0; i < n; ++i) {
+		if (!FRAM_BlockAppend(&blk, &s[i])) {
+			FRAM_BlockSeal(&blk);
+			blocks[nb++] = blk.img;
+			FRAM_BlockBegin(&blk, (uint32_t)nb, (uint32_t)i, 0);
+			FRAM_BlockAppend(&blk, &s[i]);
+		}
+	}
+	if (blk.img.count > 0) {
+		FRAM_BlockSeal(&blk);
+		blocks[nb++] = blk.img;
+	}
+	return nb;
+}
+
+static size_t decodeAll(const FramBlockImage_t *blocks, size_t nb, BlockSample_t *out) {
+	FramBlock_t dec;
+	size_t n = 0;
+
+	for (size_t b = 0; b < nb; ++b) {
+		FRAM_BlockDecodeBegin(&dec, &blocks[b]);
+		while (FRAM_BlockDecodeNext(&dec, &out[n])) n++;
+	}
+	return n;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Uso: %s fichero.csv [...]\n", argv[0]);
+		return 1;
+	}
+
+	FRAM_CrcInit();
+
+	printf("%-28s %8s %9s %9s %9s %7s %12s %10s %10s %s\n", "Fichero", "Muestras", "v1 (B)", "v2 (B)",
+		   "Bloq (B)", "x v1", "Muestras/FRAM", "Cod (ns)", "Dec (ns)", "Ida/vuelta");
+
+	for (int a = 1; a < argc; ++a) {
+		BlockSample_t *s = NULL;
+		size_t n = loadCsv(argv[a], &s);
+		if (n == 0) {
+			fprintf(stderr, "%s: sin muestras\n", argv[a]);
+			free(s);
+			continue;
+		}
+
+		// Peor caso: una muestra por bloque
+		FramBlockImage_t *blocks = malloc(n * sizeof(*blocks));
+		BlockSample_t *back = malloc(n * sizeof(*back));
+
+		size_t nb = 0;
+		double t0 = nowSeconds();
+		for (int r = 0; r < ROUNDS; ++r) nb = encodeAll(s, n, blocks);
+		double enc = (nowSeconds() - t0) / ROUNDS / n * 1e9;
+
+		size_t nd = 0;
+		t0 = nowSeconds();
+		for (int r = 0; r < ROUNDS; ++r) nd = decodeAll(blocks, nb, back);
+		double dec = (nowSeconds() - t0) / ROUNDS / n * 1e9;
+
+		int ok = (nd == n);
+		for (size_t i = 0; i < n && ok; ++i) ok = sameSample(&s[i], &back[i]);
+		// CRC de cada bloque tal y como quedaría tras el commit
+		for (size_t b = 0; b < nb && ok; ++b) {
+			blocks[b].commit = FRAM_BLOCK_COMMIT_VALUE;
+			ok = FRAM_BlockIsValid(&blocks[b], 0);
+		}
+
+		// Capacidad: muestras medias por bloque x bloques del anillo
+		double perBlock = (double)n / nb;
+		double capacity = perBlock * SLOTS_BLOCK;
+
+		const char *name = strrchr(argv[a], '/');
+		name = name ? name + 1 : argv[a];
+
+		printf("%-28s %8zu %9zu %9zu %9zu %7.1f %12.0f %10.1f %10.1f %s\n", name, n, n * 32, n * 16,
+			   nb * FRAM_BLOCK_SIZE, capacity / SLOTS_V1, capacity, enc, dec, ok ? "OK" : "ERROR");
+
+		free(blocks);
+		free(back);
+		free(s);
+	}
+
+	printf("\nCapacidad: v1 %d muestras, v2 %d muestras, bloques %d x %d B\n", SLOTS_V1, SLOTS_V2, SLOTS_BLOCK, FRAM_BLOCK_SIZE);
+	return 0;
+}
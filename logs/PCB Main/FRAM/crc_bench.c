@@ -0,0 +1,85 @@
+/*
+ * crc_bench.c
+ *
+ * Microbenchmark en host de los motores CRC de la FRAM sobre una imagen de 32 KB.
+ * El periférico CRC solo existe en el STM32WB: su medida se obtiene en placa con
+ * FRAM_CrcBenchmark(), que el firmware imprime al arrancar si se compila con
+ * DDEBUG (app.c). Hasta tener esa medida FRAM_Init usa las tablas.
+ *
+ * Uso:
+ *   gcc -O2 -I../../../firmware/stm32_lanza_firmware/FRAM crc_bench.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_crc.c -o crc_bench
+ *   ./crc_bench [imagen.bin]
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fram_crc.h"
+
+#define IMAGE_SIZE		32768
+#define SLOT_SIZE		32
+#define FRAME_CRC_LEN	24
+#define ROUNDS			200
+
+static double nowSeconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double bench(uint16_t (*fn)(uint16_t, const uint8_t *, size_t), const uint8_t *img, uint32_t *acc) {
+	double t0 = nowSeconds();
+	for (int r = 0; r < ROUNDS; ++r) {
+		for (uint32_t off = 0; off < IMAGE_SIZE; off += SLOT_SIZE) {
+			*acc += fn(FRAM_CRC_INIT, &img[off], FRAME_CRC_LEN);
+		}
+	}
+	return (nowSeconds() - t0) / ROUNDS;
+}
+
+int main(int argc, char **argv) {
+	static uint8_t img[IMAGE_SIZE];
+
+	if (argc > 1) {
+		FILE *f = fopen(argv[1], "rb");
+		if (!f) { perror(argv[1]); return 1; }
+		size_t n = fread(img, 1, sizeof(img), f);
+		fclose(f);
+		printf("Imagen: %s (%zu bytes)\n", argv[1], n);
+	} else {
+		srand(1234);
+		for (size_t i = 0; i < sizeof(img); ++i) img[i] = (uint8_t)rand();
+		printf("Imagen: aleatoria (%d bytes)\n", IMAGE_SIZE);
+	}
+
+	// Valor de comprobación de CRC-16/CCITT-FALSE
+	const uint8_t check[] = "123456789";
+	if (FRAM_Crc16Bitwise(FRAM_CRC_INIT, check, 9) != 0x29B1 || FRAM_Crc16Table(FRAM_CRC_INIT, check, 9) != 0x29B1) {
+		printf("ERROR: valor de comprobación distinto de 0x29B1\n");
+		return 1;
+	}
+
+	for (uint32_t off = 0; off < IMAGE_SIZE; off += SLOT_SIZE) {
+		if (FRAM_Crc16Bitwise(FRAM_CRC_INIT, &img[off], FRAME_CRC_LEN) != FRAM_Crc16Table(FRAM_CRC_INIT, &img[off], FRAME_CRC_LEN)) {
+			printf("ERROR: discrepancia en el offset 0x%04X\n", off);
+			return 1;
+		}
+	}
+
+	uint32_t acc = 0;
+	double tBit = bench(FRAM_Crc16Bitwise, img, &acc);
+	double tTab = bench(FRAM_Crc16Table, img, &acc);
+
+	printf("%-10s %12s %10s\n", "Motor", "us/imagen", "MB/s");
+	printf("%-10s %12.1f %10.1f\n", "bitwise", tBit * 1e6, IMAGE_SIZE / tBit / 1e6);
+	printf("%-10s %12.1f %10.1f\n", "table", tTab * 1e6, IMAGE_SIZE / tTab / 1e6);
+	printf("%-10s %12s %10s\n", "hardware", "en placa", "-");
+	printf("Speedup table/bitwise: %.1fx (acc=%08X)\n", tBit / tTab, acc);
+
+	return 0;
+}
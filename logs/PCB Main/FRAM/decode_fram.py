@@ -0,0 +1,503 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import argparse
+import csv
+import struct
+import sys
+from datetime import datetime, timezone
+
+FRAM_SIZE = 32768
+DATA_START = 0x0020
+META_A, META_B = 0x0010, 0x0018
+
+SLOT_V1, SLOT_V2 = 32, 16
+SLOTS_V1 = FRAM_SIZE // SLOT_V1 - 1
+SLOTS_V2 = (FRAM_SIZE - DATA_START) // SLOT_V2
+
+BLOCK_SIZE, BLOCK_HEADER = 128, 13
+STAGE_A, STAGE_B = DATA_START, DATA_START + BLOCK_SIZE
+BLOCK_RING = DATA_START + 2 * BLOCK_SIZE
+SLOTS_BLOCK = (FRAM_SIZE - BLOCK_RING) // BLOCK_SIZE
+BLOCK_COMMIT = 0x5A
+BLOCK_RAW_BITS = (32, 16, 16, 16, 16, 8, 8)
+
+# FRAM particionada: muestras hasta 0x4000, agregados por hora y por día, eventos, registros clave-valor
+GEN_FORMAT_TIERS = 0x80
+TIER_RAW_END = 0x4000
+TIERS = {"hourly": (0x4000, 96, 3600), "daily": (0x6000, 112, 86400)}
+EVENT_START, EVENT_SLOTS, EVENT_RECORD, EVENT_COMMIT = 0x5800, 128, 16, 0xE1
+EVENT_NAMES = {1: "reset", 2: "aem", 3: "ina_alert", 4: "sensor_error", 5: "power", 6: "queue_drop", 7: "period", 8: "job", 9: "survival", 10: "energy"}
+SENSOR_NAMES = ("INA3221", "TSL2591", "SHT3x", "DFR0198", "SEN0308", "RTC", "FRAM")
+INA_PINS = {1: "PV", 2: "CRI", 4: "WAR"}
+JOB_NAMES = {0: "dump", 1: "scrub", 2: "ina_capture"}
+KV_START, KV_KEYS, KV_RECORD, KV_COMMIT = 0x7C00, 16, 32, 0x4B
+KV_CURSOR, CURSOR_MAX = 4, 8
+KV_NAMES = {0: "device", 1: "config", 2: "energy", 3: "errors", 12: "charge", 13: "energy_day"}
+KV_CONFIG, KV_ENERGY, KV_CHARGE, KV_ENERGY_DAY = 1, 2, 12, 13
+AGG_SIZE, AGG_COMMIT = 64, 0xC3
+AGG_CHANNELS = ("Irradiancia (dW/m2)", "Bateria (mV)", "Temp Aire (cC)", "Temp Suelo (cC)", "Hum Aire (%)", "Hum Suelo (%)")
+AGG_SIGNED = (False, False, True, True, False, False)
+
+FRAME_COMMIT = 0x3C
+META_COMMIT = 0xA5
+GEN_COMMIT = 0x96
+
+V2_MARK, V2_LAP, V2_GEN_MASK = 0x80, 0x40, 0x3F
+V2_TEMP_INVALID, V2_U16_INVALID, V2_U8_INVALID = -32768, 0xFFFF, 0xFF
+
+FORMAT_V1, FORMAT_V2, FORMAT_BLOCK = 1, 2, 3
+
+HEADER = ["Ciclo", "Fecha", "Hora", "Slot Memoria", "Slot Valido", "Bateria (V)", "Irradiancia (W/m2)",
+          "Temp Aire (C)", "Hum Aire (%)", "Temp Suelo (C)", "Hum Suelo (%)", "Secuencia", "Formato"]
+
+
+def crc16(data: bytes, crc: int = 0xFFFF) -> int:
+    """CRC-16/CCITT-FALSE, igual que FRAM_Crc16/FRAM_Crc16Update."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def seq_newer(a: int, b: int) -> bool:
+    return ((a - b) & 0xFF) < 128
+
+
+def read_gen(img: bytes):
+    """Registro de generación A/B (FRAM_LAYOUT_SEQ). Devuelve dict o None."""
+    best = None
+    for addr in (META_A, META_B):
+        raw = img[addr:addr + 8]
+        gen, seq, crc, commit, fmt, lap = struct.unpack("<BBHBBH", raw)
+        tiers = bool(fmt & GEN_FORMAT_TIERS)
+        fmt &= ~GEN_FORMAT_TIERS
+        if commit != GEN_COMMIT or fmt not in (FORMAT_V1, FORMAT_V2, FORMAT_BLOCK):
+            continue
+        if crc != crc16(raw[5:8], crc16(raw[0:2])):
+            continue
+        rec = dict(gen=gen, seq=seq, format=fmt, lap=lap, tiers=tiers)
+        if best is None or seq_newer(seq, best["seq"]):
+            best = rec
+    return best
+
+
+def read_meta(img: bytes):
+    """Cabeceras meta A/B (FRAM_LAYOUT_META). Devuelve dict o None."""
+    best = None
+    for addr in (META_A, META_B):
+        raw = img[addr:addr + 8]
+        write_idx, count, crc, seq, commit = struct.unpack("<HHHBB", raw)
+        if commit != META_COMMIT or write_idx >= SLOTS_V1 or count > SLOTS_V1:
+            continue
+        if crc != crc16(raw[0:4]):
+            continue
+        rec = dict(write_idx=write_idx, count=count, seq=seq)
+        if best is None or seq_newer(seq, best["seq"]):
+            best = rec
+    return best
+
+
+def decode_v1(img: bytes, slot: int, layout_seq: bool, gen: int, slots: int = SLOTS_V1):
+    """DataFrame_t de 32 bytes. Devuelve (valido, etiqueta de vuelta, muestra)."""
+    raw = img[DATA_START + slot * SLOT_V1:DATA_START + (slot + 1) * SLOT_V1]
+    irr, air, soil, hum, moist, mv, hh, mm, ss, dd, mo, yy, _vv = struct.unpack("<fffBBHBBBBBBH", raw[:24])
+    crc, commit, fgen, seq = struct.unpack("<HBBI", raw[24:])
+
+    crc_calc = crc16(raw[:24])
+    if layout_seq:
+        crc_calc = crc16(raw[27:], crc_calc)
+
+    valid = commit == FRAME_COMMIT and crc == crc_calc
+    if layout_seq:
+        valid = valid and fgen == gen and seq % slots == slot
+
+    sample = dict(date=f"{dd:02d}/{mo:02d}/20{yy:02d}", time=f"{hh:02d}:{mm:02d}:{ss:02d}",
+                  batt=mv / 1000.0, irr=irr, air=air, hum=hum, soil=soil, moist=moist)
+    return valid, seq // slots, sample
+
+
+def sample_v2(ts, irr, mv, air, soil, hum, moist):
+    """Muestra con las unidades y valores no válidos de SampleV2_t."""
+    date = time = ""
+    if ts:
+        dt = datetime.fromtimestamp(ts, tz=timezone.utc)
+        date, time = dt.strftime("%d/%m/%Y"), dt.strftime("%H:%M:%S")
+
+    sample = dict(date=date, time=time,
+                  batt=None if mv == V2_U16_INVALID else mv / 1000.0,
+                  irr=None if irr == V2_U16_INVALID else irr / 10.0,
+                  air=None if air == V2_TEMP_INVALID else air / 100.0,
+                  hum=None if hum == V2_U8_INVALID else hum,
+                  soil=None if soil == V2_TEMP_INVALID else soil / 100.0,
+                  moist=None if moist == V2_U8_INVALID else moist)
+    return sample
+
+
+def decode_v2(img: bytes, slot: int, gen: int):
+    """SampleV2_t de 16 bytes. Devuelve (valido, paridad de vuelta, muestra)."""
+    raw = img[DATA_START + slot * SLOT_V2:DATA_START + (slot + 1) * SLOT_V2]
+    commit, crc, irr, mv, air, soil, hum, moist, ts = struct.unpack("<BBHHhhBBI", raw)
+
+    valid = bool(commit & V2_MARK) and (commit & V2_GEN_MASK) == (gen & V2_GEN_MASK) and \
+        crc == (crc16(raw[2:]) & 0xFF)
+
+    return valid, 1 if commit & V2_LAP else 0, sample_v2(ts, irr, mv, air, soil, hum, moist)
+
+
+def read_block(img: bytes, addr: int, gen: int):
+    """Cabecera de un bloque comprimido. Devuelve dict (con el payload) o None si no es válido."""
+    raw = img[addr:addr + BLOCK_SIZE]
+    commit, count, crc, block_seq, first_seq, bgen = struct.unpack("<BBHIIB", raw[:BLOCK_HEADER])
+    if commit != BLOCK_COMMIT or count == 0 or bgen != gen or crc != crc16(raw[4:], crc16(raw[1:2])):
+        return None
+    return dict(count=count, block_seq=block_seq, first_seq=first_seq, payload=raw[BLOCK_HEADER:])
+
+
+def decode_block(payload: bytes, count: int):
+    """Misma decodificación que FRAM_BlockDecodeNext(): muestras en el orden de SampleV2_t."""
+    bits = int.from_bytes(payload, "big")
+    total = len(payload) * 8
+    pos = 0
+
+    def get(n):
+        nonlocal pos
+        if pos + n > total:
+            raise EOFError
+        pos += n
+        return (bits >> (total - pos)) & ((1 << n) - 1)
+
+    def code():
+        for width in (0, 4, 8, 16):
+            if not get(1):
+                zz = get(width) if width else 0
+                break
+        else:
+            zz = get(32)
+        return (zz >> 1) ^ -(zz & 1)
+
+    out, prev, prev_delta = [], None, 0
+    for i in range(count):
+        # Carga útil agotada antes de count: se detiene como el firmware
+        try:
+            if i == 0:
+                ch = [get(w) for w in BLOCK_RAW_BITS]
+                ch[3] = ch[3] - 0x10000 if ch[3] & 0x8000 else ch[3]
+                ch[4] = ch[4] - 0x10000 if ch[4] & 0x8000 else ch[4]
+                delta = 0
+            else:
+                delta = code() + prev_delta
+                ch = [(prev[0] + delta) & 0xFFFFFFFF] + [prev[c] + code() for c in range(1, 7)]
+        except EOFError:
+            break
+        prev, prev_delta = ch, delta
+        ts, irr, mv, air, soil, hum, moist = ch
+        out.append(sample_v2(ts, irr, mv, air, soil, hum, moist))
+    return out
+
+
+def recover_blocks(img: bytes, gen: int, slots: int = SLOTS_BLOCK):
+    """Misma recuperación que blockRecover() en fram.c. Devuelve lista de (secuencia, slot, muestra)."""
+    def read(k):
+        b = read_block(img, BLOCK_RING + k * BLOCK_SIZE, gen)
+        ok = b is not None and b["block_seq"] % slots == k
+        return ok, (b["block_seq"] // slots if ok else 0), b
+
+    next_block, blocks = recover_seq(slots, read, 0, FORMAT_BLOCK)
+    end_seq = 0
+    ring = []
+    for k in range(next_block - blocks, next_block):
+        b = read(k % slots)[2]
+        ring.append((k % slots, b))
+        end_seq = b["first_seq"] + b["count"]
+
+    # Bloque abierto: la copia A/B más completa que sigue al último bloque cerrado
+    stage = None
+    for addr in (STAGE_A, STAGE_B):
+        b = read_block(img, addr, gen)
+        if b and b["block_seq"] == next_block and b["first_seq"] == end_seq and \
+                (stage is None or b["count"] > stage["count"]):
+            stage = b
+    if stage:
+        ring.append(("A/B", stage))
+
+    out = []
+    for slot, b in ring:
+        for i, s in enumerate(decode_block(b["payload"], b["count"])):
+            out.append((b["first_seq"] + i, slot, s))
+    return out
+
+
+def recover_seq(slots: int, read, lap_hdr: int, fmt: int):
+    """Misma recuperación que FRAM_SeqRecover() en fram_seq.c, con recorrido lineal."""
+    def lap_from_tag(tag):
+        if fmt != FORMAT_V2:
+            return tag
+        return lap_hdr if (lap_hdr & 1) == tag else lap_hdr + 1
+
+    valid0, tag0, _ = read(0)
+    if valid0:
+        head = 0
+        for k in range(1, slots):
+            v, t, _ = read(k)
+            if not (v and t == tag0):
+                break
+            head = k
+        last = lap_from_tag(tag0) * slots + head
+    else:
+        v, t, _ = read(slots - 1)
+        if not v:
+            return 0, 0
+        last = lap_from_tag(t) * slots + slots - 1
+
+    next_seq = last + 1
+    count = min(next_seq, slots)
+    if count == slots and not read(next_seq % slots)[0]:
+        count -= 1
+    return next_seq, count
+
+
+def read_tier(img: bytes, name: str, gen: int):
+    """Registros cerrados de un anillo de agregados, del más antiguo al más reciente."""
+    start, slots, span = TIERS[name]
+
+    def read(k):
+        raw = img[start + k * AGG_SIZE:start + (k + 1) * AGG_SIZE]
+        commit, rgen, crc, seq, t0, samples = struct.unpack("<BBHIII", raw[:16])
+        ok = commit == AGG_COMMIT and rgen == gen and crc == crc16(raw[4:]) and seq % slots == k
+        rec = None
+        if ok:
+            ch = []
+            for c in range(len(AGG_CHANNELS)):
+                mn, mx, mean, cnt = struct.unpack("<HHHH", raw[16 + 8 * c:24 + 8 * c])
+                if AGG_SIGNED[c]:
+                    mn, mx, mean = [v - 0x10000 if v & 0x8000 else v for v in (mn, mx, mean)]
+                ch.append((mn, mx, mean, cnt))
+            rec = dict(seq=seq, start=t0, span=span, samples=samples, ch=ch)
+        return ok, (seq // slots if ok else 0), rec
+
+    next_seq, count = recover_seq(slots, read, 0, FORMAT_V1)
+    recs = [read(k % slots)[2] for k in range(next_seq - count, next_seq)]
+    return [r for r in recs if r is not None]
+
+
+def read_kv(img: bytes):
+    """Registros clave-valor A/B (FRAM particionada): {clave: valor} de las claves con valor."""
+    kv = {}
+    for key in range(KV_KEYS):
+        best = None
+        for k in range(2):
+            addr = KV_START + (2 * key + k) * KV_RECORD
+            raw = img[addr:addr + KV_RECORD]
+            commit, seq, crc, rkey, length = struct.unpack("<BBHBB", raw[:6])
+            if commit != KV_COMMIT or rkey != key or length > KV_RECORD - 8:
+                continue
+            if crc != crc16(raw[4:], crc16(bytes([seq]))):
+                continue
+            if best is None or seq_newer(seq, best[0]):
+                best = (seq, raw[8:8 + length])
+        if best is not None and best[1]:
+            kv[key] = best[1]
+    return kv
+
+
+def read_events(img: bytes):
+    """Registro de eventos (FRAM particionada), del más antiguo al más reciente."""
+    def read(k):
+        raw = img[EVENT_START + k * EVENT_RECORD:EVENT_START + (k + 1) * EVENT_RECORD]
+        commit, code, crc, seq, ts, arg = struct.unpack("<BBHIII", raw)
+        ok = commit == EVENT_COMMIT and seq % EVENT_SLOTS == k and crc == crc16(raw[4:], crc16(bytes([code])))
+        return ok, (seq // EVENT_SLOTS if ok else 0), dict(seq=seq, code=code, ts=ts, arg=arg) if ok else None
+
+    next_seq, count = recover_seq(EVENT_SLOTS, read, 0, FORMAT_V1)
+    evts = [read(k % EVENT_SLOTS)[2] for k in range(next_seq - count, next_seq)]
+    return [e for e in evts if e is not None]
+
+
+def event_describe(code: int, arg: int) -> str:
+    if code == 1:
+        return f"RCC_CSR=0x{arg:08X}"
+    if code == 2:
+        return f"S2..S0={arg & 7:03b} +{arg >> 16} ms"
+    if code == 3:
+        return f"{INA_PINS.get(arg & 0xFFFF, f'pin 0x{arg & 0xFFFF:04X}')} +{arg >> 16} ms"
+    if code == 4:
+        return SENSOR_NAMES[arg] if arg < len(SENSOR_NAMES) else f"sensor {arg}"
+    if code == 5:
+        return f"{arg} mV"
+    if code == 6:
+        return f"{arg} perdidos"
+    if code == 7:
+        return f"{arg & 0xFFFF} s, nivel {arg >> 16}"
+    if code == 8:
+        return f"{JOB_NAMES.get(arg & 0xFFFF, f'tarea {arg & 0xFFFF}')} tras {arg >> 16} min"
+    if code == 9:
+        return f"{'entra' if arg & 1 else 'sale'}, {arg >> 16} mV"
+    if code == 10:
+        return f"cosechados {arg & 0xFFFF} mWh, consumidos {arg >> 16} mWh"
+    return f"0x{arg:08X}"
+
+
+def kv_describe(key: int, value: bytes, gen: int) -> str:
+    if key == 0 and len(value) == 8:
+        system_id, modified = struct.unpack("<II", value)
+        return f"system_id=0x{system_id:08X} modified_date={modified}"
+    if KV_CURSOR <= key < KV_CURSOR + CURSOR_MAX and len(value) == 12:
+        ack, cgen = struct.unpack("<IB", value[:5])
+        name = value[5:].split(b"\0")[0].decode("ascii", "replace")
+        return f"cursor '{name}' ack={ack if cgen == gen else 0}"
+    if key == KV_CONFIG and len(value) == 24:
+        v = struct.unpack("<12H", value)
+        return (f"battery_mV={list(v[0:4])} hysteresis={v[4]} mV period_s={list(v[5:10])} "
+                f"bat_critical={v[10]} mA load_critical={v[11]} mA")
+    if key == KV_ENERGY and len(value) == 24:
+        pv, bin_, bout, load, soc, ts = struct.unpack("<6I", value)
+        return (f"pv={pv / 1000:.1f} mWh bat_in={bin_ / 1000:.1f} mWh bat_out={bout / 1000:.1f} mWh "
+                f"load={load / 1000:.1f} mWh soc={soc / 1000:.1f} mAh epoch={ts}")
+    if key == KV_CHARGE and len(value) == 16:
+        pv, bin_, bout, load = struct.unpack("<4I", value)
+        return f"pv={pv / 1000:.1f} mAh bat_in={bin_ / 1000:.1f} mAh bat_out={bout / 1000:.1f} mAh load={load / 1000:.1f} mAh"
+    if key == KV_ENERGY_DAY and len(value) == 12:
+        day, pv, load = struct.unpack("<3I", value)
+        return f"day={day} ({day * 86400}) pv={pv / 1000:.1f} mWh load={load / 1000:.1f} mWh"
+    if len(value) == 4:
+        return f"{struct.unpack('<I', value)[0]}"
+    return value.hex()
+
+
+def write_tier(recs, out):
+    w = csv.writer(out)
+    head = ["Inicio", "Duracion (s)", "Muestras"]
+    for name in AGG_CHANNELS:
+        head += [f"{name} min", f"{name} max", f"{name} media", f"{name} n"]
+    w.writerow(head)
+    for r in recs:
+        dt = datetime.fromtimestamp(r["start"], tz=timezone.utc).strftime("%d/%m/%Y %H:%M")
+        row = [dt, r["span"], r["samples"]]
+        for mn, mx, mean, cnt in r["ch"]:
+            row += [mn, mx, mean, cnt] if cnt else ["", "", "", 0]
+        w.writerow(row)
+
+
+def fmt_num(v, nd=3):
+    return "" if v is None else f"{v:.{nd}f}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodifica una imagen binaria de la FRAM MB85RS256B (formatos v1, v2 y bloques).")
+    parser.add_argument("image", help="Imagen de 32 KB (volcado crudo de la FRAM)")
+    parser.add_argument("--out", default="", help="CSV de salida (por defecto, stdout)")
+    parser.add_argument("--all", action="store_true", help="Incluye también los slots no válidos")
+    parser.add_argument("--tier", choices=sorted(TIERS), help="Vuelca los agregados por hora o por día en lugar de las muestras")
+    parser.add_argument("--kv", action="store_true", help="Lista los registros clave-valor en lugar de las muestras")
+    parser.add_argument("--events", action="store_true", help="Vuelca el registro de eventos en lugar de las muestras")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        img = f.read()
+    if len(img) < FRAM_SIZE:
+        img = img + bytes(FRAM_SIZE - len(img))
+
+    gen = read_gen(img)
+    meta = read_meta(img) if gen is None else None
+    end = TIER_RAW_END if gen is not None and gen["tiers"] else FRAM_SIZE
+
+    if args.kv:
+        if gen is None or not gen["tiers"]:
+            sys.exit("La imagen no tiene registros clave-valor (FRAM sin particionar)")
+        for key, value in sorted(read_kv(img).items()):
+            name = KV_NAMES.get(key, f"cursor{key - KV_CURSOR}" if key < KV_CURSOR + CURSOR_MAX else f"user{key}")
+            print(f"{key:2d} {name:8s} {kv_describe(key, value, gen['gen'])}")
+        return
+
+    if args.events:
+        if gen is None or not gen["tiers"]:
+            sys.exit("La imagen no tiene registro de eventos (FRAM sin particionar)")
+        evts = read_events(img)
+        print(f"Registro de eventos: {len(evts)} eventos", file=sys.stderr)
+        out = open(args.out, "w", newline="") if args.out else sys.stdout
+        w = csv.writer(out)
+        w.writerow(["Secuencia", "Fecha", "Hora", "Evento", "Argumento", "Detalle"])
+        for e in evts:
+            dt = datetime.fromtimestamp(e["ts"], tz=timezone.utc) if e["ts"] else None
+            w.writerow([e["seq"], dt.strftime("%d/%m/%Y") if dt else "", dt.strftime("%H:%M:%S") if dt else "",
+                        EVENT_NAMES.get(e["code"], f"user{e['code']}"), e["arg"], event_describe(e["code"], e["arg"])])
+        if args.out:
+            out.close()
+            print(f"Guardado: {args.out}", file=sys.stderr)
+        return
+
+    if args.tier:
+        if gen is None or not gen["tiers"]:
+            sys.exit("La imagen no tiene agregados (FRAM sin particionar)")
+        recs = read_tier(img, args.tier, gen["gen"])
+        print(f"Agregados {args.tier}, generación {gen['gen']}: {len(recs)} registros", file=sys.stderr)
+        out = open(args.out, "w", newline="") if args.out else sys.stdout
+        write_tier(recs, out)
+        if args.out:
+            out.close()
+            print(f"Guardado: {args.out}", file=sys.stderr)
+        return
+
+    if gen is not None and gen["format"] == FORMAT_BLOCK:
+        samples = recover_blocks(img, gen["gen"], (end - BLOCK_RING) // BLOCK_SIZE)
+        print(f"Formato bloques, generación {gen['gen']}: {len(samples)} muestras", file=sys.stderr)
+
+        out = open(args.out, "w", newline="") if args.out else sys.stdout
+        w = csv.writer(out)
+        w.writerow(HEADER)
+        for i, (seq, slot, s) in enumerate(samples):
+            w.writerow([i, s["date"], s["time"], slot, 1, fmt_num(s["batt"]), fmt_num(s["irr"]),
+                        fmt_num(s["air"]), "" if s["hum"] is None else s["hum"],
+                        fmt_num(s["soil"]), "" if s["moist"] is None else s["moist"], seq, FORMAT_BLOCK])
+        if args.out:
+            out.close()
+            print(f"Guardado: {args.out}", file=sys.stderr)
+        return
+
+    if gen is not None:
+        fmt = gen["format"]
+        if fmt == FORMAT_V2:
+            slots = (end - DATA_START) // SLOT_V2
+            def read(k): return decode_v2(img, k, gen["gen"])
+        else:
+            slots = (end - DATA_START) // SLOT_V1
+            def read(k): return decode_v1(img, k, True, gen["gen"], slots)
+        next_seq, count = recover_seq(slots, read, gen["lap"], fmt)
+        write_idx = next_seq % slots
+        layout = f"seq, generación {gen['gen']}"
+    else:
+        fmt, slots = FORMAT_V1, SLOTS_V1
+        def read(k): return decode_v1(img, k, False, 0)
+        write_idx = meta["write_idx"] if meta else 0
+        count = meta["count"] if meta else 0
+        next_seq = None
+        layout = "meta A/B" if meta else "sin cabeceras"
+
+    print(f"Formato v{fmt}, anillo {layout}: {count} muestras de {slots} slots", file=sys.stderr)
+
+    out = open(args.out, "w", newline="") if args.out else sys.stdout
+    w = csv.writer(out)
+    w.writerow(HEADER)
+
+    for i in range(count):
+        slot = (write_idx + slots - count + i) % slots
+        valid, _, s = read(slot)
+        if not valid and not args.all:
+            continue
+        seq = "" if next_seq is None else next_seq - count + i
+        if valid:
+            w.writerow([i, s["date"], s["time"], slot, 1, fmt_num(s["batt"]), fmt_num(s["irr"]),
+                        fmt_num(s["air"]), "" if s["hum"] is None else s["hum"],
+                        fmt_num(s["soil"]), "" if s["moist"] is None else s["moist"], seq, fmt])
+        else:
+            w.writerow([i, "", "", slot, 0, "", "", "", "", "", "", seq, fmt])
+
+    if args.out:
+        out.close()
+        print(f"Guardado: {args.out}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,165 @@
+/*
+ * fram_host.c
+ *
+ * El anillo de la FRAM (fram.c) en el host sobre una imagen de 32 KB mapeada
+ * en memoria (fram_dev.c). Sirve para leer imágenes volcadas de los equipos
+ * con el mismo código que el firmware y para medir el anillo sin la placa.
+ *
+ *   dump  Abre la imagen como copia privada (no se modifica aunque FRAM_Init
+ *         tenga que recuperar o formatear) e imprime las muestras en CSV.
+ *   bench Crea o reutiliza la imagen, guarda N muestras sintéticas con
+ *         FRAM_SaveData y informa de muestras/s en el formato indicado.
+ *
+ * Uso:
+ *   gcc -O2 -I../../../firmware/stm32_lanza_firmware/FRAM fram_host.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_dev.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_crc.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_block.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_tier.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_kv.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_event.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_seq.c -o fram_host
+ *   ./fram_host dump fram.bin > fram.csv
+ *   ./fram_host bench /tmp/bench.bin v1|v2|block [muestras] [lote]
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fram.h"
+
+static double nowSeconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int dump(const char *path) {
+	FramDev_t dev;
+	FramFile_t file;
+	FramRing_t mem = {0};
+
+	if (FRAM_DevOpenFile(&dev, &file, path, FRAM_FILE_PRIVATE) != HAL_OK) {
+		fprintf(stderr, "%s: no se puede abrir la imagen (32 KB)\n", path);
+		return 1;
+	}
+
+	// El formato grabado en la cabecera manda sobre el preferido
+	mem.dev = &dev;
+	mem.layout = FRAM_LAYOUT_SEQ;
+	mem.format = FRAM_FORMAT_BLOCK;
+	mem.tiers = 1;
+
+	if (FRAM_Init(&mem) != HAL_OK) {
+		fprintf(stderr, "%s: FRAM_Init ha fallado\n", path);
+		FRAM_DevCloseFile(&dev);
+		return 1;
+	}
+
+	printf("seq,fecha,hora,irradiancia_Wm2,temp_aire_C,temp_suelo_C,hum_aire_perc,hum_suelo_perc,bateria_mV\n");
+
+	uint32_t oldest = (mem.next_seq > mem.count) ? mem.next_seq - mem.count : 0;
+	for (uint32_t seq = oldest; seq < mem.next_seq; ++seq) {
+		DataSample_t d;
+		uint8_t valid;
+
+		if (FRAM_GetSample(&mem, seq, &d, &valid) != HAL_OK || !valid) continue;
+
+		printf("%lu,%02u/%02u/%02u,%02u:%02u:%02u,%.1f,%.2f,%.2f,%u,%u,%u\n", (unsigned long)seq,
+			   d.day, d.month, d.year, d.hours, d.minutes, d.seconds,
+			   d.irradiance_Wm2, d.airTemp_C, d.soilTemp_C,
+			   d.airHumidity_perc, d.soilMoisture_perc, d.batteryVoltage_mV);
+	}
+
+	FRAM_DevCloseFile(&dev);
+	return 0;
+}
+
+static int bench(const char *path, const char *fmt, long n, int batch) {
+	FramDev_t dev;
+	FramFile_t file;
+	FramRing_t mem = {0};
+
+	FramFormat_t format;
+	if (strcmp(fmt, "v1") == 0) format = FRAM_FORMAT_V1;
+	else if (strcmp(fmt, "v2") == 0) format = FRAM_FORMAT_V2;
+	else if (strcmp(fmt, "block") == 0) format = FRAM_FORMAT_BLOCK;
+	else {
+		fprintf(stderr, "formato desconocido: %s\n", fmt);
+		return 1;
+	}
+
+	if (batch < 0 || batch > FRAM_STAGE_MAX) {
+		fprintf(stderr, "lote fuera de rango (0..%d)\n", FRAM_STAGE_MAX);
+		return 1;
+	}
+
+	if (FRAM_DevOpenFile(&dev, &file, path, FRAM_FILE_CREATE) != HAL_OK) {
+		fprintf(stderr, "%s: no se puede crear la imagen\n", path);
+		return 1;
+	}
+
+	mem.dev = &dev;
+	mem.layout = FRAM_LAYOUT_SEQ;
+	mem.format = format;
+	mem.tiers = 1;
+	mem.stage_batch = (uint8_t)batch;
+
+	if (FRAM_Init(&mem) != HAL_OK || FRAM_SetFormat(&mem, format) != HAL_OK) {
+		fprintf(stderr, "%s: FRAM_Init ha fallado\n", path);
+		FRAM_DevCloseFile(&dev);
+		return 1;
+	}
+
+	// Una muestra cada 1200 s desde el 1/1/2026, con valores que varían poco
+	struct tm tm = { .tm_year = 126, .tm_mon = 0, .tm_mday = 1 };
+	time_t t = timegm(&tm);
+
+	double t0 = nowSeconds();
+	for (long i = 0; i < n; ++i, t += 1200) {
+		struct tm *c = gmtime(&t);
+		DataSample_t d = {
+			.irradiance_Wm2 = (float)(i % 1000),
+			.airTemp_C = 20.0f + (float)(i % 50) / 10.0f,
+			.soilTemp_C = 15.0f + (float)(i % 30) / 10.0f,
+			.airHumidity_perc = (uint8_t)(40 + i % 20),
+			.soilMoisture_perc = (uint8_t)(30 + i % 10),
+			.batteryVoltage_mV = (uint16_t)(3700 + i % 100),
+			.hours = (uint8_t)c->tm_hour, .minutes = (uint8_t)c->tm_min, .seconds = (uint8_t)c->tm_sec,
+			.day = (uint8_t)c->tm_mday, .month = (uint8_t)(c->tm_mon + 1), .year = (uint8_t)(c->tm_year - 100)
+		};
+
+		if (FRAM_SaveData(&mem, &d) != HAL_OK) {
+			fprintf(stderr, "FRAM_SaveData ha fallado en la muestra %ld\n", i);
+			FRAM_DevCloseFile(&dev);
+			return 1;
+		}
+	}
+	FRAM_Flush(&mem);
+	double dt = nowSeconds() - t0;
+
+	printf("%s, lote %d: %ld muestras en %.3f s (%.0f muestras/s), next_seq %lu\n",
+		   fmt, batch, n, dt, n / dt, (unsigned long)mem.next_seq);
+
+	FRAM_DevCloseFile(&dev);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc >= 3 && strcmp(argv[1], "dump") == 0) return dump(argv[2]);
+
+	if (argc >= 4 && strcmp(argv[1], "bench") == 0) {
+		long n = (argc >= 5) ? atol(argv[4]) : 100000;
+		int batch = (argc >= 6) ? atoi(argv[5]) : 0;
+		return bench(argv[2], argv[3], n, batch);
+	}
+
+	fprintf(stderr, "uso: %s dump <imagen> | bench <imagen> v1|v2|block [muestras] [lote]\n", argv[0]);
+	return 1;
+}
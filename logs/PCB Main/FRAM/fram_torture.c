@@ -0,0 +1,443 @@
+/*
+ * fram_torture.c
+ *
+ * Prueba de cortes de alimentación del protocolo de commit de la FRAM (fram.c)
+ * en el host. Reproduce una secuencia de FRAM_SaveData sobre una FRAM simulada
+ * en RAM y, para cada llamada, corta la alimentación tras cada byte escrito
+ * (o cada N bytes). Tras el corte ejecuta FRAM_Init sobre la imagen y comprueba:
+ *
+ *   - FRAM_Init recupera sin error.
+ *   - next_seq queda entre el valor anterior y el posterior a la llamada.
+ *   - Ninguna muestra confirmada (next_seq antes de la llamada) se pierde,
+ *     salvo las que la propia llamada sobrescribe al dar la vuelta al anillo.
+ *   - Ninguna muestra válida difiere de la de la ejecución sin cortes (tramas
+ *     a medias nunca se dan por buenas).
+ *   - count cubre todas las muestras garantizadas y no supera el máximo.
+ *   - Tras recuperar, dos escrituras más y un nuevo FRAM_Init dejan next_seq
+ *     y las muestras donde deben (write_idx coherente).
+ *
+ * Se comprueban las muestras más recientes y las más antiguas (donde escribe
+ * el anillo); con -full se recorre todo el histórico en cada corte.
+ *
+ * Con -meta (solo v1, sin agregados) se prueba FRAM_LAYOUT_META: write_idx y
+ * count en las cabeceras A/B (metaWriteSafe) en lugar de la secuencia en cada
+ * trama. FRAM_Init reinicia ahí la secuencia (next_seq = count), así que la
+ * posición en el histórico se deduce de cuánto ha avanzado write_idx.
+ *
+ * Uso:
+ *   gcc -O2 -I../../../firmware/stm32_lanza_firmware/FRAM fram_torture.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_dev.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_crc.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_block.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_tier.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_kv.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_event.c \
+ *       ../../../firmware/stm32_lanza_firmware/FRAM/fram_seq.c -o fram_torture
+ *   ./fram_torture v1|v2|block [muestras] [lote] [paso] [-notiers] [-full] [-meta]
+ *
+ * Devuelve 0 si no hay fallos. Por defecto 1200 muestras (más de una vuelta
+ * en v1 y v2), lote 0 y un corte por byte.
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fram.h"
+
+#define T0					1767225600u		// 1/1/2026 00:00:00
+#define PERIOD_S			1200
+#define WINDOW				64				// Muestras comprobadas en cada extremo del histórico
+#define EXTRA_SAMPLES		2				// Escrituras tras la recuperación
+#define MAX_REPORTS			10
+
+// FRAM simulada: el corte deja escritos exactamente los primeros cut bytes de datos
+typedef struct {
+	uint8_t img[FRAM_SIZE];
+	long cut;					// Bytes hasta el corte (-1: sin corte)
+	long written;				// Bytes de datos escritos
+} SimFram_t;
+
+static HAL_StatusTypeDef simRead(void *ctx, uint16_t addr, uint8_t *data, size_t len) {
+	SimFram_t *sim = ctx;
+
+	if ((uint32_t)addr + len > FRAM_SIZE) return HAL_ERROR;
+
+	memcpy(data, &sim->img[addr], len);
+	return HAL_OK;
+}
+
+static HAL_StatusTypeDef simWritev(void *ctx, const FramSeg_t *seg, size_t n) {
+	SimFram_t *sim = ctx;
+
+	for (size_t i = 0; i < n; ++i) {
+		if ((uint32_t)seg[i].addr + seg[i].len > FRAM_SIZE) return HAL_ERROR;
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		size_t len = seg[i].len;
+
+		if (sim->cut >= 0 && (long)len > sim->cut - sim->written) {
+			len = (size_t)(sim->cut - sim->written);
+			memcpy(&sim->img[seg[i].addr], seg[i].data, len);
+			sim->written += (long)len;
+			return HAL_ERROR;
+		}
+
+		memcpy(&sim->img[seg[i].addr], seg[i].data, len);
+		sim->written += (long)len;
+	}
+
+	return HAL_OK;
+}
+
+static void simAttach(FramDev_t *dev, SimFram_t *sim) {
+	dev->init = NULL;
+	dev->read = simRead;
+	dev->writev = simWritev;
+	dev->size = FRAM_SIZE;
+	dev->ctx = sim;
+}
+
+static double nowSeconds(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Muestra i: cada canal cambia con i para que una trama cruzada no pase por buena
+static DataSample_t makeSample(uint32_t i) {
+	time_t t = (time_t)(T0 + (uint64_t)i * PERIOD_S);
+	struct tm *c = gmtime(&t);
+
+	DataSample_t d = {
+		.irradiance_Wm2 = (float)(i % 1200) + 0.5f,
+		.airTemp_C = -10.0f + (float)(i % 500) / 10.0f,
+		.soilTemp_C = 5.0f + (float)(i % 300) / 10.0f,
+		.airHumidity_perc = (uint8_t)(i % 101),
+		.soilMoisture_perc = (uint8_t)((i * 7) % 101),
+		.batteryVoltage_mV = (uint16_t)(3000 + i % 1200),
+		.hours = (uint8_t)c->tm_hour, .minutes = (uint8_t)c->tm_min, .seconds = (uint8_t)c->tm_sec,
+		.day = (uint8_t)c->tm_mday, .month = (uint8_t)(c->tm_mon + 1), .year = (uint8_t)(c->tm_year - 100)
+	};
+
+	return d;
+}
+
+typedef struct {
+	FramFormat_t format;
+	uint8_t tiers;
+	uint8_t full;
+	uint8_t meta;				// FRAM_LAYOUT_META
+	uint32_t base;				// Secuencia de la ejecución sin cortes menos la del anillo (FRAM_LAYOUT_META)
+	DataSample_t *ref;			// Muestra leída en la ejecución sin cortes, por secuencia
+	uint32_t refCount;
+	uint16_t maxCount;			// Máximo de count en la ejecución sin cortes
+	long failures;
+} Torture_t;
+
+static FramRing_t ringFor(const Torture_t *t, FramDev_t *dev) {
+	FramRing_t mem;
+
+	memset(&mem, 0, sizeof(mem));
+	mem.dev = dev;
+	mem.layout = t->meta ? FRAM_LAYOUT_META : FRAM_LAYOUT_SEQ;
+	mem.format = t->format;
+	mem.tiers = t->tiers;
+	return mem;
+}
+
+static void fail(Torture_t *t, uint32_t op, long cut, const char *what, uint32_t a, uint32_t b) {
+	if (t->failures++ < MAX_REPORTS) {
+		printf("FALLO llamada %lu corte %ld: %s (%lu, %lu)\n", (unsigned long)op, cut, what, (unsigned long)a, (unsigned long)b);
+	}
+}
+
+// 0: inválida, 1: igual a la referencia, -1: válida pero distinta
+static int checkSample(Torture_t *t, FramRing_t *mem, uint32_t seq) {
+	DataSample_t d;
+	uint8_t valid;
+
+	if (FRAM_GetSample(mem, seq - t->base, &d, &valid) != HAL_OK || !valid) return 0;
+	if (seq >= t->refCount) return -1;
+
+	return (memcmp(&d, &t->ref[seq], sizeof(d)) == 0) ? 1 : -1;
+}
+
+typedef struct {
+	Torture_t *t;
+	uint32_t from, to;
+	uint32_t bad;				// Primera muestra distinta (UINT32_MAX: ninguna)
+	uint8_t seen[2 * WINDOW];
+} RangeCheck_t;
+
+static void rangeSample(void *ctx, uint32_t seq, const DataSample_t *data, uint8_t valid) {
+	RangeCheck_t *rc = ctx;
+
+	if (!valid) return;
+	seq += rc->t->base;
+
+	if (seq < rc->from || seq >= rc->to || seq >= rc->t->refCount || memcmp(data, &rc->t->ref[seq], sizeof(*data)) != 0) {
+		if (rc->bad == UINT32_MAX) rc->bad = seq;
+		return;
+	}
+
+	rc->seen[seq - rc->from] = 1;
+}
+
+/*
+ * Recorre [from, to): todas válidas si required; en otro caso solo que no haya
+ * distintas. Cada muestra tiene su propia hora, así que una ventana se lee con
+ * FRAM_FindRange (los bloques se decodifican una vez); con -full, muestra a muestra.
+ */
+static void checkRange(Torture_t *t, FramRing_t *mem, uint32_t from, uint32_t to, uint8_t required, uint32_t op, long cut) {
+	if (t->full || to - from > 2 * WINDOW) {
+		for (uint32_t seq = from; seq < to; ++seq) {
+			int r = checkSample(t, mem, seq);
+
+			if (r < 0) fail(t, op, cut, "muestra válida distinta de la referencia", seq, mem->next_seq);
+			else if (r == 0 && required) fail(t, op, cut, "muestra confirmada perdida", seq, mem->next_seq);
+		}
+		return;
+	}
+
+	RangeCheck_t rc = { .t = t, .from = from, .to = to, .bad = UINT32_MAX };
+
+	if (FRAM_FindRange(mem, T0 + from * PERIOD_S, T0 + to * PERIOD_S, rangeSample, &rc) != HAL_OK) {
+		fail(t, op, cut, "FRAM_FindRange", from, to);
+		return;
+	}
+
+	if (rc.bad != UINT32_MAX) fail(t, op, cut, "muestra válida distinta de la referencia", rc.bad, mem->next_seq);
+
+	if (!required) return;
+
+	for (uint32_t seq = from; seq < to; ++seq) {
+		if (!rc.seen[seq - from]) {
+			fail(t, op, cut, "muestra confirmada perdida", seq, mem->next_seq);
+			return;
+		}
+	}
+}
+
+static void checkWindows(Torture_t *t, FramRing_t *mem, uint32_t from, uint32_t to, uint8_t required, uint32_t op, long cut) {
+	if (to <= from) return;
+
+	if (t->full || to - from <= 2 * WINDOW) {
+		checkRange(t, mem, from, to, required, op, cut);
+		return;
+	}
+
+	checkRange(t, mem, from, from + WINDOW, required, op, cut);
+	checkRange(t, mem, to - WINDOW, to, required, op, cut);
+}
+
+/*
+ * Estado tras un corte en la llamada op: prev* antes de la llamada, post*
+ * después de la llamada completa sin cortes.
+ */
+static void checkRecovered(Torture_t *t, SimFram_t *sim, uint32_t op, long cut, uint16_t prevIdx,
+						   uint32_t prevNext, uint16_t prevCount, uint32_t postNext, uint16_t postCount) {
+	FramDev_t dev;
+	simAttach(&dev, sim);
+	sim->cut = -1;
+
+	FramRing_t mem = ringFor(t, &dev);
+	if (FRAM_Init(&mem) != HAL_OK) {
+		fail(t, op, cut, "FRAM_Init", 0, 0);
+		return;
+	}
+
+	// Con cabeceras meta la secuencia se deduce del avance de write_idx (< un anillo por llamada)
+	uint32_t next = mem.next_seq;
+	if (t->meta) next = prevNext + (uint16_t)((mem.write_idx + mem.slots - prevIdx) % mem.slots);
+	t->base = next - mem.next_seq;
+
+	if (next < prevNext || next > postNext) {
+		fail(t, op, cut, "next_seq fuera de rango", next, prevNext);
+		return;
+	}
+
+	if (mem.format != t->format) fail(t, op, cut, "formato cambiado", mem.format, t->format);
+
+	// Garantizadas: las que había antes de la llamada y que la llamada no sobrescribe
+	uint32_t lo = prevNext - prevCount;
+	if (postNext - postCount > lo) lo = postNext - postCount;
+
+	if (mem.count > next || mem.count > t->maxCount) fail(t, op, cut, "count imposible", mem.count, next);
+	if (lo < next && next - mem.count > lo) fail(t, op, cut, "count no cubre el histórico", mem.count, next - lo);
+
+	uint32_t oldest = next - ((mem.count > next) ? next : mem.count);
+	checkWindows(t, &mem, (lo < next) ? lo : next, next, 1, op, cut);
+	checkWindows(t, &mem, oldest, (lo < next) ? lo : next, 0, op, cut);
+
+	// Seguir escribiendo sobre lo recuperado
+	mem.stage_batch = 0;
+	for (uint32_t i = 0; i < EXTRA_SAMPLES; ++i) {
+		DataSample_t d = makeSample(next + i);
+
+		if (FRAM_SaveData(&mem, &d) != HAL_OK) {
+			fail(t, op, cut, "FRAM_SaveData tras recuperar", next + i, 0);
+			return;
+		}
+	}
+
+	FramRing_t again = ringFor(t, &dev);
+	uint8_t same = (FRAM_Init(&again) == HAL_OK);
+	if (t->meta) same = same && again.write_idx == mem.write_idx && again.count == mem.count;
+	else same = same && again.next_seq == next + EXTRA_SAMPLES;
+
+	if (!same) {
+		fail(t, op, cut, "segundo FRAM_Init", again.next_seq, next + EXTRA_SAMPLES);
+		return;
+	}
+
+	t->base = next + EXTRA_SAMPLES - again.next_seq;
+
+	checkRange(t, &again, next, next + EXTRA_SAMPLES, 1, op, cut);
+}
+
+// Ejecución sin cortes: muestras de referencia tal y como se leen de la FRAM
+static int buildReference(Torture_t *t, uint32_t samples, uint8_t batch) {
+	static SimFram_t sim;
+	FramDev_t dev;
+
+	memset(&sim, 0, sizeof(sim));
+	sim.cut = -1;
+	simAttach(&dev, &sim);
+
+	FramRing_t mem = ringFor(t, &dev);
+	if (FRAM_Init(&mem) != HAL_OK || FRAM_SetFormat(&mem, t->format) != HAL_OK) return -1;
+	mem.stage_batch = batch;
+
+	t->refCount = samples + EXTRA_SAMPLES;
+	t->ref = calloc(t->refCount, sizeof(DataSample_t));
+	if (t->ref == NULL) return -1;
+
+	for (uint32_t i = 0; i < t->refCount; ++i) {
+		DataSample_t d = makeSample(i);
+		uint32_t prev = mem.next_seq;
+
+		if (FRAM_SaveData(&mem, &d) != HAL_OK) return -1;
+		if (i + 1 == t->refCount && FRAM_Flush(&mem) != HAL_OK) return -1;
+
+		for (uint32_t seq = prev; seq < mem.next_seq; ++seq) {
+			uint8_t valid;
+			if (FRAM_GetSample(&mem, seq, &t->ref[seq], &valid) != HAL_OK || !valid) return -1;
+		}
+
+		if (mem.count > t->maxCount) t->maxCount = mem.count;
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	static SimFram_t base, prev, work;
+	Torture_t t = {0};
+	uint32_t samples = 1200;
+	int batch = 0;
+	long step = 1;
+
+	if (argc < 2) {
+		fprintf(stderr, "uso: %s v1|v2|block [muestras] [lote] [paso] [-notiers] [-full] [-meta]\n", argv[0]);
+		return 2;
+	}
+
+	if (strcmp(argv[1], "v1") == 0) t.format = FRAM_FORMAT_V1;
+	else if (strcmp(argv[1], "v2") == 0) t.format = FRAM_FORMAT_V2;
+	else if (strcmp(argv[1], "block") == 0) t.format = FRAM_FORMAT_BLOCK;
+	else {
+		fprintf(stderr, "formato desconocido: %s\n", argv[1]);
+		return 2;
+	}
+
+	t.tiers = 1;
+	for (int a = 2, pos = 0; a < argc; ++a) {
+		if (strcmp(argv[a], "-notiers") == 0) t.tiers = 0;
+		else if (strcmp(argv[a], "-full") == 0) t.full = 1;
+		else if (strcmp(argv[a], "-meta") == 0) t.meta = 1;
+		else if (pos == 0 && ++pos) samples = (uint32_t)atol(argv[a]);
+		else if (pos == 1 && ++pos) batch = atoi(argv[a]);
+		else if (pos == 2 && ++pos) step = atol(argv[a]);
+	}
+
+	// Las cabeceras meta solo admiten v1 sin agregados
+	if (t.meta && t.format != FRAM_FORMAT_V1) {
+		fprintf(stderr, "-meta solo con v1\n");
+		return 2;
+	}
+	if (t.meta) t.tiers = 0;
+
+	if (samples == 0 || batch < 0 || batch > FRAM_STAGE_MAX || step < 1) {
+		fprintf(stderr, "parámetros fuera de rango (lote 0..%d, paso >= 1)\n", FRAM_STAGE_MAX);
+		return 2;
+	}
+
+	if (buildReference(&t, samples, (uint8_t)batch) != 0) {
+		fprintf(stderr, "la ejecución sin cortes ha fallado\n");
+		return 2;
+	}
+
+	// Imagen y estado en RAM antes de cada llamada; la llamada samples es el FRAM_Flush final
+	FramDev_t baseDev, workDev;
+	memset(&base, 0, sizeof(base));
+	base.cut = -1;
+	simAttach(&baseDev, &base);
+	simAttach(&workDev, &work);
+
+	FramRing_t mem = ringFor(&t, &baseDev);
+	FRAM_Init(&mem);
+	FRAM_SetFormat(&mem, t.format);
+	mem.stage_batch = (uint8_t)batch;
+
+	long cuts = 0;
+	double t0 = nowSeconds();
+
+	for (uint32_t op = 0; op <= samples; ++op) {
+		DataSample_t d = makeSample(op);
+		FramRing_t before = mem;
+		uint16_t prevIdx = mem.write_idx;
+		uint32_t prevNext = mem.next_seq;
+		uint16_t prevCount = mem.count;
+		memcpy(prev.img, base.img, FRAM_SIZE);
+
+		// Llamada completa: bytes escritos y estado final
+		base.written = 0;
+		HAL_StatusTypeDef status = (op < samples) ? FRAM_SaveData(&mem, &d) : FRAM_Flush(&mem);
+		if (status != HAL_OK) {
+			fprintf(stderr, "llamada %lu sin cortes ha fallado\n", (unsigned long)op);
+			return 2;
+		}
+
+		long bytes = base.written;
+		if (bytes == 0) continue;
+
+		// Misma llamada desde la imagen y el estado anteriores, cortada tras cut bytes
+		for (long cut = 0; cut < bytes; cut += step) {
+			memcpy(work.img, prev.img, FRAM_SIZE);
+			work.written = 0;
+			work.cut = cut;
+
+			FramRing_t cutMem = before;
+			cutMem.dev = &workDev;
+			if (op < samples) FRAM_SaveData(&cutMem, &d);
+			else FRAM_Flush(&cutMem);
+
+			checkRecovered(&t, &work, op, cut, prevIdx, prevNext, prevCount, mem.next_seq, mem.count);
+			cuts++;
+		}
+	}
+
+	double dt = nowSeconds() - t0;
+	printf("%s%s%s, lote %d: %lu muestras, %ld cortes en %.2f s (%.0f cortes/s), %ld fallos\n",
+		   argv[1], t.meta ? " meta" : "", (t.tiers || t.meta) ? "" : " sin agregados", batch, (unsigned long)samples, cuts, dt, cuts / dt, t.failures);
+
+	free(t.ref);
+	return (t.failures == 0) ? 0 : 1;
+}
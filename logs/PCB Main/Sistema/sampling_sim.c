@@ -0,0 +1,170 @@
+/*
+ * sampling_sim.c
+ *
+ * Reproduce un registro de campo (autonomia.csv) con la política de periodo
+ * de muestreo del firmware (sampling.c) y la compara con el periodo fijo con
+ * el que se tomó el registro. La tensión de batería y la irradiancia se
+ * interpolan del registro (bucle abierto: la batería no reacciona a la
+ * política), así que la ganancia sale del número de ciclos:
+ *
+ *   corriente media = reposo + carga por ciclo * ciclos / duración
+ *
+ * La relación entre corrientes medias es la ganancia de autonomía; escalando
+ * la caída de tensión del registro (tomado con su propio periodo) se estima
+ * el tiempo hasta Vovdis (3.6 V) con cada política. Los consumos por defecto son
+ * estimaciones, conviene sustituirlos por medidas de la placa: 10 uA en STOP2
+ * con el INA3221 apagado y 5 mAs por ciclo (~0.8 s con los sensores
+ * alimentados, dominado por la conversión de 12 bits del DS18B20).
+ *
+ * Uso:
+ *   gcc -O2 -I../../../firmware/stm32_lanza_firmware/Core/Inc sampling_sim.c \
+ *       ../../../firmware/stm32_lanza_firmware/Core/Src/sampling.c -o sampling_sim
+ *   ./sampling_sim autonomia.csv [-fixed s] [-sleep uA] [-cycle uAs] [-csv]
+ *
+ *  Created on: Jan 22, 2026
+ *      Author: pzaragoza
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sampling.h"
+
+#define MAX_ROWS		4096
+#define VOVDIS_MV		3600
+
+typedef struct {
+	time_t t;
+	double battery_mV;
+	double irradiance_Wm2;
+} Row_t;
+
+static Row_t rows[MAX_ROWS];
+static int nRows;
+
+// Ciclo,Fecha,Hora,Slot Memoria,Slot Valido,Bateria (V),Irradiancia (W/m2),...
+static int loadCsv(const char *path) {
+	FILE *f = fopen(path, "r");
+	char line[512];
+
+	if (!f) return -1;
+
+	while (fgets(line, sizeof(line), f) && nRows < MAX_ROWS) {
+		unsigned cyc, slot, valid, d, mo, y, h, mi, s;
+		double v, irr;
+
+		if (sscanf(line, "%u,%u/%u/%u,%u:%u:%u,%u,%u,%lf,%lf", &cyc, &d, &mo, &y, &h, &mi, &s, &slot, &valid, &v, &irr) != 11) continue;
+		if (!valid) continue;
+
+		struct tm tm = { .tm_year = (int)y - 1900, .tm_mon = (int)mo - 1, .tm_mday = (int)d,
+						 .tm_hour = (int)h, .tm_min = (int)mi, .tm_sec = (int)s };
+
+		rows[nRows].t = timegm(&tm);
+		rows[nRows].battery_mV = v * 1000.0;
+		rows[nRows].irradiance_Wm2 = irr;
+		nRows++;
+	}
+
+	fclose(f);
+	return nRows;
+}
+
+static void interpolate(time_t t, double *battery_mV, double *irradiance_Wm2) {
+	int i = 1;
+
+	while (i < nRows - 1 && rows[i].t < t) i++;
+
+	const Row_t *a = &rows[i - 1], *b = &rows[i];
+	double k = (b->t > a->t) ? (double)(t - a->t) / (double)(b->t - a->t) : 0.0;
+	if (k < 0.0) k = 0.0;
+	if (k > 1.0) k = 1.0;
+
+	*battery_mV = a->battery_mV + k * (b->battery_mV - a->battery_mV);
+	*irradiance_Wm2 = a->irradiance_Wm2 + k * (b->irradiance_Wm2 - a->irradiance_Wm2);
+}
+
+// El AEM10941 desconecta por debajo de Vovdis; por encima de él las LDO están activas
+static uint8_t aemStatus(double battery_mV) {
+	return (battery_mV < VOVDIS_MV) ? SAMPLING_AEM_BATT_LOW : SAMPLING_AEM_LDO_READY;
+}
+
+static long runAdaptive(int csv) {
+	SamplingPolicy_t policy;
+	long cycles = 0;
+
+	SAMPLING_Init(&policy, NULL);
+
+	if (csv) printf("Fecha,Hora,Bateria (V),Irradiancia (W/m2),Nivel,Periodo (s)\n");
+
+	for (time_t t = rows[0].t; t <= rows[nRows - 1].t; ++cycles) {
+		double v, irr;
+
+		interpolate(t, &v, &irr);
+		uint16_t period_s = SAMPLING_Update(&policy, (uint16_t)(v + 0.5), (float)irr, aemStatus(v));
+
+		if (csv) {
+			struct tm *c = gmtime(&t);
+			printf("%02d/%02d/%04d,%02d:%02d:%02d,%.3f,%.3f,%u,%u\n", c->tm_mday, c->tm_mon + 1, c->tm_year + 1900,
+				   c->tm_hour, c->tm_min, c->tm_sec, v / 1000.0, irr, policy.effective, period_s);
+		}
+
+		t += period_s;
+	}
+
+	return cycles;
+}
+
+int main(int argc, char **argv) {
+	double fixed_s = 1200, sleep_uA = 10, cycle_uAs = 5000;
+	int csv = 0;
+
+	if (argc < 2) {
+		fprintf(stderr, "uso: %s autonomia.csv [-fixed s] [-sleep uA] [-cycle uAs] [-csv]\n", argv[0]);
+		return 1;
+	}
+
+	for (int i = 2; i < argc; ++i) {
+		if (strcmp(argv[i], "-csv") == 0) csv = 1;
+		else if (i + 1 < argc && strcmp(argv[i], "-fixed") == 0) fixed_s = atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-sleep") == 0) sleep_uA = atof(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-cycle") == 0) cycle_uAs = atof(argv[++i]);
+		else {
+			fprintf(stderr, "opción desconocida: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (loadCsv(argv[1]) < 2) {
+		fprintf(stderr, "%s: se necesitan al menos dos filas válidas\n", argv[1]);
+		return 1;
+	}
+
+	double span_s = (double)(rows[nRows - 1].t - rows[0].t);
+	long adaptive = runAdaptive(csv);
+	long fixed = (long)(span_s / fixed_s) + 1;
+
+	double fixed_uA = sleep_uA + cycle_uAs * fixed / span_s;
+	double adaptive_uA = sleep_uA + cycle_uAs * adaptive / span_s;
+
+	// Caída de tensión del registro, tomado con su propio periodo
+	double drop_mV = rows[0].battery_mV - rows[nRows - 1].battery_mV;
+	double margin_mV = rows[nRows - 1].battery_mV - VOVDIS_MV;
+	double log_uA = sleep_uA + cycle_uAs * nRows / span_s;
+
+	FILE *out = csv ? stderr : stdout;
+	fprintf(out, "Registro: %d filas, %.1f h, %.3f -> %.3f V\n", nRows, span_s / 3600.0,
+			rows[0].battery_mV / 1000.0, rows[nRows - 1].battery_mV / 1000.0);
+	fprintf(out, "Periodo fijo %.0f s: %ld ciclos, %.1f uA de media\n", fixed_s, fixed, fixed_uA);
+	fprintf(out, "Política adaptativa: %ld ciclos, %.1f uA de media\n", adaptive, adaptive_uA);
+	fprintf(out, "Autonomía: x%.2f (%+.0f %%)\n", fixed_uA / adaptive_uA, (fixed_uA / adaptive_uA - 1.0) * 100.0);
+
+	if (drop_mV > 0.0) {
+		double log_h = margin_mV / (drop_mV / (span_s / 3600.0));
+		fprintf(out, "Hasta Vovdis al ritmo del registro: %.1f días fijo, %.1f días adaptativo\n",
+				log_h * log_uA / fixed_uA / 24.0, log_h * log_uA / adaptive_uA / 24.0);
+	}
+
+	return 0;
+}